@@ -15,6 +15,7 @@
 #include "configs/configdialog.h"
 #include "core/richtext/richdocument.h"
 #include "core/subtitleiterator.h"
+#include "core/subtitlejournal.h"
 #include "core/undo/undostack.h"
 #include "gui/currentlinewidget.h"
 #include "gui/subtitlemeta/subtitlemetawidget.h"
@@ -37,6 +38,8 @@
 #include "errors/errortracker.h"
 #include "formats/formatmanager.h"
 #include "formats/outputformat.h"
+#include "formats/subtitlereader.h"
+#include "formats/subtitlewriter.h"
 #include "formats/textdemux/textdemux.h"
 #include "helpers/commondefs.h"
 #include "gui/treeview/lineswidget.h"
@@ -67,12 +70,12 @@
 #include <QTextCodec>
 #include <QThread>
 #include <QUndoGroup>
-#include <QUndoStack>
 
 #include <KActionCollection>
 #include <KCharsets>
 #include <KComboBox>
 #include <KConfig>
+#include <KFormat>
 #include <KMessageBox>
 #include <KSelectAction>
 #include <KStandardShortcut>
@@ -181,6 +184,18 @@ Application::createMainWindow()
 	m_textDemux = new TextDemux(m_mainWindow);
 	statusBar->addPermanentWidget(m_textDemux->progressWidget());
 
+	m_subtitleReader = new SubtitleReader(m_mainWindow);
+	statusBar->addPermanentWidget(m_subtitleReader->progressWidget());
+	connect(m_subtitleReader, &SubtitleReader::linesRead, this, &Application::onSubtitleLinesRead);
+	connect(m_subtitleReader, &SubtitleReader::readRestarted, this, &Application::onSubtitleReadRestarted);
+	connect(m_subtitleReader, &QThread::finished, this, &Application::onSubtitleReaderFinished);
+
+	m_subtitleWriter = new SubtitleWriter(m_mainWindow);
+	statusBar->addPermanentWidget(m_subtitleWriter->progressWidget());
+	connect(m_subtitleWriter, &SubtitleWriter::written, this, &Application::onSubtitleWritten);
+
+	m_journal = new SubtitleJournal(this);
+
 	m_speechProcessor = new SpeechProcessor(m_mainWindow);
 	statusBar->addPermanentWidget(m_speechProcessor->progressWidget());
 
@@ -188,6 +203,13 @@ Application::createMainWindow()
 
 	AppGlobal::undoStack = new UndoStack(m_mainWindow);
 
+	m_labUndoMemory = new QLabel();
+	m_labUndoMemory->setToolTip(i18n("Memory used by undo history"));
+	statusBar->addPermanentWidget(m_labUndoMemory);
+	connect(appUndoStack(), &UndoStack::memoryUsageChanged, m_labUndoMemory, [this](quint64 bytes){
+		m_labUndoMemory->setText(i18n("Undo: %1 / %2", KFormat().formatByteSize(bytes), KFormat().formatByteSize(appUndoStack()->memoryLimit())));
+	});
+
 	UserActionManager *actionManager = UserActionManager::instance();
 	actionManager->setLinesWidget(m_mainWindow->m_linesWidget);
 	actionManager->setFullScreenMode(false);
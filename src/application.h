@@ -11,6 +11,7 @@
 #include "mainwindow.h"
 #include "core/subtitle.h"
 #include "formats/format.h"
+#include "formats/subtitlewriter.h"
 #include "gui/treeview/lineswidget.h"
 #include "scconfig.h"
 
@@ -27,7 +28,6 @@
 #include <KActionCollection>
 
 QT_FORWARD_DECLARE_CLASS(QAction)
-QT_FORWARD_DECLARE_CLASS(QUndoStack)
 QT_FORWARD_DECLARE_CLASS(QLabel)
 QT_FORWARD_DECLARE_CLASS(QTextCodec)
 
@@ -39,6 +39,8 @@ class KCodecActionExt;
 
 namespace SubtitleComposer {
 class TextDemux;
+class SubtitleReader;
+class SubtitleJournal;
 class SpeechProcessor;
 
 class PlayerWidget;
@@ -98,8 +100,8 @@ public slots:
 	void reopenSubtitleWithCodec(QTextCodec *codec = nullptr);
 	void demuxTextStream(int textStreamIndex);
 	void openSubtitle(const QUrl &url, bool warnClashingUrls = true);
-	bool saveSubtitle(QTextCodec *codec = nullptr);
-	bool saveSubtitleAs(QTextCodec *codec = nullptr);
+	bool saveSubtitle(QTextCodec *codec = nullptr, bool background = false);
+	bool saveSubtitleAs(QTextCodec *codec = nullptr, bool background = false);
 	bool closeSubtitle();
 
 	void speechImportAudioStream(int audioStreamIndex);
@@ -109,8 +111,8 @@ public slots:
 	void reopenSubtitleTrWithCodec(QTextCodec *codec = nullptr);
 
 	void openSubtitleTr(const QUrl &url, bool warnClashingUrls = true);
-	bool saveSubtitleTr(QTextCodec *codec = nullptr);
-	bool saveSubtitleTrAs(QTextCodec *codec = nullptr);
+	bool saveSubtitleTr(QTextCodec *codec = nullptr, bool background = false);
+	bool saveSubtitleTrAs(QTextCodec *codec = nullptr, bool background = false);
 	bool closeSubtitleTr();
 
 	void joinSubtitles();
@@ -203,13 +205,20 @@ signals:
 
 private:
 	void processSubtitleOpened(QTextCodec *codec, const QString &subtitleFormat);
+	void processSubtitleRead(const QUrl &url, QTextCodec *codec);
+	void dropReadSubtitle();
+	bool processSubtitleSaved(const SubtitleWriter::Job &job);
+	bool processSplitSaved(const SubtitleWriter::Job &job);
+	void startJournal();
+	void restartJournal();
+	bool finishSubtitleSave(quint64 saveId = 0);
 	void processTranslationOpened(QTextCodec *codec, const QString &subtitleFormat);
 
 	QTextCodec * codecForEncoding(const QString &encoding);
 
 	bool acceptClashingUrls(const QUrl &subtitleUrl, const QUrl &subtitleTrUrl);
 
-	QUrl saveSplitSubtitle(const Subtitle &subtitle, const QUrl &srcUrl, QString encoding, QString format, bool primary);
+	quint64 saveSplitSubtitle(const Subtitle &subtitle, const QUrl &srcUrl, QString encoding, QString format, bool primary, QUrl *dstUrl);
 
 	void setupActions();
 
@@ -220,6 +229,11 @@ private:
 private slots:
 	void updateTitle();
 
+	void onSubtitleLinesRead(const QList<SubtitleLine *> &lines);
+	void onSubtitleReadRestarted();
+	void onSubtitleReaderFinished();
+	void onSubtitleWritten();
+
 	void onWaveformDoubleClicked(Time time);
 	void onWaveformMiddleMouse(Time time);
 
@@ -251,11 +265,24 @@ private:
 
 	bool m_translationMode;
 	QUrl m_subtitleTrUrl;
+	QUrl m_pendingSubtitleTrUrl;
 	QString m_subtitleTrFileName;
 	QString m_subtitleTrEncoding;
 	QString m_subtitleTrFormat;
 
 	TextDemux *m_textDemux;
+	SubtitleReader *m_subtitleReader;
+	SubtitleWriter *m_subtitleWriter;
+	// latest queued saves, older ones to the same file are superseded by them
+	quint64 m_subtitleSaveId = 0;
+	quint64 m_subtitleTrSaveId = 0;
+	// split parts being saved, they are opened in a new window once both are written
+	quint64 m_splitSaveId = 0;
+	quint64 m_splitTrSaveId = 0;
+	QUrl m_splitUrl;
+	QUrl m_splitTrUrl;
+	int m_splitUndoIndex = -1;
+	SubtitleJournal *m_journal;
 	SpeechProcessor *m_speechProcessor;
 
 	SubtitleLine *m_lastFoundLine;
@@ -280,6 +307,7 @@ private:
 
 	QLabel *m_labSubFormat = nullptr;
 	QLabel *m_labSubEncoding = nullptr;
+	QLabel *m_labUndoMemory = nullptr;
 
 	ScriptsManager *m_scriptsManager;
 
@@ -73,7 +73,7 @@ Application::setupActions()
 	saveSubtitleAction->setText(i18n("Save"));
 	saveSubtitleAction->setStatusTip(i18n("Save opened subtitle"));
 	actionCollection->setDefaultShortcuts(saveSubtitleAction, KStandardShortcut::save());
-	connect(saveSubtitleAction, &QAction::triggered, this, [this](){ saveSubtitle(QTextCodec::codecForName(m_subtitleEncoding.toUtf8())); });
+	connect(saveSubtitleAction, &QAction::triggered, this, [this](){ saveSubtitle(QTextCodec::codecForName(m_subtitleEncoding.toUtf8()), true); });
 	actionCollection->addAction(ACT_SAVE_SUBTITLE, saveSubtitleAction);
 	actionManager->addAction(saveSubtitleAction, UserAction::SubPDirty | UserAction::FullScreenOff);
 
@@ -81,8 +81,8 @@ Application::setupActions()
 	m_saveSubtitleAsAction->setIcon(QIcon::fromTheme("document-save-as"));
 	m_saveSubtitleAsAction->setText(i18n("Save As..."));
 	m_saveSubtitleAsAction->setStatusTip(i18n("Save opened subtitle with different settings"));
-	connect(m_saveSubtitleAsAction, &KCodecActionExt::triggered, this, &Application::saveSubtitleAs);
-	connect(m_saveSubtitleAsAction, &QAction::triggered, this, [&](){ saveSubtitleAs(); });
+	connect(m_saveSubtitleAsAction, &KCodecActionExt::triggered, this, [this](QTextCodec *codec){ saveSubtitleAs(codec, true); });
+	connect(m_saveSubtitleAsAction, &QAction::triggered, this, [this](){ saveSubtitleAs(nullptr, true); });
 	actionCollection->addAction(ACT_SAVE_SUBTITLE_AS, m_saveSubtitleAsAction);
 	actionManager->addAction(m_saveSubtitleAsAction, UserAction::SubOpened | UserAction::FullScreenOff);
 
@@ -135,7 +135,7 @@ Application::setupActions()
 	saveSubtitleTrAction->setStatusTip(i18n("Save opened translation subtitle"));
 	actionCollection->setDefaultShortcut(saveSubtitleTrAction, QKeySequence("Ctrl+Shift+S"));
 	connect(saveSubtitleTrAction, &QAction::triggered, this, [&](){
-		saveSubtitleTr(QTextCodec::codecForName(m_subtitleTrEncoding.toUtf8()));
+		saveSubtitleTr(QTextCodec::codecForName(m_subtitleTrEncoding.toUtf8()), true);
 	});
 	actionCollection->addAction(ACT_SAVE_SUBTITLE_TR, saveSubtitleTrAction);
 	actionManager->addAction(saveSubtitleTrAction, UserAction::SubSDirty | UserAction::FullScreenOff);
@@ -144,8 +144,8 @@ Application::setupActions()
 	m_saveSubtitleTrAsAction->setIcon(QIcon::fromTheme("document-save-as"));
 	m_saveSubtitleTrAsAction->setText(i18n("Save Translation As..."));
 	m_saveSubtitleTrAsAction->setStatusTip(i18n("Save opened translation subtitle with different settings"));
-	connect(m_saveSubtitleTrAsAction, &KCodecActionExt::triggered, this, &Application::saveSubtitleTrAs);
-	connect(m_saveSubtitleTrAsAction, &QAction::triggered, this, [&](){ saveSubtitleTrAs(); });
+	connect(m_saveSubtitleTrAsAction, &KCodecActionExt::triggered, this, [this](QTextCodec *codec){ saveSubtitleTrAs(codec, true); });
+	connect(m_saveSubtitleTrAsAction, &QAction::triggered, this, [this](){ saveSubtitleTrAs(nullptr, true); });
 	actionCollection->addAction(ACT_SAVE_SUBTITLE_TR_AS, m_saveSubtitleTrAsAction);
 	actionManager->addAction(m_saveSubtitleTrAsAction, UserAction::SubTrOpened | UserAction::FullScreenOff);
 
@@ -10,12 +10,15 @@
 #include "actions/kcodecactionext.h"
 #include "actions/krecentfilesactionext.h"
 #include "actions/useractionnames.h"
+#include "core/subtitlejournal.h"
 #include "core/undo/undostack.h"
 #include "dialogs/joinsubtitlesdialog.h"
 #include "dialogs/splitsubtitledialog.h"
 #include "dialogs/syncsubtitlesdialog.h"
 #include "formats/inputformat.h"
 #include "formats/formatmanager.h"
+#include "formats/subtitlereader.h"
+#include "formats/subtitlewriter.h"
 #include "formats/textdemux/textdemux.h"
 #include "formats/outputformat.h"
 #include "helpers/commondefs.h"
@@ -168,33 +171,18 @@ Application::openSubtitle(const QUrl &url, bool warnClashingUrls)
 	QTextCodec *codec = codecForEncoding(KRecentFilesActionExt::encodingForUrl(url));
 
 	AppGlobal::subtitle = new Subtitle();
-	FormatManager::Status res = FormatManager::instance().readSubtitle(*appSubtitle(), true, url, &codec, &m_subtitleFormat);
-	if(res == FormatManager::SUCCESS) {
-		m_subtitleUrl = url;
-		processSubtitleOpened(codec, m_subtitleFormat);
-
-		if(m_subtitleUrl.isLocalFile() && SCConfig::automaticVideoLoad()) {
-			QFileInfo subtitleFileInfo(m_subtitleUrl.toLocalFile());
-
-			QString subtitleFileName = m_subtitleFileName.toLower();
-			QString videoFileName = QFileInfo(videoPlayer()->filePath()).completeBaseName().toLower();
-
-			if(videoFileName.isEmpty() || subtitleFileName.indexOf(videoFileName) != 0) {
-				QStringList subtitleDirFiles = subtitleFileInfo.dir().entryList(QDir::Files | QDir::Readable);
-				for(QStringList::ConstIterator it = subtitleDirFiles.constBegin(), end = subtitleDirFiles.constEnd(); it != end; ++it) {
-					QFileInfo fileInfo(*it);
-					if(videoExtensionList.contains(fileInfo.suffix().toLower())) {
-						if(subtitleFileName.indexOf(fileInfo.completeBaseName().toLower()) == 0) {
-							QUrl auxUrl;
-							auxUrl.setScheme($("file"));
-							auxUrl.setPath(subtitleFileInfo.dir().filePath(*it));
-							openVideo(auxUrl);
-							break;
-						}
-					}
-				}
-			}
+	FormatManager::Status res = FormatManager::instance().readBinary(*appSubtitle(), url, true, &codec, &m_subtitleFormat);
+	if(res == FormatManager::ERROR) {
+		// text formats are decoded and parsed in background, see onSubtitleLinesRead()
+		AppGlobal::subtitle.reset();
+		res = FormatManager::instance().textCodec(url, &codec);
+		if(res == FormatManager::SUCCESS) {
+			m_subtitleReader->read(url, codec);
+			return;
 		}
+	}
+	if(res == FormatManager::SUCCESS) {
+		processSubtitleRead(url, codec);
 	} else {
 		AppGlobal::subtitle.reset();
 
@@ -207,6 +195,106 @@ Application::openSubtitle(const QUrl &url, bool warnClashingUrls)
 	}
 }
 
+void
+Application::onSubtitleLinesRead(const QList<SubtitleLine *> &lines)
+{
+	if(appSubtitle()) {
+		appSubtitle()->insertLines(lines, false);
+		return;
+	}
+
+	// lines are shown as they are parsed, subtitle is opened for editing once whole file was parsed
+	Subtitle *subtitle = new Subtitle();
+	m_subtitleReader->setSubtitleData(*subtitle);
+	subtitle->insertLines(lines, false);
+	AppGlobal::subtitle = subtitle;
+	m_mainWindow->m_linesWidget->previewSubtitle(subtitle);
+}
+
+void
+Application::dropReadSubtitle()
+{
+	if(!appSubtitle())
+		return;
+
+	// nothing but lines widget has seen the subtitle and it couldn't be edited
+	m_mainWindow->m_linesWidget->setSubtitle(nullptr);
+	AppGlobal::subtitle.reset();
+}
+
+void
+Application::onSubtitleReadRestarted()
+{
+	// lines came from a format that failed to parse the rest of the file
+	dropReadSubtitle();
+}
+
+void
+Application::onSubtitleReaderFinished()
+{
+	// finished() of a cancelled read can arrive after next read was started
+	if(m_subtitleReader->isRunning() || !m_subtitleReader->isReading())
+		return;
+
+	const FormatManager::Status res = m_subtitleReader->status();
+	if(res == FormatManager::SUCCESS) {
+		// format without any lines has no subtitle yet
+		if(!appSubtitle())
+			AppGlobal::subtitle = new Subtitle();
+		// metadata can follow the last line
+		m_subtitleReader->setSubtitleData(*appSubtitle());
+		m_subtitleFormat = m_subtitleReader->formatName();
+		m_subtitleReader->reset();
+		processSubtitleRead(m_subtitleReader->url(), m_subtitleReader->codec());
+	} else {
+		// drop lines of the last format that failed or of cancelled read
+		m_subtitleReader->reset();
+		dropReadSubtitle();
+		if(res == FormatManager::ERROR) {
+			KMessageBox::error(
+				m_mainWindow,
+				i18n("<qt>Could not parse the subtitle file.<br/>"
+					 "This may have been caused by usage of the wrong encoding.</qt>"));
+		}
+	}
+
+	if(!m_pendingSubtitleTrUrl.isEmpty()) {
+		const QUrl url = m_pendingSubtitleTrUrl;
+		m_pendingSubtitleTrUrl.clear();
+		openSubtitleTr(url);
+	}
+}
+
+void
+Application::processSubtitleRead(const QUrl &url, QTextCodec *codec)
+{
+	m_subtitleUrl = url;
+	processSubtitleOpened(codec, m_subtitleFormat);
+
+	if(m_subtitleUrl.isLocalFile() && SCConfig::automaticVideoLoad()) {
+		QFileInfo subtitleFileInfo(m_subtitleUrl.toLocalFile());
+
+		QString subtitleFileName = m_subtitleFileName.toLower();
+		QString videoFileName = QFileInfo(videoPlayer()->filePath()).completeBaseName().toLower();
+
+		if(videoFileName.isEmpty() || subtitleFileName.indexOf(videoFileName) != 0) {
+			QStringList subtitleDirFiles = subtitleFileInfo.dir().entryList(QDir::Files | QDir::Readable);
+			for(QStringList::ConstIterator it = subtitleDirFiles.constBegin(), end = subtitleDirFiles.constEnd(); it != end; ++it) {
+				QFileInfo fileInfo(*it);
+				if(videoExtensionList.contains(fileInfo.suffix().toLower())) {
+					if(subtitleFileName.indexOf(fileInfo.completeBaseName().toLower()) == 0) {
+						QUrl auxUrl;
+						auxUrl.setScheme($("file"));
+						auxUrl.setPath(subtitleFileInfo.dir().filePath(*it));
+						openVideo(auxUrl);
+						break;
+					}
+				}
+			}
+		}
+	}
+}
+
 void
 Application::reopenSubtitleWithCodec(QTextCodec *codec)
 {
@@ -269,6 +357,8 @@ Application::processSubtitleOpened(QTextCodec *codec, const QString &subtitleFor
 
 	m_labSubFormat->setText(i18n("Format: %1", m_subtitleFormat));
 	m_labSubEncoding->setText(i18n("Encoding: %1", m_subtitleEncoding));
+
+	startJournal();
 }
 
 void
@@ -295,10 +385,14 @@ Application::speechImportAudioStream(int audioStreamIndex)
 }
 
 bool
-Application::saveSubtitle(QTextCodec *codec)
+Application::saveSubtitle(QTextCodec *codec, bool background)
 {
+	// lines parsed so far would replace the whole file
+	if(m_subtitleReader->isReading())
+		return false;
+
 	if(m_subtitleUrl.isEmpty() || !FormatManager::instance().hasOutput(m_subtitleFormat))
-		return saveSubtitleAs(codec);
+		return saveSubtitleAs(codec, background);
 
 	if(!codec)
 		codec = QTextCodec::codecForName(m_subtitleEncoding.toUtf8());
@@ -307,28 +401,96 @@ Application::saveSubtitle(QTextCodec *codec)
 	if(!codec)
 		codec = QTextCodec::codecForLocale();
 
-	if(FormatManager::instance().writeSubtitle(*appSubtitle(), true, m_subtitleUrl, codec, m_subtitleFormat, true)) {
-		appSubtitle()->clearPrimaryDirty();
+	appSubtitle()->primarySaveStarted();
+	m_subtitleSaveId = m_subtitleWriter->write(appSubtitle()->snapshot(), true, m_subtitleUrl, codec, m_subtitleFormat);
+	return background || finishSubtitleSave(m_subtitleSaveId);
+}
 
-		m_reopenSubtitleAsAction->setCurrentCodec(codec);
-		m_saveSubtitleAsAction->setCurrentCodec(codec);
-		m_recentSubtitlesAction->addUrl(m_subtitleUrl, codec->name());
-		m_subtitleEncoding = codec->name();
-		m_labSubFormat->setText(i18n("Format: %1", m_subtitleFormat));
-		m_labSubEncoding->setText(i18n("Encoding: %1", m_subtitleEncoding));
+void
+Application::onSubtitleWritten()
+{
+	const QVector<SubtitleWriter::Job> jobs = m_subtitleWriter->takeWritten();
+	for(const SubtitleWriter::Job &job : jobs)
+		processSubtitleSaved(job);
+}
 
-		updateTitle();
+/**
+ * @brief Wait for all queued saves, returns true if save @p saveId succeeded
+ * Blocks until files are written, so it's used only when closing.
+ */
+bool
+Application::finishSubtitleSave(quint64 saveId)
+{
+	m_subtitleWriter->finish();
 
-		return true;
-	} else {
-		KMessageBox::error(m_mainWindow, i18n("There was an error saving the subtitle."));
-		return false;
+	bool saved = false;
+	const QVector<SubtitleWriter::Job> jobs = m_subtitleWriter->takeWritten();
+	for(const SubtitleWriter::Job &job : jobs) {
+		if(processSubtitleSaved(job) && job.id == saveId)
+			saved = true;
+	}
+	return saved;
+}
+
+bool
+Application::processSubtitleSaved(const SubtitleWriter::Job &job)
+{
+	if(job.id == m_splitSaveId || job.id == m_splitTrSaveId)
+		return processSplitSaved(job);
+
+	const bool success = job.status == FormatManager::SUCCESS;
+
+	if(job.id == m_subtitleSaveId) {
+		m_subtitleSaveId = 0;
+
+		if(appSubtitle())
+			appSubtitle()->primarySaveFinished(success);
+
+		if(success) {
+			// saved file is the new journal base
+			m_journal->start(appSubtitle(), job.url, m_translationMode ? m_subtitleTrUrl : QUrl());
+
+			m_reopenSubtitleAsAction->setCurrentCodec(job.codec);
+			m_saveSubtitleAsAction->setCurrentCodec(job.codec);
+			m_recentSubtitlesAction->addUrl(job.url, job.codec->name());
+			m_subtitleEncoding = job.codec->name();
+			m_labSubFormat->setText(i18n("Format: %1", m_subtitleFormat));
+			m_labSubEncoding->setText(i18n("Encoding: %1", m_subtitleEncoding));
+
+			updateTitle();
+		} else if(job.status == FormatManager::ERROR) {
+			KMessageBox::error(m_mainWindow, i18n("There was an error saving the subtitle."));
+		}
+	} else if(job.id == m_subtitleTrSaveId) {
+		m_subtitleTrSaveId = 0;
+
+		if(appSubtitle())
+			appSubtitle()->secondarySaveFinished(success);
+
+		if(success) {
+			restartJournal();
+
+			m_reopenSubtitleTrAsAction->setCurrentCodec(job.codec);
+			m_saveSubtitleTrAsAction->setCurrentCodec(job.codec);
+			m_recentSubtitlesTrAction->addUrl(job.url, job.codec->name());
+			m_subtitleTrEncoding = job.codec->name();
+
+			updateTitle();
+		} else if(job.status == FormatManager::ERROR) {
+			KMessageBox::error(m_mainWindow, i18n("There was an error saving the translation subtitle."));
+		}
 	}
+	// saves that were superseded by a newer one are left to it
+
+	return success;
 }
 
 bool
-Application::saveSubtitleAs(QTextCodec *codec)
+Application::saveSubtitleAs(QTextCodec *codec, bool background)
 {
+	if(m_subtitleReader->isReading())
+		return false;
+
 	QFileDialog saveDlg(m_mainWindow, i18n("Save Subtitle"), QString(), buildSubtitleFilesFilter(false));
 
 	saveDlg.setModal(true);
@@ -352,7 +514,7 @@ Application::saveSubtitleAs(QTextCodec *codec)
 		m_subtitleFormat = saveDlg.selectedNameFilter();
 		if(!m_subtitleFormat.isEmpty())
 			m_subtitleFormat.truncate(m_subtitleFormat.indexOf(QStringLiteral(" (")));
-		return saveSubtitle(codec);
+		return saveSubtitle(codec, background);
 	}
 
 	return false;
@@ -360,12 +522,37 @@ Application::saveSubtitleAs(QTextCodec *codec)
 
 #if KWIDGETSADDONS_VERSION < QT_VERSION_CHECK(5, 100, 0)
 #define warningTwoActionsCancel warningYesNoCancel
+#define questionTwoActions questionYesNo
 #define PrimaryAction Yes
 #endif
 
+void
+Application::startJournal()
+{
+	if(SubtitleJournal::exists(m_subtitleUrl)) {
+		const KMessageBox::ButtonCode result = KMessageBox::questionTwoActions(m_mainWindow,
+						i18n("Subtitle has unsaved changes from a session that didn't end properly.\nDo you want to recover them?"),
+						i18n("Recover Subtitle") + " - SubtitleComposer",
+						KGuiItem(i18n("Recover"), QStringLiteral("document-revert")), KStandardGuiItem::discard());
+		if(result == KMessageBox::PrimaryAction && !SubtitleJournal::recover(m_subtitleUrl, appSubtitle()))
+			KMessageBox::error(m_mainWindow, i18n("Unsaved changes could not be recovered, subtitle file was changed since."));
+	}
+
+	m_journal->start(appSubtitle(), m_subtitleUrl);
+}
+
+void
+Application::restartJournal()
+{
+	// files as they are on disk now are the new journal base
+	m_journal->start(appSubtitle(), m_subtitleUrl, m_translationMode ? m_subtitleTrUrl : QUrl());
+}
+
 bool
 Application::closeSubtitle()
 {
+	finishSubtitleSave();
+
 	if(appSubtitle()) {
 		if(m_translationMode && appSubtitle()->isSecondaryDirty()) {
 			KMessageBox::ButtonCode result = KMessageBox::warningTwoActionsCancel(nullptr,
@@ -399,6 +586,9 @@ Application::closeSubtitle()
 		disconnect(appSubtitle(), &Subtitle::primaryDirtyStateChanged, this, &Application::updateTitle);
 		disconnect(appSubtitle(), &Subtitle::secondaryDirtyStateChanged, this, &Application::updateTitle);
 
+		// unsaved changes were either saved or discarded by now
+		m_journal->stop();
+
 		emit subtitleClosed();
 
 		appUndoStack()->clear();
@@ -421,6 +611,10 @@ Application::closeSubtitle()
 		updateTitle();
 	}
 
+	// lines of subtitle that is still being read would end up in the next one
+	m_subtitleReader->cancel();
+	m_subtitleReader->reset();
+
 	return true;
 }
 
@@ -456,6 +650,12 @@ Application::openSubtitleTr(const QUrl &url, bool warnClashingUrls)
 {
 	m_lastSubtitleUrl = url;
 
+	if(m_subtitleReader->isReading()) {
+		// opened once primary subtitle is read
+		m_pendingSubtitleTrUrl = url;
+		return;
+	}
+
 	if(!appSubtitle())
 		return;
 
@@ -540,13 +740,18 @@ Application::processTranslationOpened(QTextCodec *codec, const QString &subtitle
 		updateTitle();
 		emit translationModeChanged(true);
 	}
+
+	restartJournal();
 }
 
 bool
-Application::saveSubtitleTr(QTextCodec *codec)
+Application::saveSubtitleTr(QTextCodec *codec, bool background)
 {
+	if(m_subtitleReader->isReading())
+		return false;
+
 	if(m_subtitleTrUrl.isEmpty() || !FormatManager::instance().hasOutput(m_subtitleTrFormat))
-		return saveSubtitleTrAs(codec);
+		return saveSubtitleTrAs(codec, background);
 
 	if(!codec)
 		codec = QTextCodec::codecForName(m_subtitleTrEncoding.toUtf8());
@@ -555,25 +760,13 @@ Application::saveSubtitleTr(QTextCodec *codec)
 	if(!codec)
 		codec = QTextCodec::codecForLocale();
 
-	if(FormatManager::instance().writeSubtitle(*appSubtitle(), false, m_subtitleTrUrl, codec, m_subtitleTrFormat, true)) {
-		appSubtitle()->clearSecondaryDirty();
-
-		m_reopenSubtitleTrAsAction->setCurrentCodec(codec);
-		m_saveSubtitleTrAsAction->setCurrentCodec(codec);
-		m_recentSubtitlesTrAction->addUrl(m_subtitleTrUrl, codec->name());
-		m_subtitleTrEncoding = codec->name();
-
-		updateTitle();
-
-		return true;
-	} else {
-		KMessageBox::error(m_mainWindow, i18n("There was an error saving the translation subtitle."));
-		return false;
-	}
+	appSubtitle()->secondarySaveStarted();
+	m_subtitleTrSaveId = m_subtitleWriter->write(appSubtitle()->snapshot(), false, m_subtitleTrUrl, codec, m_subtitleTrFormat);
+	return background || finishSubtitleSave(m_subtitleTrSaveId);
 }
 
 bool
-Application::saveSubtitleTrAs(QTextCodec *codec)
+Application::saveSubtitleTrAs(QTextCodec *codec, bool background)
 {
 	QFileDialog saveDlg(m_mainWindow, i18n("Save Translation Subtitle"), QString(), buildSubtitleFilesFilter(false));
 
@@ -599,7 +792,7 @@ Application::saveSubtitleTrAs(QTextCodec *codec)
 		if(!m_subtitleTrFormat.isEmpty())
 			m_subtitleTrFormat.truncate(m_subtitleTrFormat.indexOf(QStringLiteral(" (")));
 
-		return saveSubtitleTr(codec);
+		return saveSubtitleTr(codec, background);
 	}
 
 	return false;
@@ -636,53 +829,76 @@ Application::closeSubtitleTr()
 //		AppGlobal::undoStack = savedStack;
 
 		m_mainWindow->m_linesWidget->setUpdatesEnabled(true);
+
+		restartJournal();
 	}
 
 	return true;
 }
 
-QUrl
-Application::saveSplitSubtitle(const Subtitle &subtitle, const QUrl &srcUrl, QString encoding, QString format, bool primary)
+quint64
+Application::saveSplitSubtitle(const Subtitle &subtitle, const QUrl &srcUrl, QString encoding, QString format, bool primary, QUrl *dstUrl)
 {
-	QUrl dstUrl;
+	if(encoding.isEmpty())
+		encoding = "UTF-8";
 
-	if(subtitle.linesCount()) {
-		if(encoding.isEmpty())
-			encoding = "UTF-8";
+	if(format.isEmpty())
+		format = FormatManager::instance().defaultOutput()->name();
 
-		if(format.isEmpty())
-			format = FormatManager::instance().defaultOutput()->name();
+	QFileInfo dstFileInfo;
+	if(srcUrl.isEmpty() || !srcUrl.isLocalFile()) {
+		QString baseName = primary ? i18n("Untitled") : i18n("Untitled Translation");
+		dstFileInfo = QFileInfo(QDir(System::tempDir()), baseName + FormatManager::instance().output(format)->extensions().first());
+	} else {
+		dstFileInfo = QFileInfo(srcUrl.toLocalFile());
+	}
+	*dstUrl = srcUrl;
+	dstUrl->setPath(dstFileInfo.path());
+	*dstUrl = System::newUrl(*dstUrl, dstFileInfo.completeBaseName() + " - " + i18nc("Suffix added to split subtitles", "split"), dstFileInfo.suffix());
 
-		QFileInfo dstFileInfo;
-		if(srcUrl.isEmpty() || !srcUrl.isLocalFile()) {
-			QString baseName = primary ? i18n("Untitled") : i18n("Untitled Translation");
-			dstFileInfo = QFileInfo(QDir(System::tempDir()), baseName + FormatManager::instance().output(format)->extensions().first());
-		} else {
-			dstFileInfo = QFileInfo(srcUrl.toLocalFile());
-		}
-		dstUrl = srcUrl;
-		dstUrl.setPath(dstFileInfo.path());
-		dstUrl = System::newUrl(dstUrl, dstFileInfo.completeBaseName() + " - " + i18nc("Suffix added to split subtitles", "split"), dstFileInfo.suffix());
-
-		QTextCodec *codec = QTextCodec::codecForName(encoding.toUtf8());
-		if(!codec)
-			codec = QTextCodec::codecForLocale();
-
-		if(FormatManager::instance().writeSubtitle(subtitle, primary, dstUrl, codec, format, false)) {
-			if(primary)
-				m_recentSubtitlesAction->addUrl(dstUrl, codec->name());
-			else
-				m_recentSubtitlesTrAction->addUrl(dstUrl, codec->name());
-		} else {
-			dstUrl.clear();
-		}
+	QTextCodec *codec = QTextCodec::codecForName(encoding.toUtf8());
+	if(!codec)
+		codec = QTextCodec::codecForLocale();
+
+	return m_subtitleWriter->write(subtitle.snapshot(), primary, *dstUrl, codec, format, false);
+}
+
+bool
+Application::processSplitSaved(const SubtitleWriter::Job &job)
+{
+	const bool primary = job.id == m_splitSaveId;
+
+	if(job.status != FormatManager::SUCCESS) {
+		m_splitSaveId = m_splitTrSaveId = 0;
+		if(job.status == FormatManager::ERROR)
+			KMessageBox::error(m_mainWindow, primary ? i18n("Could not write the split subtitle file.") : i18n("Could not write the split subtitle translation file."));
+		// undo the splitting of appSubtitle(), unless it was edited since
+		if(appSubtitle() && appUndoStack()->index() == m_splitUndoIndex)
+			appUndoStack()->undo();
+		return false;
 	}
 
-	if(dstUrl.path().isEmpty()) {
-		KMessageBox::error(m_mainWindow, primary ? i18n("Could not write the split subtitle file.") : i18n("Could not write the split subtitle translation file."));
+	if(primary) {
+		m_splitSaveId = 0;
+		m_recentSubtitlesAction->addUrl(job.url, job.codec->name());
+	} else {
+		m_splitTrSaveId = 0;
+		m_recentSubtitlesTrAction->addUrl(job.url, job.codec->name());
 	}
+	if(m_splitSaveId || m_splitTrSaveId)
+		return true;
+
+	QStringList args;
+	args << m_splitUrl.toString(QUrl::PreferLocalFile);
+	if(!m_splitTrUrl.isEmpty())
+		args << m_splitTrUrl.toString(QUrl::PreferLocalFile);
 
-	return dstUrl;
+	if(!QProcess::startDetached(applicationName(), args)) {
+		KMessageBox::error(m_mainWindow, !m_splitTrUrl.isEmpty()
+			? i18n("Could not open a new Subtitle Composer window.\n" "The split part was saved as %1.", m_splitUrl.path())
+			: i18n("Could not open a new Subtitle Composer window.\n" "The split parts were saved as %1 and %2.", m_splitUrl.path(), m_splitTrUrl.path()));
+	}
+	return true;
 }
 
 void
@@ -724,40 +940,13 @@ Application::splitSubtitle()
 		return;
 	}
 
-	QUrl splitUrl = saveSplitSubtitle(
-		*newSubtitle,
-		m_subtitleUrl,
-		m_subtitleEncoding,
-		m_subtitleFormat,
-		true);
-
-	if(splitUrl.path().isEmpty()) {
-		// there was an error saving the split part, undo the splitting of appSubtitle()
-		appUndoStack()->undo();
-		return;
-	}
-
-	QUrl splitTrUrl;
-	if(m_translationMode) {
-		splitTrUrl = saveSplitSubtitle(*newSubtitle, m_subtitleTrUrl, m_subtitleTrEncoding, m_subtitleTrFormat, false);
-
-		if(splitTrUrl.path().isEmpty()) {
-			// there was an error saving the split part, undo the splitting of appSubtitle()
-			appUndoStack()->undo();
-			return;
-		}
-	}
-
-	QStringList args;
-	args << splitUrl.toString(QUrl::PreferLocalFile);
+	// new window is opened with split parts once they are written, see processSplitSaved()
+	m_splitUndoIndex = appUndoStack()->index();
+	m_splitSaveId = saveSplitSubtitle(*newSubtitle, m_subtitleUrl, m_subtitleEncoding, m_subtitleFormat, true, &m_splitUrl);
+	m_splitTrUrl.clear();
+	m_splitTrSaveId = 0;
 	if(m_translationMode)
-		args << splitTrUrl.toString(QUrl::PreferLocalFile);
-
-	if(!QProcess::startDetached(applicationName(), args)) {
-		KMessageBox::error(m_mainWindow, m_translationMode
-			? i18n("Could not open a new Subtitle Composer window.\n" "The split part was saved as %1.", splitUrl.path())
-			: i18n("Could not open a new Subtitle Composer window.\n" "The split parts were saved as %1 and %2.", splitUrl.path(), splitTrUrl.path()));
-	}
+		m_splitTrSaveId = saveSplitSubtitle(*newSubtitle, m_subtitleTrUrl, m_subtitleTrEncoding, m_subtitleTrFormat, false, &m_splitTrUrl);
 }
 
 void
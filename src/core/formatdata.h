@@ -32,15 +32,16 @@ public:
 		return *this;
 	}
 
-	inline const QString & formatName()
+	inline const QString & formatName() const
 	{
 		return m_formatName;
 	}
 
-	inline const QString & value(const QString &key)
+	inline const QString & value(const QString &key) const
 	{
 		static const QString empty;
-		return m_data.contains(key) ? m_data[key] : empty;
+		const auto it = m_data.constFind(key);
+		return it != m_data.cend() ? it.value() : empty;
 	}
 
 	inline void setValue(const QString &key, const QString &value)
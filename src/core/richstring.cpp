@@ -12,10 +12,13 @@
 #include <QColor>
 #include <QDebug>
 #include <QList>
+#include <QMultiHash>
+#include <QMutex>
 #include <QRegularExpression>
 #include <QStringList>
 #include <QVector>
 
+#include <algorithm>
 #include <type_traits>
 
 #if QT_VERSION < QT_VERSION_CHECK(6, 0, 0)
@@ -60,7 +63,7 @@ public:
 			&& (voice() == other.voice())
 			&& (klass() == other.klass());
 	}
-	inline bool operator!=(const RichStyle &other) { return !operator==(other); }
+	inline bool operator!=(const RichStyle &other) const { return !operator==(other); }
 
 private:
 	RichString::StyleFlags m_flags;
@@ -79,13 +82,9 @@ public:
 	RichStringStyle(int len);
 	RichStringStyle(int len, quint8 styleFlags, QRgb styleColor, const QString &klass, const QString &voice);
 	RichStringStyle(int len, quint8 styleFlags, QRgb styleColor, const QSet<QString> &classList, const QString &voice);
-	RichStringStyle(const RichStringStyle &other);
-	~RichStringStyle();
 
 	void clear();
 
-	RichStringStyle & operator=(const RichStringStyle &other);
-
 	qint32 voiceIndex(const QString &name);
 	qint32 classIndex(const QString &name);
 
@@ -94,8 +93,14 @@ public:
 	inline QString className(int index) const { return m_classList.at(index); }
 	inline int classCount() const { return m_classList.size(); }
 
-	inline RichStyle * operator[](int index) { Q_ASSERT(index >= 0 && index < m_length); return &m_style[index]; }
-	inline const RichStyle & at(int index) const { return index >= 0 && index < m_length ? m_style[index] : RichStyle::s_null; }
+	inline int length() const { return m_length; }
+	inline const RichStyle & at(int index) const { return index >= 0 && index < m_length ? m_spans.at(spanAt(index)).style : RichStyle::s_null; }
+	/**
+	 * @brief Index of first character after index that has a different style
+	 * @param index
+	 * @return end of style run containing index or length() if run is the last one
+	 */
+	inline int spanEnd(int index) const { const int i = spanAt(index) + 1; return i < m_spans.size() ? m_spans.at(i).start : m_length; }
 
 	/**
 	 * @brief Insert invalid style for len characters at index
@@ -110,10 +115,15 @@ public:
 	 * @param index
 	 * @param len
 	 */
-	void replace(int index, int len, int newLen);
+	inline void replace(int index, int len, int newLen) { splice(index, len, newLen, SpanList()); }
 
-	inline void fill(int index, int len, const RichStyle &style);
+	inline void fill(int index, int len, const RichStyle &style) { if(len > 0) splice(index, len, len, SpanList{Span{0, style}}); }
 	void copy(int index, int len, const RichStringStyle &src, int srcOffset=0);
+	/**
+	 * @brief Call fn on style of every run in range [index, index + len), splitting runs at range boundaries
+	 */
+	template<class F>
+	void update(int index, int len, F fn);
 
 	void swap(RichStringStyle &other, bool swapLists);
 
@@ -122,15 +132,22 @@ public:
 	inline void richText(QString &out, int prevIndex, int curIndex, bool opening);
 
 private:
-	void detach();
-	void updateCapacity();
+	struct Span {
+		int start;
+		RichStyle style;
+	};
+	typedef QVector<Span> SpanList;
+
+	int spanAt(int index) const;
+	static inline void appendSpan(SpanList &spans, int start, const RichStyle &style);
+	void splice(int index, int len, int newLen, const SpanList &newSpans);
 
 private:
 	QVector<QString> m_classList;
 	QVector<QString> m_voiceList;
-	RichStyle *m_style;
+	// style runs sorted by start, first run starts at 0, adjacent runs always differ
+	SpanList m_spans;
 	int m_length;
-	int m_capacity;
 };
 
 struct ReplaceHelper {
@@ -157,42 +174,94 @@ struct ReplaceHelper {
 };
 }
 
-void
-RichStringStyle::replace(int index, int lenRemove, int lenAdd)
+int
+RichStringStyle::spanAt(int index) const
 {
-	Q_ASSERT(index + lenRemove <= m_length);
-	const int tailLength = m_length - index - lenRemove;
+	const auto it = std::upper_bound(m_spans.cbegin(), m_spans.cend(), index,
+			[](int i, const Span &s){ return i < s.start; });
+	return int(it - m_spans.cbegin()) - 1;
+}
 
-	RichStyle *oldStyle = m_style;
+inline void
+RichStringStyle::appendSpan(SpanList &spans, int start, const RichStyle &style)
+{
+	if(!spans.isEmpty() && spans.last().start == start)
+		spans.removeLast();
+	if(spans.isEmpty() || spans.last().style != style)
+		spans.append(Span{start, style});
+}
 
-	detach();
-	m_length += lenAdd - lenRemove;
-	updateCapacity();
+void
+RichStringStyle::splice(int index, int len, int newLen, const SpanList &newSpans)
+{
+	Q_ASSERT(index >= 0 && index + len <= m_length);
+	const int end = index + len;
+	const int delta = newLen - len;
+
+	const auto appendNew = [&](SpanList &spans){
+		if(!newLen)
+			return;
+		if(newSpans.isEmpty())
+			appendSpan(spans, index, RichStyle::s_null);
+		for(const Span &s: newSpans)
+			appendSpan(spans, index + s.start, s.style);
+	};
 
-	if(index) {
-		// restore data before inserted part
-		memcpy(m_style, oldStyle, index * sizeof(*m_style));
-	}
-	if(tailLength) {
-		// restore data after inserted part
-		const int tailStart = index + lenAdd;
-		const int tailStartOld = index + lenRemove;
-		memcpy(m_style + tailStart, oldStyle + tailStartOld, tailLength * sizeof(*m_style));
+	if(end == m_length) {
+		// changes at the end (appending text) are done in place
+		int n = m_spans.size();
+		while(n && m_spans.at(n - 1).start >= index)
+			n--;
+		m_spans.resize(n);
+		appendNew(m_spans);
+		m_length += delta;
+		return;
 	}
 
-	delete[] oldStyle;
-}
-
-inline void
-RichStringStyle::fill(int index, int len, const RichStyle &style)
+	const RichStyle tail = at(end);
+	SpanList spans;
+	spans.reserve(m_spans.size() + newSpans.size() + 2);
+	int i = 0;
+	const int n = m_spans.size();
+	for(; i < n && m_spans.at(i).start < index; i++)
+		spans.append(m_spans.at(i));
+	appendNew(spans);
+	appendSpan(spans, end + delta, tail);
+	while(i < n && m_spans.at(i).start <= end)
+		i++;
+	for(; i < n; i++)
+		appendSpan(spans, m_spans.at(i).start + delta, m_spans.at(i).style);
+	m_spans.swap(spans);
+	m_length += delta;
+}
+
+template<class F>
+void
+RichStringStyle::update(int index, int len, F fn)
 {
-	Q_ASSERT(index + len <= m_length);
-	if(len) {
-		RichStyle *s = m_style + index;
-		const RichStyle *e = s + len;
-		while(s != e)
-			*s++ = style;
+	Q_ASSERT(index >= 0 && index + len <= m_length);
+	if(len <= 0)
+		return;
+
+	const int end = index + len;
+	SpanList spans;
+	spans.reserve(m_spans.size() + 2);
+	for(int i = 0, n = m_spans.size(); i < n; i++) {
+		const Span &s = m_spans.at(i);
+		const int sEnd = i + 1 < n ? m_spans.at(i + 1).start : m_length;
+		if(sEnd <= index || s.start >= end) {
+			appendSpan(spans, s.start, s.style);
+			continue;
+		}
+		if(s.start < index)
+			appendSpan(spans, s.start, s.style);
+		RichStyle style = s.style;
+		fn(style);
+		appendSpan(spans, qMax(s.start, index), style);
+		if(sEnd > end)
+			appendSpan(spans, end, s.style);
 	}
+	m_spans.swap(spans);
 }
 
 void
@@ -202,11 +271,16 @@ RichStringStyle::copy(int index, int len, const RichStringStyle &src, int srcOff
 	if(len <= 0)
 		return;
 
+	const int srcEnd = srcOffset + len;
+	SpanList spans;
+
 	if(index == 0 && len == m_length) {
 		// overwrite everything
 		m_voiceList = src.m_voiceList;
 		m_classList = src.m_classList;
-		memcpy(m_style, src.m_style + srcOffset, len * sizeof(*m_style));
+		for(int i = qMax(0, src.spanAt(srcOffset)), n = src.m_spans.size(); i < n && src.m_spans.at(i).start < srcEnd; i++)
+			spans.append(Span{qMax(0, src.m_spans.at(i).start - srcOffset), src.m_spans.at(i).style});
+		m_spans.swap(spans);
 		return;
 	}
 
@@ -219,8 +293,8 @@ RichStringStyle::copy(int index, int len, const RichStringStyle &src, int srcOff
 	int *voiceMap = new int[nv];
 	for(int i = 0; i < nv; i++)
 		voiceMap[i] = voiceIndex(src.m_voiceList[i]);
-	for(int i = 0; i < len; i++) {
-		const RichStyle &ss = src.m_style[srcOffset + i];
+	for(int i = qMax(0, src.spanAt(srcOffset)), n = src.m_spans.size(); i < n && src.m_spans.at(i).start < srcEnd; i++) {
+		const RichStyle &ss = src.m_spans.at(i).style;
 		quint64 klass = 0;
 		for(int ci = 0; ci < nc; ci++) {
 			if(classMap[ci] < 0)
@@ -230,98 +304,80 @@ RichStringStyle::copy(int index, int len, const RichStringStyle &src, int srcOff
 		}
 		Q_ASSERT(ss.voice() < nv);
 		qint32 voice = ss.voice() < 0 ? -1 : voiceMap[ss.voice()];
-		m_style[index + i] = RichStyle(ss.flags(), ss.color(), klass, voice);
+		appendSpan(spans, qMax(0, src.m_spans.at(i).start - srcOffset), RichStyle(ss.flags(), ss.color(), klass, voice));
 	}
 	delete[] voiceMap;
 	delete[] classMap;
+
+	splice(index, len, len, spans);
 }
 
 void
 RichStringStyle::removeUnused()
 {
+	if(m_voiceList.isEmpty() && m_classList.isEmpty())
+		return;
+
+	// renumber voices and classes in order of first use, dropping the unused ones
 	const int nv = m_voiceList.size();
-	int *voiceMap = new int[nv]();
-	int voiceUsed = 0;
-	for(int i = 0; i < m_length; i++) {
-		const qint32 v = m_style[i].voice();
+	int *voiceMap = new int[nv];
+	std::fill_n(voiceMap, nv, -1);
+	QVector<QString> voiceList;
+
+	const int nc = m_classList.size();
+	int *classMap = new int[nc];
+	std::fill_n(classMap, nc, -1);
+	QVector<QString> classList;
+
+	for(Span &s: m_spans) {
+		const qint32 v = s.style.voice();
 		if(v >= 0) {
-			if(!voiceMap[v]) {
-#if QT_VERSION < QT_VERSION_CHECK(5, 14, 0)
-				QString *vlp = m_voiceList.data();
-				qSwap(vlp[v], vlp[voiceUsed]);
-#else
-				m_voiceList.swapItemsAt(v, voiceUsed);
-#endif
-				voiceMap[v] = ++voiceUsed;
+			if(voiceMap[v] < 0) {
+				voiceMap[v] = voiceList.size();
+				voiceList.append(m_voiceList.at(v));
 			}
-			m_style[i].voice() = voiceMap[v] - 1;
+			s.style.voice() = voiceMap[v];
 		}
-	}
-	m_voiceList.resize(voiceUsed);
 
-	const int nc = m_classList.size();
-	int *classMap = new int[nc]();
-	int classUsed = 0;
-	quint64 prevClass = 0;
-	for(int i = 0; i < m_length; i++) {
-		quint64 c = m_style[i].klass();
-		if(!c)
-			continue;
-		if(i && c == prevClass) {
-			m_style[i].klass() = m_style[i - 1].klass();
-			continue;
-		}
-		prevClass = c;
-		m_style[i].klass() = 0;
+		quint64 c = s.style.klass();
+		s.style.klass() = 0;
 		for(int k = 0; c; k++, c >>= 1) {
 			if(!(c & 1))
 				continue;
-			if(!classMap[k]) {
-#if QT_VERSION < QT_VERSION_CHECK(5, 14, 0)
-				QString *clp = m_classList.data();
-				qSwap(clp[k], clp[classUsed]);
-#else
-				m_classList.swapItemsAt(k, classUsed);
-#endif
-				classMap[k] = ++classUsed;
+			if(classMap[k] < 0) {
+				classMap[k] = classList.size();
+				classList.append(m_classList.at(k));
 			}
-			m_style[i].klass() |= 1ULL << (classMap[k] - 1);
+			s.style.klass() |= 1ULL << classMap[k];
 		}
 	}
-	m_classList.resize(classUsed);
+	m_voiceList.swap(voiceList);
+	m_classList.swap(classList);
 
 	delete[] classMap;
 	delete[] voiceMap;
 }
 
 RichStringStyle::RichStringStyle(int len)
-	: m_style(nullptr),
-	  m_length(len),
-	  m_capacity(0)
+	: m_length(len)
 {
 	if(m_length)
-		updateCapacity();
+		m_spans.append(Span{0, RichStyle::s_null});
 }
 
 RichStringStyle::RichStringStyle(int len, quint8 styleFlags, QRgb styleColor, const QString &klass, const QString &voice)
-	: m_style(nullptr),
-	  m_length(len),
-	  m_capacity(0)
+	: m_length(len)
 {
 	if(!klass.isEmpty())
 		m_classList.append(klass);
 	if(!voice.isEmpty())
 		m_voiceList.append(voice);
-	if(m_length) {
-		updateCapacity();
-		fill(0, m_length, RichStyle(quint8(styleFlags & RichString::AllStyles), styleColor, m_classList.size(), m_voiceList.size() - 1));
-	}
+	if(m_length)
+		m_spans.append(Span{0, RichStyle(quint8(styleFlags & RichString::AllStyles), styleColor, m_classList.size(), m_voiceList.size() - 1)});
 }
 
 RichStringStyle::RichStringStyle(int len, quint8 styleFlags, QRgb styleColor, const QSet<QString> &classList, const QString &voice)
-	: m_style(nullptr),
-	  m_length(len),
-	  m_capacity(0)
+	: m_length(len)
 {
 	quint64 classMap = 0;
 	for(const QString &klass: classList) {
@@ -331,28 +387,8 @@ RichStringStyle::RichStringStyle(int len, quint8 styleFlags, QRgb styleColor, co
 	}
 	if(!voice.isEmpty())
 		m_voiceList.append(voice);
-	if(m_length) {
-		updateCapacity();
-		fill(0, m_length, RichStyle(quint8(styleFlags & RichString::AllStyles), styleColor, classMap, m_voiceList.size() - 1));
-	}
-}
-
-RichStringStyle::RichStringStyle(const RichStringStyle &other)
-	: m_classList(other.m_classList),
-	  m_voiceList(other.m_voiceList),
-	  m_style(nullptr),
-	  m_length(other.m_length),
-	  m_capacity(0)
-{
-	if(m_length) {
-		updateCapacity();
-		memcpy(m_style, other.m_style, m_length * sizeof(*m_style));
-	}
-}
-
-RichStringStyle::~RichStringStyle()
-{
-	delete[] m_style;
+	if(m_length)
+		m_spans.append(Span{0, RichStyle(quint8(styleFlags & RichString::AllStyles), styleColor, classMap, m_voiceList.size() - 1)});
 }
 
 void
@@ -360,20 +396,8 @@ RichStringStyle::clear()
 {
 	m_classList.clear();
 	m_voiceList.clear();
+	m_spans.clear();
 	m_length = 0;
-	updateCapacity();
-}
-
-RichStringStyle &
-RichStringStyle::operator=(const RichStringStyle &other)
-{
-	m_classList = other.m_classList;
-	m_voiceList = other.m_voiceList;
-	m_length = other.m_length;
-	updateCapacity();
-	if(m_length)
-		memcpy(m_style, other.m_style, m_length * sizeof(*m_style));
-	return *this;
 }
 
 qint32
@@ -409,33 +433,10 @@ RichStringStyle::swap(RichStringStyle &other, bool swapLists)
 		qSwap(m_classList, other.m_classList);
 		qSwap(m_voiceList, other.m_voiceList);
 	}
-	qSwap(m_style, other.m_style);
+	qSwap(m_spans, other.m_spans);
 	qSwap(m_length, other.m_length);
-	qSwap(m_capacity, other.m_capacity);
 }
 
-void
-RichStringStyle::detach()
-{
-	m_style = nullptr;
-	m_capacity = 0;
-}
-
-void
-RichStringStyle::updateCapacity()
-{
-	if(m_length > m_capacity)
-		m_capacity = m_length * 2;
-	else if(m_length == 0)
-		m_capacity = 0;
-	else if(m_capacity > 100 && m_length < m_capacity / 2)
-		m_capacity = m_capacity / 2;
-	else if(m_style)
-		return;
-
-	delete[] m_style;
-	m_style = m_capacity ? new RichStyle[m_capacity] : nullptr;
-}
 
 
 RichString::RichString(const QString &string, quint8 styleFlags, QRgb styleColor, const QSet<QString> &classList, const QString &voice)
@@ -493,7 +494,7 @@ RichString::setStyleFlagsAt(int index, StyleFlags styleFlags) const
 {
 	if(index < 0 || index >= length())
 		return;
-	(*m_style)[index]->flags() = styleFlags;
+	m_style->update(index, 1, [styleFlags](RichStyle &s){ s.flags() = styleFlags; });
 }
 
 QRgb
@@ -507,12 +508,13 @@ RichString::setStyleColorAt(int index, QRgb rgbColor) const
 {
 	if(index < 0 || index >= length())
 		return;
-	RichStyle *it = (*m_style)[index];
-	if(rgbColor == 0)
-		it->flags() &= ~RichString::Color;
-	else
-		it->flags() |= RichString::Color;
-	it->color() = rgbColor;
+	m_style->update(index, 1, [rgbColor](RichStyle &s){
+		if(rgbColor == 0)
+			s.flags() &= ~RichString::Color;
+		else
+			s.flags() |= RichString::Color;
+		s.color() = rgbColor;
+	});
 }
 
 QSet<QString>
@@ -530,13 +532,15 @@ RichString::styleClassesAt(int index) const
 void
 RichString::setStyleClassesAt(int index, const QSet<QString> &classes) const
 {
+	if(index < 0 || index >= length())
+		return;
 	quint64 k = 0;
 	for(const QString &cl: classes) {
 		qint32 i = m_style->classIndex(cl);
 		if(i >= 0)
 			k |= 1ULL << i;
 	}
-	(*m_style)[index]->klass() = k;
+	m_style->update(index, 1, [k](RichStyle &s){ s.klass() = k; });
 }
 
 QString
@@ -549,15 +553,19 @@ RichString::styleVoiceAt(int index) const
 void
 RichString::setStyleVoiceAt(int index, const QString &voice) const
 {
+	if(index < 0 || index >= length())
+		return;
 	const qint32 v = m_style->voiceIndex(voice);
-	(*m_style)[index]->voice() = v;
+	m_style->update(index, 1, [v](RichStyle &s){ s.voice() = v; });
 }
 
 QDataStream &
 operator<<(QDataStream &stream, const RichString &string)
 {
 	stream << static_cast<const QString &>(string);
-	stream.writeRawData(reinterpret_cast<const char *>(string.m_style->m_style), string.length() * sizeof(*string.m_style->m_style));
+	stream << qint32(string.m_style->m_spans.size());
+	for(const RichStringStyle::Span &s: string.m_style->m_spans)
+		stream << qint32(s.start) << quint8(s.style.flags()) << quint32(s.style.color()) << quint64(s.style.klass()) << qint32(s.style.voice());
 	stream << string.m_style->m_classList;
 	stream << string.m_style->m_voiceList;
 	return stream;
@@ -567,11 +575,30 @@ QDataStream &
 operator>>(QDataStream &stream, RichString &string)
 {
 	stream >> static_cast<QString &>(string);
+	string.m_style->clear();
 	string.m_style->m_length = string.length();
-	string.m_style->updateCapacity();
-	stream.readRawData(reinterpret_cast<char *>(string.m_style->m_style), string.length() * sizeof(*string.m_style->m_style));
+	qint32 n = 0;
+	stream >> n;
+	if(n < 0 || n > string.length())
+		n = -1;
+	for(qint32 i = 0; i < n && stream.status() == QDataStream::Ok; i++) {
+		qint32 start, voice;
+		quint8 flags;
+		quint32 color;
+		quint64 klass;
+		stream >> start >> flags >> color >> klass >> voice;
+		if(i ? start <= string.m_style->m_spans.last().start || start >= string.length() : start != 0) {
+			n = -1;
+			break;
+		}
+		string.m_style->m_spans.append(RichStringStyle::Span{start, RichStyle(flags, color, klass, voice)});
+	}
 	stream >> string.m_style->m_classList;
 	stream >> string.m_style->m_voiceList;
+	if(n < 0 || (string.length() && string.m_style->m_spans.isEmpty())) {
+		stream.setStatus(QDataStream::ReadCorruptData);
+		*string.m_style = RichStringStyle(string.length());
+	}
 	return stream;
 }
 
@@ -644,10 +671,7 @@ RichString::richString() const
 
 	m_style->richText(ret, -1, prev, true);
 
-	for(int cur = 1; cur < len; cur++) {
-		if(m_style->at(prev) == m_style->at(cur))
-			continue;
-
+	for(int cur = m_style->spanEnd(prev); cur < len; cur = m_style->spanEnd(prev)) {
 		// place closing html tags before spaces/newlines
 		int cps = cur;
 		while(cur > 0) {
@@ -867,7 +891,7 @@ RichString::StyleFlags
 RichString::cummulativeStyleFlags() const
 {
 	quint8 cummulativeStyleFlags = 0;
-	for(int i = 0, size = length(); i < size; i++) {
+	for(int i = 0, size = length(); i < size; i = m_style->spanEnd(i)) {
 		cummulativeStyleFlags |= m_style->at(i).flags();
 		if(cummulativeStyleFlags == AllStyles)
 			break;
@@ -879,7 +903,7 @@ bool
 RichString::hasStyleFlags(StyleFlags styleFlags) const
 {
 	StyleFlags cummulativeStyleFlags = 0;
-	for(int i = 0, size = length(); i < size; i++) {
+	for(int i = 0, size = length(); i < size; i = m_style->spanEnd(i)) {
 		cummulativeStyleFlags |= m_style->at(i).flags();
 		if((cummulativeStyleFlags & styleFlags) == styleFlags)
 			return true;
@@ -893,8 +917,7 @@ RichString::setStyleFlags(int index, int len, StyleFlags styleFlags)
 	if(index < 0 || index >= length())
 		return *this;
 
-	for(int end = index + length(index, len); index < end; index++)
-		(*m_style)[index]->flags() = styleFlags;
+	m_style->update(index, length(index, len), [styleFlags](RichStyle &s){ s.flags() = styleFlags; });
 
 	return *this;
 }
@@ -905,15 +928,11 @@ RichString::setStyleFlags(int index, int len, StyleFlags styleFlags, bool on)
 	if(index < 0 || index >= length())
 		return *this;
 
-	const int end = index + length(index, len);
-	if(on) {
-		for(; index < end; index++)
-			(*m_style)[index]->flags() |= styleFlags;
-	} else {
-		styleFlags = ~styleFlags;
-		for(; index < end; index++)
-			(*m_style)[index]->flags() &= styleFlags;
-	}
+	len = length(index, len);
+	if(on)
+		m_style->update(index, len, [styleFlags](RichStyle &s){ s.flags() |= styleFlags; });
+	else
+		m_style->update(index, len, [styleFlags](RichStyle &s){ s.flags() &= ~styleFlags; });
 
 	return *this;
 }
@@ -922,7 +941,7 @@ QSet<QRgb>
 RichString::cummulativeColors() const
 {
 	QSet<QRgb> res;
-	for(int i = 0, n = length(); i < n; i++)
+	for(int i = 0, n = length(); i < n; i = m_style->spanEnd(i))
 		res.insert(m_style->at(i).color());
 	return res;
 }
@@ -952,13 +971,13 @@ RichString::setStyleColor(int index, int len, QRgb color)
 	if(index < 0 || index >= length())
 		return *this;
 
-	for(int end = index + length(index, len); index < end; index++) {
-		(*m_style)[index]->color() = color;
+	m_style->update(index, length(index, len), [color](RichStyle &s){
+		s.color() = color;
 		if(color)
-			(*m_style)[index]->flags() |= Color;
+			s.flags() |= Color;
 		else
-			(*m_style)[index]->flags() &= ~Color;
-	}
+			s.flags() &= ~Color;
+	});
 
 	return *this;
 }
@@ -1388,6 +1407,7 @@ RichString::simplifyWhiteSpace(QString &text)
 void
 RichString::simplifyWhiteSpace()
 {
+	RichStringStyle newStyle(0);
 	int di = 0;
 	bool lastWasSpace = true;
 	bool lastWasLineFeed = true;
@@ -1407,8 +1427,8 @@ RichString::simplifyWhiteSpace()
 		else if(di != i) // copy other chars
 			operator[](di) = ch;
 
-		if(di != i)
-			m_style->copy(di, 1, *m_style, i);
+		newStyle.replace(di, newStyle.length() - di, 1);
+		newStyle.fill(di, 1, m_style->at(i));
 
 		lastWasLineFeed = at(di) == QChar::LineFeed;
 		lastWasSpace = lastWasLineFeed || at(di) == QChar::Space;
@@ -1418,6 +1438,83 @@ RichString::simplifyWhiteSpace()
 	if(lastWasLineFeed)
 		di--;
 	truncate(di);
+	if(di >= 0)
+		newStyle.replace(di, newStyle.length() - di, 0);
+	m_style->swap(newStyle, false);
+}
+
+uint
+RichString::styleHash() const
+{
+	uint h = qHash(m_style->m_length);
+	const auto combine = [&h](uint v){ h ^= v + 0x9e3779b9 + (h << 6) + (h >> 2); };
+	for(const RichStringStyle::Span &s: m_style->m_spans) {
+		combine(qHash(s.start));
+		combine(qHash(s.style.flags()));
+		combine(qHash(s.style.color()));
+		combine(qHash(s.style.klass()));
+		combine(qHash(s.style.voice()));
+	}
+	return h;
+}
+
+bool
+RichString::isIdentical(const RichString &other) const
+{
+	if(static_cast<const QString &>(*this) != static_cast<const QString &>(other))
+		return false;
+	const RichStringStyle &a = *m_style;
+	const RichStringStyle &b = *other.m_style;
+	if(a.m_length != b.m_length || a.m_spans.size() != b.m_spans.size())
+		return false;
+	for(int i = 0, n = a.m_spans.size(); i < n; i++) {
+		const RichStringStyle::Span &sa = a.m_spans.at(i);
+		const RichStringStyle::Span &sb = b.m_spans.at(i);
+		if(sa.start != sb.start || sa.style != sb.style)
+			return false;
+	}
+	return a.m_classList == b.m_classList && a.m_voiceList == b.m_voiceList;
+}
+
+namespace {
+struct InternTable {
+	QMutex mutex;
+	QMultiHash<uint, RichString> strings;
+	int pruneSize = 1024;
+};
+}
+
+RichString
+RichString::intern(const RichString &string)
+{
+	if(string.isEmpty())
+		return string;
+
+	static InternTable table;
+	const uint hash = qHash(static_cast<const QString &>(string)) ^ string.styleHash();
+
+	QMutexLocker l(&table.mutex);
+	for(auto it = table.strings.constFind(hash); it != table.strings.cend() && it.key() == hash; ++it) {
+		if(it->isIdentical(string))
+			return *it;
+	}
+
+	if(table.strings.size() >= table.pruneSize) {
+		// drop strings that nobody besides the table uses anymore
+		for(auto it = table.strings.begin(); it != table.strings.end();) {
+			if(it->QString::isDetached())
+				it = table.strings.erase(it);
+			else
+				++it;
+		}
+		table.pruneSize = qMax(1024, table.strings.size() * 2);
+	}
+
+	// keep compact private copy, the passed string might have extra capacity or point to raw data
+	RichString str(string);
+	str.QString::operator=(QString(string.constData(), string.length()));
+	table.strings.insert(hash, str);
+	return str;
 }
 
 bool
@@ -1426,7 +1523,7 @@ RichString::operator!=(const RichString &richstring) const
 	if(!(static_cast<const QString &>(*this) == static_cast<const QString &>(richstring)))
 		return true;
 
-	for(int i = 0, sz = length(); i < sz; i++) {
+	for(int i = 0, sz = length(); i < sz; i = qMin(m_style->spanEnd(i), richstring.m_style->spanEnd(i))) {
 		const RichStyle &s1 = m_style->at(i);
 		const RichStyle &s2 = richstring.m_style->at(i);
 		if(s1.flags() != s2.flags())
@@ -1635,7 +1732,9 @@ ReplaceHelper::replace(const MatchRefList &matchList, RichString &str, const T &
 	const int newLength = matchList.back().length; // last entry contains total lengths
 	QString newString;
 	newString.reserve(newLength);
-	RichStringStyle newStyle(newLength);
+	// keep voice/class lists of str so its styles can be filled in directly
+	RichStringStyle newStyle(*str.m_style);
+	newStyle.replace(0, newStyle.length(), 0);
 	int startNew = 0;
 	int strStyleOffset = -1;
 	for(const MatchRef &md: matchList) {
@@ -1643,11 +1742,13 @@ ReplaceHelper::replace(const MatchRefList &matchList, RichString &str, const T &
 			continue;
 		if(md.ref == md.SUBJECT) {
 			newString.append(QStringView(str).mid(md.offset, md.length));
+			newStyle.insert(startNew, md.length);
 			newStyle.copy(startNew, md.length, *str.m_style, md.offset);
 			startNew += md.length;
 			strStyleOffset = md.offset + md.length;
 		} else if(md.ref == md.REPLACEMENT) {
 			newString.append(QStringView(replacement).mid(md.offset, md.length));
+			newStyle.insert(startNew, md.length);
 			if(std::is_same<decltype(replacement), const RichString &>::value)
 				newStyle.copy(startNew, md.length, *static_cast<const RichString &>(replacement).m_style, md.offset);
 			else
@@ -1656,5 +1757,5 @@ ReplaceHelper::replace(const MatchRefList &matchList, RichString &str, const T &
 		}
 	}
 	str.swap(newString);
-	str.m_style->swap(newStyle, false);
+	str.m_style->swap(newStyle, true);
 }
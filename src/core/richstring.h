@@ -166,6 +166,16 @@ public:
 	static void simplifyWhiteSpace(QString &text);
 	void simplifyWhiteSpace();
 
+	/**
+	 * @brief Look up identical string (same text and styles) in the intern table, add it if not found
+	 * @return string sharing text and style data with all other interned copies
+	 */
+	static RichString intern(const RichString &string);
+	/**
+	 * @return true if both strings use same text data - interned strings with equal text do
+	 */
+	inline bool isSharedWith(const RichString &other) const { return constData() == other.constData() && length() == other.length(); }
+
 	inline bool operator==(const RichString &richstring) const { return !operator!=(richstring); }
 	bool operator!=(const RichString &richstring) const;
 
@@ -173,6 +183,8 @@ public:
 
 private:
 	inline int length(int index, int len) const { return len < 0 || (index + len) > length() ? length() - index : len; }
+	uint styleHash() const;
+	bool isIdentical(const RichString &other) const;
 
 private:
 	friend QDataStream & ::operator<<(QDataStream &stream, const RichString &string);
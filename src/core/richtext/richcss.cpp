@@ -6,7 +6,13 @@
 
 #include "richcss.h"
 
+#include "helpers/common.h"
+
+#include <QAtomicInteger>
+#include <QBrush>
+#include <QColor>
 #include <QDebug>
+#include <QFont>
 #include <QStringBuilder>
 
 using namespace SubtitleComposer;
@@ -21,15 +27,19 @@ public:
 
 typedef bool (*charCompare)(QChar ch);
 
+static QAtomicInteger<quint64> s_nextRevision(1);
+
 RichCSS::RichCSS(QObject *parent)
-	: QObject(parent)
+	: QObject(parent),
+	  m_revision(s_nextRevision.fetchAndAddRelaxed(1))
 {
 }
 
 RichCSS::RichCSS(RichCSS &other)
 	: QObject(),
 	  m_unformatted(other.m_unformatted),
-	  m_stylesheet(other.m_stylesheet)
+	  m_stylesheet(other.m_stylesheet),
+	  m_revision(s_nextRevision.fetchAndAddRelaxed(1))
 {
 }
 
@@ -38,6 +48,7 @@ RichCSS::operator=(const RichCSS &rhs)
 {
 	m_unformatted = rhs.m_unformatted;
 	m_stylesheet = rhs.m_stylesheet;
+	nextRevision();
 	return *this;
 }
 
@@ -75,6 +86,7 @@ RichCSS::clear()
 {
 	m_stylesheet.clear();
 	m_unformatted.clear();
+	nextRevision();
 	emit changed();
 }
 
@@ -117,6 +129,7 @@ RichCSS::parse(const QChar *css)
 
 	m_unformatted.append(cssStart, css - cssStart);
 
+	nextRevision();
 	emit changed();
 }
 
@@ -384,8 +397,14 @@ RichCSS::mergeCssRules(RuleList &base, const RuleList &override) const
 	base.append(override);
 }
 
+void
+RichCSS::nextRevision()
+{
+	m_revision = s_nextRevision.fetchAndAddRelaxed(1);
+}
+
 QMap<QByteArray, QString>
-RichCSS::match(QSet<QString> selectors) const
+RichCSS::match(const QSet<QString> &selectors) const
 {
 	QMap<QByteArray, QString> styles;
 	for(const Block &b: qAsConst(m_stylesheet)) {
@@ -425,6 +444,48 @@ RichCSS::match(QSet<QString> selectors) const
 	return styles;
 }
 
+QTextCharFormat
+RichCSS::charFormat(const QSet<QString> &selectors) const
+{
+	QTextCharFormat fmt;
+	const QMap<QByteArray, QString> styles = match(selectors);
+	for(auto it = styles.cbegin(); it != styles.cend(); ++it) {
+		if(it.key() == "font-weight") {
+			static const QMap<QString, QFont::Weight> wm = {
+				{ $("normal"), QFont::Normal },
+				{ $("bold"), QFont::Bold },
+				{ $("100"), QFont::Thin },
+				{ $("200"), QFont::ExtraLight },
+				{ $("300"), QFont::Light },
+				{ $("400"), QFont::Normal },
+				{ $("500"), QFont::Medium },
+				{ $("600"), QFont::DemiBold },
+				{ $("700"), QFont::Bold },
+				{ $("800"), QFont::ExtraBold },
+				{ $("900"), QFont::Black },
+			};
+			auto iw = wm.find(it.value());
+			if(iw != wm.cend())
+				fmt.setFontWeight(iw.value());
+		} else if(it.key() == "font-style") {
+			fmt.setFontItalic(it.value() != $("normal"));
+		} else if(it.key() == "text-decoration") {
+			fmt.setFontUnderline(it.value() == $("underline"));
+			fmt.setFontStrikeOut(it.value() == $("line-through"));
+		} else if(it.key() == "color") {
+			QColor color;
+			color.setNamedColor(it.value());
+			fmt.setForeground(QBrush(color));
+		} else if(it.key() == "background-color") {
+			QColor color;
+			color.setNamedColor(it.value());
+			fmt.setBackground(QBrush(color));
+		}
+		// TODO: check what else WebVTT requires
+	}
+	return fmt;
+}
+
 QSet<QString>
 RichCSS::classes() const
 {
@@ -13,6 +13,7 @@
 #include <QSet>
 #include <QString>
 #include <QStringList>
+#include <QTextCharFormat>
 #include <QVector>
 
 #include <list>
@@ -47,7 +48,21 @@ public:
 
 	void clear();
 
-	QMap<QByteArray, QString> match(QSet<QString> selectors) const;
+	/**
+	 * @brief Number that changes whenever stylesheet does, unique among all stylesheets
+	 * Results of match() and charFormat() can be cached by it.
+	 */
+	inline quint64 revision() const { return m_revision; }
+
+	/**
+	 * @brief Rules of all blocks matching selectors
+	 */
+	QMap<QByteArray, QString> match(const QSet<QString> &selectors) const;
+	/**
+	 * @brief Character format with properties set by rules matching selectors
+	 *        Meant to be merged over the base format
+	 */
+	QTextCharFormat charFormat(const QSet<QString> &selectors) const;
 
 	/**
 	 * @return list of all defined classes
@@ -65,9 +80,12 @@ private:
 
 	void mergeCssRules(RuleList &base, const RuleList &override) const;
 
+	void nextRevision();
+
 private:
 	QString m_unformatted;
 	Stylesheet m_stylesheet;
+	quint64 m_revision;
 };
 }
 
@@ -10,7 +10,10 @@
 #include "core/richtext/richdom.h"
 #include "helpers/common.h"
 
+#include <climits>
+
 #include <QApplication>
+#include <QAtomicInteger>
 #include <QPainter>
 #include <QSharedPointer>
 #include <QSet>
@@ -35,6 +38,8 @@
 
 using namespace SubtitleComposer;
 
+static QAtomicInteger<quint64> s_nextSerial(1);
+
 struct REStringCapture { int pos; int len; int no; };
 Q_DECLARE_TYPEINFO(REStringCapture, Q_PRIMITIVE_TYPE);
 
@@ -66,8 +71,9 @@ RichDocument::RichDocument(QObject *parent)
 	: QTextDocument(parent),
 	  m_undoableCursor(this),
 	  m_stylesheet(nullptr),
-	  m_domDirty(true),
-	  m_dom(new RichDOM)
+	  m_domDirtyFrom(0),
+	  m_dom(new RichDOM),
+	  m_serial(s_nextSerial.fetchAndAddRelaxed(1))
 {
 	setUndoRedoEnabled(true);
 
@@ -80,10 +86,10 @@ RichDocument::RichDocument(QObject *parent)
 
 	setDocumentLayout(new RichDocumentLayout(this));
 
-	connect(this, &RichDocument::contentsChanged, this, [&](){
-		m_domDirty = true;
-		emit domChanged();
+	connect(this, &RichDocument::contentsChange, this, [&](int from, int, int){
+		m_domDirtyFrom = qMin(m_domDirtyFrom, from);
 	});
+	connect(this, &RichDocument::contentsChanged, this, &RichDocument::domChanged);
 }
 
 RichDocument::~RichDocument()
@@ -860,9 +866,9 @@ RichDocument::replace(int index, int len, const QString &replacement)
 RichDOM *
 RichDocument::dom()
 {
-	if(m_domDirty) {
-		m_dom->update(this);
-		m_domDirty = false;
+	if(m_domDirtyFrom != INT_MAX) {
+		m_dom->update(this, m_domDirtyFrom);
+		m_domDirtyFrom = INT_MAX;
 	}
 	return m_dom;
 }
@@ -870,17 +876,14 @@ RichDocument::dom()
 RichDOM::Node *
 RichDocument::nodeAt(quint32 pos, RichDOM::Node *root)
 {
-	RichDOM::Node *n = (root ? root : dom()->m_root)->children;
-	while(n) {
-		if(pos >= n->nodeStart && pos < n->nodeEnd) {
-			RichDOM::Node *s;
-			if(n->children && (s = nodeAt(pos, n)))
-				return s;
-			break;
-		}
-		n = n->next;
+	RichDOM::Node *n = dom()->nodeAt(pos);
+	if(!root || n == root)
+		return root ? nullptr : n;
+	for(RichDOM::Node *p = n ? n->parent : nullptr; p; p = p->parent) {
+		if(p == root)
+			return n;
 	}
-	return n;
+	return nullptr;
 }
 
 QString
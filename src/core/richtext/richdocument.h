@@ -76,6 +76,22 @@ public:
 
 	inline QTextCursor *undoableCursor() { return &m_undoableCursor; }
 
+	/**
+	 * @brief Keep document from being released by its line, see RichDocumentPtr
+	 */
+	inline void pin() const { m_pins++; }
+	inline void unpin() const { Q_ASSERT(m_pins > 0); m_pins--; }
+	inline bool isPinned() const { return m_pins > 0; }
+	/**
+	 * @brief Undo actions that step through document's own undo history, the last one to go can clear it
+	 */
+	inline void holdHistory() const { m_historyHolds++; }
+	inline bool releaseHistory() const { Q_ASSERT(m_historyHolds > 0); return --m_historyHolds == 0; }
+	/**
+	 * @brief Number unique to this document for the whole session, address of released document gets reused
+	 */
+	inline quint64 serial() const { return m_serial; }
+
 	void setStylesheet(const RichCSS *css);
 	inline const RichCSS *stylesheet() const { return m_stylesheet; }
 
@@ -101,8 +117,11 @@ private:
 private:
 	QTextCursor m_undoableCursor;
 	const RichCSS *m_stylesheet;
-	bool m_domDirty;
+	int m_domDirtyFrom;
 	RichDOM *m_dom;
+	mutable int m_pins = 0;
+	mutable int m_historyHolds = 0;
+	const quint64 m_serial;
 
 	void applyChanges(const void *changeList);
 
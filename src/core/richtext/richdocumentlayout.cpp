@@ -17,6 +17,7 @@
 #include <QFont>
 #include <QFontMetrics>
 #include <QGuiApplication>
+#include <QHash>
 #include <QPainter>
 #include <QSet>
 #include <QStringBuilder>
@@ -38,6 +39,44 @@ RichDocumentLayout::RichDocumentLayout(RichDocument *doc)
 {
 }
 
+namespace {
+/**
+ * @brief Identifies CSS format of a text fragment by stylesheet revision and interned selectors
+ */
+struct CSSFormatKey {
+	quint64 revision;
+	quint64 classes; // bit per interned class id
+	qint32 voice; // interned voice id, -1 if none
+	quint8 styles;
+
+	inline bool operator==(const CSSFormatKey &other) const {
+		return revision == other.revision && classes == other.classes && voice == other.voice && styles == other.styles;
+	}
+};
+
+inline uint
+qHash(const CSSFormatKey &key, uint seed = 0)
+{
+	return ::qHash(key.revision, seed) ^ ::qHash(key.classes, seed) * 31 ^ ::qHash((uint(key.voice) << 8) | key.styles, seed);
+}
+
+enum { SelBold = 1, SelItalic = 2, SelUnderline = 4, SelStrikeOut = 8, SelClass = 16 };
+}
+
+// CSS formats kept for all stylesheets together, entries of old revisions go away when it's full
+#define CSS_FORMAT_CACHE_SIZE 1000
+
+static int
+internId(QHash<QString, int> *ids, const QString &name)
+{
+	auto it = ids->constFind(name);
+	if(it != ids->cend())
+		return it.value();
+	const int id = ids->size();
+	ids->insert(name, id);
+	return id;
+}
+
 QTextCharFormat
 RichDocumentLayout::applyCSS(const QTextCharFormat &format) const
 {
@@ -46,62 +85,74 @@ RichDocumentLayout::applyCSS(const QTextCharFormat &format) const
 	if(!css)
 		return fmt;
 
-	QSet<QString> selectors;
+	// layouts run on any thread that owns a document, each one gets its own cache
+	thread_local QHash<QString, int> classIds;
+	thread_local QHash<QString, int> voiceIds;
+	thread_local QHash<CSSFormatKey, QTextCharFormat> formatCache;
+
+	CSSFormatKey key{css->revision(), 0, -1, 0};
+	bool cacheable = true;
 	if(format.fontWeight() == QFont::Bold)
-		selectors << $("b");
+		key.styles |= SelBold;
 	if(format.fontItalic())
-		selectors << $("i");
+		key.styles |= SelItalic;
 	if(format.fontUnderline())
-		selectors << $("u");
+		key.styles |= SelUnderline;
 	if(format.fontStrikeOut())
-		selectors << $("s");
+		key.styles |= SelStrikeOut;
+	QSet<QString> classes;
 	if(format.hasProperty(RichDocument::Class)) {
+		key.styles |= SelClass;
+		classes = format.property(RichDocument::Class).value<QSet<QString>>();
+		for(const QString &c: qAsConst(classes)) {
+			const int id = internId(&classIds, c);
+			if(id < 64)
+				key.classes |= Q_UINT64_C(1) << id;
+			else
+				cacheable = false;
+		}
+	}
+	QString voice;
+	if(format.hasProperty(RichDocument::Voice)) {
+		voice = format.property(RichDocument::Voice).toString();
+		key.voice = internId(&voiceIds, voice);
+	}
+
+	if(cacheable) {
+		auto it = formatCache.constFind(key);
+		if(it != formatCache.cend()) {
+			fmt.merge(it.value());
+			return fmt;
+		}
+	}
+
+	QSet<QString> selectors;
+	if(key.styles & SelBold)
+		selectors << $("b");
+	if(key.styles & SelItalic)
+		selectors << $("i");
+	if(key.styles & SelUnderline)
+		selectors << $("u");
+	if(key.styles & SelStrikeOut)
+		selectors << $("s");
+	if(key.styles & SelClass) {
 		selectors << $("c");
-		const QSet<QString> cl = format.property(RichDocument::Class).value<QSet<QString>>();
-		for(const QString &c: cl)
+		for(const QString &c: qAsConst(classes))
 			selectors << QChar('.') % c;
 	}
-	if(format.hasProperty(RichDocument::Voice)) {
+	if(key.voice != -1) {
 		selectors << $("v");
-		selectors << $("v[voice=") % format.property(RichDocument::Voice).toString() % $("]");
-		selectors << $("v[voice=\"") % format.property(RichDocument::Voice).toString() % $("\"]");
+		selectors << $("v[voice=") % voice % $("]");
+		selectors << $("v[voice=\"") % voice % $("\"]");
 	}
 
-	QMap<QByteArray, QString> styles = css->match(selectors);
-	for(auto it = styles.cbegin(); it != styles.cend(); ++it) {
-		if(it.key() == "font-weight") {
-			static const QMap<QString, QFont::Weight> wm = {
-				{ $("normal"), QFont::Normal },
-				{ $("bold"), QFont::Bold },
-				{ $("100"), QFont::Thin },
-				{ $("200"), QFont::ExtraLight },
-				{ $("300"), QFont::Light },
-				{ $("400"), QFont::Normal },
-				{ $("500"), QFont::Medium },
-				{ $("600"), QFont::DemiBold },
-				{ $("700"), QFont::Bold },
-				{ $("800"), QFont::ExtraBold },
-				{ $("900"), QFont::Black },
-			};
-			auto iw = wm.find(it.value());
-			if(iw != wm.cend())
-				fmt.setFontWeight(iw.value());
-		} else if(it.key() == "font-style") {
-			fmt.setFontItalic(it.value() != $("normal"));
-		} else if(it.key() == "text-decoration") {
-			fmt.setFontUnderline(it.value() == $("underline"));
-			fmt.setFontStrikeOut(it.value() == $("line-through"));
-		} else if(it.key() == "color") {
-			QColor color;
-			color.setNamedColor(it.value());
-			fmt.setForeground(QBrush(color));
-		} else if(it.key() == "background-color") {
-			QColor color;
-			color.setNamedColor(it.value());
-			fmt.setBackground(QBrush(color));
-		}
-		// TODO: check what else WebVTT requires
+	const QTextCharFormat cssFormat = css->charFormat(selectors);
+	if(cacheable) {
+		if(formatCache.size() >= CSS_FORMAT_CACHE_SIZE)
+			formatCache.clear();
+		formatCache.insert(key, cssFormat);
 	}
+	fmt.merge(cssFormat);
 	return fmt;
 }
 
@@ -13,13 +13,30 @@ RichDocumentPtr::RichDocumentPtr(RichDocument *doc)
 	: m_doc(doc)
 {
 	qRegisterMetaType<RichDocumentPtr>("RichDocumentPtr");
+	if(m_doc)
+		m_doc->pin();
 }
 
 RichDocumentPtr::RichDocumentPtr(const RichDocumentPtr &other)
 	: m_doc(other.m_doc)
 {
+	if(m_doc)
+		m_doc->pin();
 }
 
 RichDocumentPtr::~RichDocumentPtr()
 {
+	if(m_doc)
+		m_doc->unpin();
+}
+
+RichDocumentPtr &
+RichDocumentPtr::operator=(const RichDocumentPtr &other)
+{
+	if(other.m_doc)
+		other.m_doc->pin();
+	if(m_doc)
+		m_doc->unpin();
+	m_doc = other.m_doc;
+	return *this;
 }
@@ -0,0 +1,40 @@
+/*
+    SPDX-FileCopyrightText: 2020-2022 Mladen Milinkovic <max@smoothware.net>
+
+    SPDX-License-Identifier: GPL-2.0-or-later
+*/
+
+#ifndef RICHDOCUMENTPTR_H
+#define RICHDOCUMENTPTR_H
+
+#include "core/richtext/richdocument.h"
+
+#include <QPointer>
+
+namespace SubtitleComposer {
+
+/**
+ * @brief Pinning reference to a RichDocument
+ * Line documents that are not pinned can be released by their line once control returns to the event loop,
+ * anything that keeps a document for longer than that has to hold it through this pointer.
+ */
+class RichDocumentPtr {
+public:
+	explicit RichDocumentPtr(RichDocument *doc=nullptr);
+	RichDocumentPtr(const RichDocumentPtr &other);
+	virtual ~RichDocumentPtr();
+
+	inline RichDocument * data() const { return m_doc.data(); }
+	inline RichDocument * operator->() const { return m_doc.data(); }
+	inline operator RichDocument *() const { return m_doc.data(); }
+	RichDocumentPtr & operator=(const RichDocumentPtr &other);
+
+private:
+	QPointer<RichDocument> m_doc;
+};
+
+}
+
+Q_DECLARE_METATYPE(SubtitleComposer::RichDocumentPtr)
+
+#endif // RICHDOCUMENTPTR_H
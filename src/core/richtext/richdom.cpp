@@ -9,6 +9,7 @@
 #include "core/richtext/richdocument.h"
 #include "helpers/common.h"
 
+#include <algorithm>
 #include <stack>
 
 #include <QStringBuilder>
@@ -21,6 +22,7 @@ using namespace SubtitleComposer;
 RichDOM::RichDOM()
 	: m_root(new Node())
 {
+	m_root->nodeStart = m_root->nodeEnd = 0;
 }
 
 RichDOM::~RichDOM()
@@ -139,8 +141,44 @@ nodeClose(RichDOM::Node *last, int pos, RichDOM::NodeType type, const QString &k
 	return last;
 }
 
+RichDOM::Node *
+RichDOM::truncate(quint32 pos)
+{
+	// drop index entries and nodes starting at or after pos
+	const auto ie = std::lower_bound(m_index.begin(), m_index.end(), pos,
+			[](const IndexEntry &e, quint32 p){ return e.pos < p; });
+	m_index.erase(ie, m_index.end());
+
+	// nodes that start after pos can only be found after open nodes' children that start before pos
+	Node *last = m_index.isEmpty() ? m_root : m_index.last().node;
+	for(Node *n = last; n; n = n->parent) {
+		Node **child = &n->children;
+		while(*child && (*child)->nodeStart < pos)
+			child = &(*child)->next;
+		delete *child;
+		*child = nullptr;
+	}
+	return last;
+}
+
+static QTextCharFormat
+formatBefore(const RichDocument *doc, int pos)
+{
+	for(QTextBlock bi = doc->findBlock(pos - 1); bi.isValid(); bi = bi.previous()) {
+		QTextFragment last;
+		for(QTextBlock::iterator it = bi.begin(); !it.atEnd(); ++it) {
+			const QTextFragment &f = it.fragment();
+			if(f.isValid() && f.position() < pos)
+				last = f;
+		}
+		if(last.isValid())
+			return last.charFormat();
+	}
+	return QTextCharFormat();
+}
+
 void
-RichDOM::update(const RichDocument *doc)
+RichDOM::update(const RichDocument *doc, int from)
 {
 	bool fB = false;
 	bool fI = false;
@@ -150,17 +188,36 @@ RichDOM::update(const RichDocument *doc)
 	QSet<QString> fClass;
 	QString fVoice; // <v:speaker name> - can't be nested... right? No need for QSet<QString>
 
-	delete m_root;
-	m_root = new Node(Root);
-	m_root->nodeStart = 0;
+	Node *last;
+	QTextBlock bi;
+
+	if(from <= 0 || m_index.isEmpty()) {
+		delete m_root;
+		m_root = new Node(Root);
+		m_root->nodeStart = 0;
+		m_index.clear();
 
-	Node *last = m_root;
+		last = m_root;
+		bi = doc->begin();
+		from = 0;
+	} else {
+		// nodes before from are unchanged, continue building from state at that position
+		last = truncate(from);
+		const QTextCharFormat format = formatBefore(doc, from);
+		fB = format.fontWeight() == QFont::Bold;
+		fI = format.fontItalic();
+		fU = format.fontUnderline();
+		fS = format.fontStrikeOut();
+		fC = format.foreground().style() != Qt::NoBrush ? format.foreground().color().toRgb().rgb() : 0;
+		fClass = format.property(RichDocument::Class).value<QSet<QString>>();
+		fVoice = format.property(RichDocument::Voice).value<QString>();
+		bi = doc->findBlock(from);
+	}
 
-	QTextBlock bi = doc->begin();
-	for(;;) {
+	for(; bi.isValid(); bi = bi.next()) {
 		for(QTextBlock::iterator it = bi.begin(); !it.atEnd(); ++it) {
 			const QTextFragment &f = it.fragment();
-			if(!f.isValid())
+			if(!f.isValid() || f.position() + f.length() <= from)
 				continue;
 			const QTextCharFormat &format = f.charFormat();
 			const QSet<QString> &cl = format.property(RichDocument::Class).value<QSet<QString>>();
@@ -216,19 +273,30 @@ RichDOM::update(const RichDocument *doc)
 				if((fC = fg))
 					last = nodeOpen(last, f.position(), Font);
 			}
-		}
-		bi = bi.next();
-		if(bi == doc->end()) {
-			const int pos = doc->length();
-			while(last) {
-				// close remaining node
-				last->nodeEnd = pos;
-				last = last->parent;
-			}
-			return;
+			if(m_index.isEmpty() || m_index.last().node != last)
+				m_index.push_back(IndexEntry{quint32(f.position()), last});
 		}
 	}
-	// unreachable
+
+	const int pos = doc->length();
+	while(last) {
+		// close remaining node
+		last->nodeEnd = pos;
+		last = last->parent;
+	}
+}
+
+RichDOM::Node *
+RichDOM::nodeAt(quint32 pos) const
+{
+	if(pos >= m_root->nodeEnd)
+		return nullptr;
+	auto it = std::upper_bound(m_index.cbegin(), m_index.cend(), pos,
+			[](quint32 p, const IndexEntry &e){ return p < e.pos; });
+	if(it == m_index.cbegin())
+		return nullptr;
+	Node *n = (--it)->node;
+	return n == m_root ? nullptr : n;
 }
 
 void
@@ -8,6 +8,7 @@
 #define RICHDOM_H
 
 #include <QString>
+#include <QVector>
 
 namespace SubtitleComposer {
 
@@ -52,11 +53,31 @@ public:
 		Node *children;
 	};
 
-	void update(const RichDocument *doc);
+	/**
+	 * @brief Rebuild the tree after document has changed
+	 * @param doc
+	 * @param from position of first change, everything before it is assumed unchanged
+	 */
+	void update(const RichDocument *doc, int from=0);
+
+	/**
+	 * @return deepest node containing position pos or nullptr if there is none besides root
+	 */
+	Node * nodeAt(quint32 pos) const;
+
+private:
+	Node * truncate(quint32 pos);
 
 private:
 	friend class RichDocument;
 	Node *m_root;
+
+	// deepest open node for each position where it changes, sorted by pos
+	struct IndexEntry {
+		quint32 pos;
+		Node *node;
+	};
+	QVector<IndexEntry> m_index;
 };
 
 }
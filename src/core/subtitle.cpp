@@ -16,15 +16,26 @@
 #include "core/undo/subtitlelineactions.h"
 #include "core/undo/undostack.h"
 #include "helpers/objectref.h"
+#include "helpers/parallel.h"
 #include "gui/treeview/lineswidget.h"
 
 #include <QTextDocumentFragment>
 #include <QTextEdit>
+#include <QThread>
+#include <QTimer>
 
 #include <KLocalizedString>
 
+#include <algorithm>
+#include <numeric>
+
 using namespace SubtitleComposer;
 
+// fewer lines than this are checked on a single thread
+#define MIN_CHECK_CHUNK_SIZE 500
+// lines that may keep their documents around before least recently used ones are released
+#define MAX_LINE_DOCS 2000
+
 double Subtitle::s_defaultFramesPerSecond(23.976);
 
 double
@@ -51,6 +62,12 @@ Subtitle::Subtitle(double framesPerSecond)
 
 Subtitle::~Subtitle()
 {
+	for(SubtitleLine *line = m_docHead; line;) {
+		SubtitleLine *next = line->m_docNext;
+		line->m_docPrev = line->m_docNext = nullptr;
+		line = next;
+	}
+	m_docHead = m_docTail = nullptr;
 	qDeleteAll(m_lines);
 	delete m_formatData;
 }
@@ -79,7 +96,7 @@ Subtitle::setPrimaryData(const Subtitle &from, bool usePrimaryData)
 	const int thisErrors = SubtitleLine::SecondaryOnlyErrors;
 
 	for(SubtitleLine *fromLine = fromIt.current(), *thisLine = thisIt.current(); fromLine && thisLine; ++fromIt, ++thisIt, fromLine = fromIt.current(), thisLine = thisIt.current()) {
-		thisLine->setPrimaryDoc(usePrimaryData ? fromLine->primaryDoc() : fromLine->secondaryDoc());
+		thisLine->resetPrimaryText(usePrimaryData ? fromLine->primaryText() : fromLine->secondaryText());
 		thisLine->setTimes(fromLine->showTime(), fromLine->hideTime());
 		thisLine->setErrorFlags((fromLine->errorFlags() & fromErrors) | (thisLine->errorFlags() & thisErrors));
 		thisLine->setFormatData(fromLine->formatData());
@@ -92,7 +109,7 @@ Subtitle::setPrimaryData(const Subtitle &from, bool usePrimaryData)
 		for(; fromIt.current(); ++fromIt) {
 			const SubtitleLine *cur = fromIt.current();
 			SubtitleLine *thisLine = new SubtitleLine(cur->showTime(), cur->hideTime());
-			thisLine->setPrimaryDoc(usePrimaryData ? cur->primaryDoc() : cur->secondaryDoc());
+			thisLine->resetPrimaryText(usePrimaryData ? cur->primaryText() : cur->secondaryText());
 			thisLine->setErrorFlags(SubtitleLine::SecondaryOnlyErrors, false);
 			thisLine->setFormatData(cur->formatData());
 			thisLine->m_metaData = cur->m_metaData;
@@ -110,6 +127,9 @@ Subtitle::setPrimaryData(const Subtitle &from, bool usePrimaryData)
 		}
 	}
 
+	// metadata and format data were copied directly
+	m_snapshotChunks.clear();
+
 	endCompositeAction();
 }
 
@@ -137,7 +157,7 @@ Subtitle::setSecondaryData(const Subtitle &from, bool usePrimaryData)
 	for(int i = 0, n = qMin(m_lines.size(), from.m_lines.size()); i < n; i++) {
 		const SubtitleLine *srcLine = from.m_lines.at(i).obj();
 		SubtitleLine *dstLine = m_lines.at(i).obj();
-		dstLine->setSecondaryDoc(usePrimaryData ? srcLine->primaryDoc() : srcLine->secondaryDoc());
+		dstLine->resetSecondaryText(usePrimaryData ? srcLine->primaryText() : srcLine->secondaryText());
 		dstLine->setErrorFlags((dstLine->errorFlags() & dstErrors) | (srcLine->errorFlags() & srcErrors));
 	}
 
@@ -153,13 +173,16 @@ Subtitle::setSecondaryData(const Subtitle &from, bool usePrimaryData)
 	for(int i = m_lines.size(), n = from.m_lines.size(); i < n; i++) {
 		const SubtitleLine *srcLine = from.m_lines.at(i).obj();
 		SubtitleLine *dstLine = new SubtitleLine(srcLine->showTime(), srcLine->hideTime());
-		dstLine->setSecondaryDoc(usePrimaryData ? srcLine->primaryDoc() : srcLine->secondaryDoc());
+		dstLine->resetSecondaryText(usePrimaryData ? srcLine->primaryText() : srcLine->secondaryText());
 		dstLine->setErrorFlags(SubtitleLine::PrimaryOnlyErrors, false);
 		newLines.append(dstLine);
 	}
 	if(!newLines.isEmpty())
 		processAction(new InsertLinesAction(this, newLines));
 
+	// metadata and format data were copied directly
+	m_snapshotChunks.clear();
+
 	endCompositeAction(UndoStack::Secondary);
 }
 
@@ -187,6 +210,25 @@ Subtitle::clearPrimaryDirty()
 	emit primaryDirtyStateChanged(false);
 }
 
+void
+Subtitle::primarySaveStarted()
+{
+	m_primarySaveIndex = appUndoStack()->index();
+}
+
+void
+Subtitle::primarySaveFinished(bool success)
+{
+	if(!success)
+		return;
+
+	m_primaryCleanIndex = m_primarySaveIndex;
+	if(m_primaryDirtyState != isPrimaryDirty(appUndoStack()->index())) {
+		m_primaryDirtyState = !m_primaryDirtyState;
+		emit primaryDirtyStateChanged(m_primaryDirtyState);
+	}
+}
+
 void
 Subtitle::clearSecondaryDirty()
 {
@@ -198,6 +240,25 @@ Subtitle::clearSecondaryDirty()
 	emit secondaryDirtyStateChanged(false);
 }
 
+void
+Subtitle::secondarySaveStarted()
+{
+	m_secondarySaveIndex = appUndoStack()->index();
+}
+
+void
+Subtitle::secondarySaveFinished(bool success)
+{
+	if(!success)
+		return;
+
+	m_secondaryCleanIndex = m_secondarySaveIndex;
+	if(m_secondaryDirtyState != isSecondaryDirty(appUndoStack()->index())) {
+		m_secondaryDirtyState = !m_secondaryDirtyState;
+		emit secondaryDirtyStateChanged(m_secondaryDirtyState);
+	}
+}
+
 FormatData *
 Subtitle::formatData() const
 {
@@ -240,17 +301,8 @@ Subtitle::changeFramesPerSecond(double toFramesPerSecond, double fromFramesPerSe
 
 	double scaleFactor = fromFramesPerSecond / toFramesPerSecond;
 
-	if(scaleFactor != 1.0) {
-		for(SubtitleIterator it(*this, Range::full()); it.current(); ++it) {
-			Time showTime = it.current()->showTime();
-			showTime *= scaleFactor;
-
-			Time hideTime = it.current()->hideTime();
-			hideTime *= scaleFactor;
-
-			processAction(new SetLineTimesAction(it, showTime, hideTime));
-		}
-	}
+	if(scaleFactor != 1.0)
+		transformLineTimes(0, m_lines.count() - 1, 0., scaleFactor, i18n("Change Frame Rate"));
 
 	endCompositeAction();
 }
@@ -266,6 +318,57 @@ Subtitle::line(int index) const
 {
 	return index < 0 || index >= m_lines.count() ? nullptr : m_lines.at(index).obj();
 }
+
+void
+Subtitle::updateTimeIndex(const SubtitleLine *line)
+{
+	const int index = line->index();
+	updateTimeIndex(index, index);
+}
+
+void
+Subtitle::updateTimeIndex(int firstIndex, int lastIndex)
+{
+	Q_ASSERT(m_timeIndex.count() == m_lines.count());
+	firstIndex = qMax(firstIndex, 0);
+	lastIndex = qMin(lastIndex, m_timeIndex.count() - 1);
+	if(firstIndex > lastIndex)
+		return;
+	if(firstIndex == lastIndex) {
+		m_timeIndex.update(firstIndex, m_showTimes.at(firstIndex), m_hideTimes.at(firstIndex));
+		return;
+	}
+	// ranges are set first, so shared nodes are pulled once
+	for(int i = firstIndex; i <= lastIndex; i++)
+		m_timeIndex.set(i, m_showTimes.at(i), m_hideTimes.at(i));
+	m_timeIndex.build(firstIndex, lastIndex);
+}
+
+/**
+ * @brief Lines visible at any moment of [@p startTime, @p endTime], in subtitle order
+ */
+QVector<SubtitleLine *>
+Subtitle::linesIntersecting(const Time &startTime, const Time &endTime)
+{
+	QVector<int> indexes;
+	m_timeIndex.intersecting(startTime.toMillis(), endTime.toMillis(), &indexes);
+
+	QVector<SubtitleLine *> lines;
+	lines.reserve(indexes.size());
+	for(int index : qAsConst(indexes))
+		lines.append(m_lines.at(index).obj());
+	return lines;
+}
+
+/**
+ * @brief Earliest show time of lines after @p index, infinity if there are none
+ */
+double
+Subtitle::followingShowTime(int index) const
+{
+	return m_timeIndex.minShowTime(index + 1, m_lines.count() - 1);
+}
+
 bool
 Subtitle::hasAnchors() const
 {
@@ -334,14 +437,14 @@ Subtitle::insertIndex(const Time &showTime, int start, int end) const
 {
 	while(end - start > 1) {
 		const int mid = (start + end) / 2;
-		if(showTime < m_lines.at(mid)->showTime())
+		if(showTime < m_showTimes.at(mid))
 			end = mid - 1;
 		else
 			start = mid;
 	}
-	if(m_lines.empty() || showTime < m_lines.at(start)->showTime())
+	if(m_lines.empty() || showTime < m_showTimes.at(start))
 		return start;
-	return showTime < m_lines.at(end)->showTime() ? end : end + 1;
+	return showTime < m_showTimes.at(end) ? end : end + 1;
 }
 
 void
@@ -352,6 +455,58 @@ Subtitle::insertLine(SubtitleLine *line)
 	processAction(new InsertLinesAction(this, lines, insertIndex(line->showTime())));
 }
 
+/**
+ * @brief Insert all @p lines at once, keeping subtitle sorted by show time
+ * Lines with equal show time end up in the same order as if they were inserted one by one with insertLine().
+ * Lines that go between existing ones are appended and moved into place with a single reorder, so listeners
+ * are notified once for the insert and once for the reorder.
+ * @param undoable when false undo stack is bypassed, used by loaders as there's no state before the load
+ */
+void
+Subtitle::insertLines(QList<SubtitleLine *> lines, bool undoable)
+{
+	if(lines.isEmpty())
+		return;
+
+	const auto apply = [this, undoable](UndoAction *action){
+		if(undoable) {
+			processAction(action);
+		} else {
+			action->redo();
+			delete action;
+		}
+	};
+
+	std::stable_sort(lines.begin(), lines.end(), [](const SubtitleLine *l1, const SubtitleLine *l2){
+		return l1->showTime() < l2->showTime();
+	});
+
+	const int oldCount = m_lines.size();
+	const int firstIndex = insertIndex(lines.first()->showTime());
+	if(firstIndex == oldCount) {
+		apply(new InsertLinesAction(this, lines));
+		return;
+	}
+
+	// merge order of existing lines after firstIndex with appended ones, new lines go after existing ones with equal time
+	const int newCount = lines.size();
+	QVector<int> order;
+	order.reserve(oldCount - firstIndex + newCount);
+	for(int i = firstIndex, j = 0; i < oldCount || j < newCount;) {
+		if(j == newCount || (i < oldCount && !(lines.at(j)->showTime().toMillis() < m_showTimes.at(i))))
+			order.append(i++ - firstIndex);
+		else
+			order.append(oldCount + j++ - firstIndex);
+	}
+
+	if(undoable)
+		beginCompositeAction(i18n("Insert Lines"));
+	apply(new InsertLinesAction(this, lines));
+	apply(new SortLinesAction(this, firstIndex, order));
+	if(undoable)
+		endCompositeAction();
+}
+
 void
 Subtitle::insertLine(SubtitleLine *line, int index)
 {
@@ -406,7 +561,7 @@ Subtitle::insertNewLine(int index, bool insertAfter, SubtitleTarget target)
 		SubtitleLine *line = newLine;
 		SubtitleIterator it(*this, Range::full(), false);
 		for(it.toIndex(newLineIndex + 1); it.current(); ++it) {
-			line->secondaryDoc()->setRichText(it.current()->secondaryDoc()->toRichText());
+			line->secondaryDoc()->setRichText(it.current()->secondaryText());
 			line = it.current();
 		}
 		line->secondaryDoc()->clear();
@@ -420,7 +575,7 @@ Subtitle::insertNewLine(int index, bool insertAfter, SubtitleTarget target)
 		SubtitleIterator it(*this, Range::full(), true);
 		SubtitleLine *line = it.current();
 		for(--it; it.index() >= index; --it) {
-			line->secondaryDoc()->setRichText(it.current()->secondaryDoc()->toRichText());
+			line->secondaryDoc()->setRichText(it.current()->secondaryText());
 			line = it.current();
 		}
 		line->secondaryDoc()->clear();
@@ -465,7 +620,7 @@ Subtitle::removeLines(const RangeList &r, SubtitleTarget target)
 		SubtitleIterator srcIt(*this, rangesComplement);
 		SubtitleIterator dstIt(*this, Range::upper(ranges.firstIndex()));
 		for(; srcIt.current() && dstIt.current(); ++srcIt, ++dstIt)
-			dstIt.current()->secondaryDoc()->setRichText(srcIt.current()->secondaryDoc()->toRichText());
+			dstIt.current()->secondaryDoc()->setRichText(srcIt.current()->secondaryText());
 
 		// the remaining lines secondary text must be cleared
 		for(; dstIt.current(); ++dstIt)
@@ -504,7 +659,7 @@ Subtitle::removeLines(const RangeList &r, SubtitleTarget target)
 		SubtitleIterator srcIt(*this, Range(ranges.firstIndex(), m_lines.count() - lines.count() - 1), true);
 		SubtitleIterator dstIt(*this, rangesComplement, true);
 		for(; srcIt.current() && dstIt.current(); --srcIt, --dstIt)
-			dstIt.current()->secondaryDoc()->setRichText(srcIt.current()->secondaryDoc()->toRichText());
+			dstIt.current()->secondaryDoc()->setRichText(srcIt.current()->secondaryText());
 
 		// finally, we can remove the specified lines
 		RangeList::ConstIterator rangesIt = ranges.end(), begin = ranges.begin();
@@ -686,28 +841,27 @@ Subtitle::shiftAnchoredLine(SubtitleLine *anchoredLine, const Time &newShowTime)
 	const SubtitleLine *prevAnchor = nullptr;
 	const SubtitleLine *nextAnchor = nullptr;
 	foreach(auto anchor, m_anchoredLines) {
-		if((prevAnchor == nullptr || prevAnchor->m_showTime < anchor->m_showTime) && anchor->m_showTime < anchoredLine->m_showTime)
+		if((prevAnchor == nullptr || prevAnchor->showTime() < anchor->showTime()) && anchor->showTime() < anchoredLine->showTime())
 			prevAnchor = anchor;
-		if((nextAnchor == nullptr || nextAnchor->m_showTime > anchor->m_showTime) && anchor->m_showTime > anchoredLine->m_showTime)
+		if((nextAnchor == nullptr || nextAnchor->showTime() > anchor->showTime()) && anchor->showTime() > anchoredLine->showTime())
 			nextAnchor = anchor;
 	}
-	if((prevAnchor && prevAnchor->m_showTime > newShowTime) || (nextAnchor && nextAnchor->m_showTime < newShowTime))
+	if((prevAnchor && prevAnchor->showTime() > newShowTime) || (nextAnchor && nextAnchor->showTime() < newShowTime))
 		return;
 
 	if(!prevAnchor && !nextAnchor) {
-		double shift = newShowTime.toMillis() - anchoredLine->m_showTime.toMillis();
-		for(int i = 0, n = count(); i < n; i++)
-			at(i)->shiftTimes(shift);
+		double shift = newShowTime.toMillis() - anchoredLine->showTime().toMillis();
+		transformLineTimes(0, count() - 1, shift, 1.0, i18n("Shift Lines"));
 	} else {
 		// save times as adjustLines() will modify them, and processing nextAnchor will modify them again
-		Time savedShowTime(anchoredLine->m_showTime);
-		Time savedHideTime(anchoredLine->m_hideTime);
+		Time savedShowTime(anchoredLine->showTime());
+		Time savedHideTime(anchoredLine->hideTime());
 		if(prevAnchor) {
-			adjustLines(Range(prevAnchor->index(), anchoredLine->index()), prevAnchor->m_showTime.toMillis(), newShowTime.toMillis());
-		} else if(nextAnchor->m_showTime != anchoredLine->m_showTime) {
+			adjustLines(Range(prevAnchor->index(), anchoredLine->index()), prevAnchor->showTime().toMillis(), newShowTime.toMillis());
+		} else if(nextAnchor->showTime() != anchoredLine->showTime()) {
 			const SubtitleLine *first = firstLine();
-			double scaleFactor = (nextAnchor->m_showTime.toMillis() - newShowTime.toMillis()) / (nextAnchor->m_showTime.toMillis() - anchoredLine->m_showTime.toMillis());
-			Time firstShowTime(scaleFactor * (first->m_showTime.toMillis() - nextAnchor->m_showTime.toMillis()) + nextAnchor->m_showTime.toMillis());
+			double scaleFactor = (nextAnchor->showTime().toMillis() - newShowTime.toMillis()) / (nextAnchor->showTime().toMillis() - anchoredLine->showTime().toMillis());
+			Time firstShowTime(scaleFactor * (first->showTime().toMillis() - nextAnchor->showTime().toMillis()) + nextAnchor->showTime().toMillis());
 			adjustLines(Range(first->index(), anchoredLine->index()), firstShowTime.toMillis(), newShowTime.toMillis());
 		}
 
@@ -715,18 +869,19 @@ Subtitle::shiftAnchoredLine(SubtitleLine *anchoredLine, const Time &newShowTime)
 		const SubtitleLine *last;
 		if(nextAnchor) {
 			last = nextAnchor;
-			lastShowTime = nextAnchor->m_showTime.toMillis();
-		} else if(anchoredLine->m_showTime != prevAnchor->m_showTime) {
+			lastShowTime = nextAnchor->showTime().toMillis();
+		} else if(anchoredLine->showTime() != prevAnchor->showTime()) {
 			last = lastLine();
-			double scaleFactor = (newShowTime.toMillis() - prevAnchor->m_showTime.toMillis()) / (savedShowTime.toMillis() - prevAnchor->m_showTime.toMillis());
-			lastShowTime = scaleFactor * (last->m_showTime.toMillis() - prevAnchor->m_showTime.toMillis()) + prevAnchor->m_showTime.toMillis();
+			double scaleFactor = (newShowTime.toMillis() - prevAnchor->showTime().toMillis()) / (savedShowTime.toMillis() - prevAnchor->showTime().toMillis());
+			lastShowTime = scaleFactor * (last->showTime().toMillis() - prevAnchor->showTime().toMillis()) + prevAnchor->showTime().toMillis();
 		} else {
 			last = nullptr;
 			lastShowTime = 0;
 		}
 		if(newShowTime.toMillis() < lastShowTime && anchoredLine != last) {
-			anchoredLine->m_showTime = savedShowTime;
-			anchoredLine->m_hideTime = savedHideTime;
+			anchoredLine->storeShowTime(savedShowTime);
+			anchoredLine->storeHideTime(savedHideTime);
+			updateTimeIndex(anchoredLine);
 			adjustLines(Range(anchoredLine->index(), last->index()), newShowTime.toMillis(), lastShowTime);
 		}
 	}
@@ -749,8 +904,11 @@ Subtitle::shiftLines(const RangeList &ranges, long msecs)
 			}
 		}
 	} else {
-		for(SubtitleIterator it(*this, ranges); it.current(); ++it)
-			it.current()->shiftTimes(msecs);
+		for(const Range &range : ranges) {
+			if(range.start() >= m_lines.count())
+				break;
+			transformLineTimes(range.start(), normalizeRangeIndex(range.end()), msecs, 1.0, i18n("Shift Lines"));
+		}
 	}
 
 	endCompositeAction();
@@ -794,41 +952,63 @@ Subtitle::adjustLines(const Range &range, long newFirstTime, long newLastTime)
 	if(shiftMseconds == 0 && scaleFactor == 1.0)
 		return;
 
-	beginCompositeAction(i18n("Adjust Lines"));
-
-	for(SubtitleIterator it(*this, range); it.current(); ++it)
-		it.current()->adjustTimes(shiftMseconds, scaleFactor);
-
-	endCompositeAction();
+	transformLineTimes(firstIndex, lastIndex, shiftMseconds, scaleFactor, i18n("Adjust Lines"));
 }
 
+/**
+ * @brief Set times of lines [@p firstIndex, @p lastIndex] to time * @p scaleFactor + @p shiftMseconds with a single action
+ */
 void
-Subtitle::sortLines(const Range &range)
+Subtitle::transformLineTimes(int firstIndex, int lastIndex, double shiftMseconds, double scaleFactor, const QString &description)
 {
-	beginCompositeAction(i18n("Sort"));
+	const int n = lastIndex - firstIndex + 1;
+	if(n <= 0)
+		return;
 
-	SubtitleIterator it(*this, range);
-	SubtitleLine *line = it.current();
-	SubtitleLine *nextLine = (++it).current();
-	for(; nextLine; ++it, line = nextLine, nextLine = it.current()) {
-		if(line->showTime() <= nextLine->showTime()) // already sorted
-			continue;
+	QVector<double> showTimes(n);
+	QVector<double> hideTimes(n);
+	const double *oldShow = m_showTimes.constData() + firstIndex;
+	const double *oldHide = m_hideTimes.constData() + firstIndex;
+	double *newShow = showTimes.data();
+	double *newHide = hideTimes.data();
+	for(int i = 0; i < n; i++) {
+		// same clamping as Time
+		newShow[i] = qMax(0., oldShow[i] * scaleFactor + shiftMseconds);
+		newHide[i] = qMax(0., oldHide[i] * scaleFactor + shiftMseconds);
+	}
 
-		// TODO: could be improved by using insertIndex()
-		SubtitleIterator tmp(it);
-		int fromIndex = tmp.index();
-		int toIndex = -1;
-		while((--tmp).current() && tmp.current()->showTime() > nextLine->showTime())
-			toIndex = tmp.index();
+	processAction(new SetLinesTimesAction(this, firstIndex, showTimes, hideTimes, description));
+}
 
-		Q_ASSERT(toIndex != -1);
+void
+Subtitle::sortLines(const Range &range)
+{
+	const int firstIndex = range.start();
+	const int lastIndex = normalizeRangeIndex(range.end());
+	if(firstIndex >= lastIndex)
+		return;
 
-		processAction(new MoveLineAction(this, fromIndex, toIndex));
+	QVector<int> order(lastIndex - firstIndex + 1);
+	std::iota(order.begin(), order.end(), 0);
+	std::stable_sort(order.begin(), order.end(), [&](int i1, int i2){
+		return m_showTimes.at(firstIndex + i1) < m_showTimes.at(firstIndex + i2);
+	});
+
+	// only store the part of range that actually moves
+	int first = 0;
+	while(first < order.size() && order.at(first) == first)
+		first++;
+	if(first == order.size())
+		return;
+	int last = order.size() - 1;
+	while(order.at(last) == last)
+		last--;
 
-		--it;
-	}
+	QVector<int> moved(last - first + 1);
+	for(int i = first; i <= last; i++)
+		moved[i - first] = order.at(i) - first;
 
-	endCompositeAction();
+	processAction(new SortLinesAction(this, firstIndex + first, moved));
 }
 
 void
@@ -941,17 +1121,20 @@ Subtitle::fixOverlappingLines(const RangeList &ranges, const Time &minInterval)
 		if(rangeStart >= rangeEnd)
 			break;
 
-		SubtitleIterator it(*this, Range(rangeStart, rangeEnd));
-		SubtitleLine *line = it.current();
-		++it;
-		SubtitleLine *nextLine = it.current();
-
-		for(; nextLine; ++it, line = nextLine, nextLine = it.current()) {
-			if(line->hideTime() + minInterval >= nextLine->showTime()) {
-				Time newHideTime = nextLine->showTime() - minInterval;
-				line->setHideTime(newHideTime >= line->showTime() ? newHideTime : line->showTime());
+		const double *showTimes = m_showTimes.constData() + rangeStart;
+		const double *hideTimes = m_hideTimes.constData() + rangeStart;
+		const int n = rangeEnd - rangeStart;
+		QVector<double> newHideTimes = m_hideTimes.mid(rangeStart, n);
+		bool changed = false;
+		for(int i = 0; i < n; i++) {
+			if(hideTimes[i] + minInterval.toMillis() >= showTimes[i + 1]) {
+				const double newHideTime = qMax(0., showTimes[i + 1] - minInterval.toMillis());
+				newHideTimes[i] = qMax(newHideTime, showTimes[i]);
+				changed = changed || newHideTimes.at(i) != hideTimes[i];
 			}
 		}
+		if(changed)
+			processAction(new SetLinesTimesAction(this, rangeStart, m_showTimes.mid(rangeStart, n), newHideTimes, i18n("Fix Overlapping Times")));
 	}
 
 	endCompositeAction();
@@ -1189,14 +1372,14 @@ Subtitle::appendSubtitle(const Subtitle &srcSubtitle, double shiftMsecsBeforeApp
 	for(SubtitleIterator it(srcSubtitle); it.current(); ++it) {
 		SubtitleLine *ln = it.current();
 		SubtitleLine *newLine = new SubtitleLine(ln->showTime() + shiftMsecsBeforeAppend, ln->hideTime() + shiftMsecsBeforeAppend);
-		newLine->primaryDoc()->setDocument(ln->primaryDoc());
-		newLine->secondaryDoc()->setDocument(ln->secondaryDoc());
+		newLine->resetPrimaryText(ln->primaryText());
+		newLine->resetSecondaryText(ln->secondaryText());
 		lines.append(newLine);
 	}
 
 	beginCompositeAction(i18n("Join Subtitles"));
 
-	processAction(new InsertLinesAction(this, lines));
+	insertLines(lines);
 
 	endCompositeAction();
 }
@@ -1226,8 +1409,8 @@ Subtitle::splitSubtitle(Subtitle &dstSubtitle, const Time &splitTime, bool shift
 			}
 
 			SubtitleLine *newLine = new SubtitleLine(newShowTime, ln->hideTime() + shiftTime);
-			newLine->primaryDoc()->setDocument(ln->primaryDoc());
-			newLine->secondaryDoc()->setDocument(ln->secondaryDoc());
+			newLine->resetPrimaryText(ln->primaryText());
+			newLine->resetSecondaryText(ln->secondaryText());
 			if(ln->m_formatData)
 				newLine->m_formatData = new FormatData(*ln->m_formatData);
 
@@ -1242,7 +1425,7 @@ Subtitle::splitSubtitle(Subtitle &dstSubtitle, const Time &splitTime, bool shift
 		dstSubtitle.beginCompositeAction(i18n("Split Subtitles"));
 		if(dstSubtitle.count())
 			dstSubtitle.processAction(new RemoveLinesAction(&dstSubtitle, 0, -1));
-		dstSubtitle.processAction(new InsertLinesAction(&dstSubtitle, lines, 0));
+		dstSubtitle.insertLines(lines);
 		dstSubtitle.endCompositeAction();
 
 		beginCompositeAction(i18n("Split Subtitles"));
@@ -1364,23 +1547,50 @@ Subtitle::clearErrors(const RangeList &ranges, int errorFlags)
 void
 Subtitle::checkErrors(const RangeList &ranges, int errorFlags)
 {
-	beginCompositeAction(i18n("Check Lines Errors"));
-
-	for(SubtitleIterator it(*this, ranges); it.current(); ++it)
-		it.current()->check(errorFlags);
-
-	endCompositeAction();
+	checkLineErrors(ranges, errorFlags, false);
 }
 
 void
 Subtitle::recheckErrors(const RangeList &ranges)
 {
-	beginCompositeAction(i18n("Check Lines Errors"));
+	checkLineErrors(ranges, 0, true);
+}
 
-	for(SubtitleIterator it(*this, ranges); it.current(); ++it)
-		it.current()->check(it.current()->errorFlags());
+void
+Subtitle::checkLineErrors(const RangeList &ranges, int errorFlags, bool recheck)
+{
+	QVector<int> indexes;
+	QVector<SubtitleLine::CheckSnapshot> snapshots;
+	for(SubtitleIterator it(*this, ranges); it.current(); ++it) {
+		indexes.append(it.index());
+		snapshots.append(it.current()->checkSnapshot());
+	}
 
-	endCompositeAction();
+	// each snapshot is only touched by the thread checking it
+	const SubtitleLine::CheckLimits limits = SubtitleLine::checkLimits();
+	SubtitleLine::CheckSnapshot *lines = snapshots.data();
+	QVector<int> newErrorFlags(snapshots.size());
+	int *newFlags = newErrorFlags.data();
+	parallelFor(snapshots.size(), MIN_CHECK_CHUNK_SIZE, [=, &limits](int begin, int end){
+		for(int i = begin; i < end; i++)
+			newFlags[i] = SubtitleLine::check(&lines[i], recheck ? lines[i].errorFlags : errorFlags, limits);
+	});
+
+	QVector<int> changedIndexes;
+	QVector<int> changedFlags;
+	for(int i = 0, n = indexes.size(); i < n; i++) {
+		SubtitleLine *line = m_lines.at(indexes.at(i)).obj();
+		// keep text stats calculated by the checks
+		line->m_primaryStats = lines[i].primaryStats;
+		line->m_secondaryStats = lines[i].secondaryStats;
+		if(line->m_errorFlags != newFlags[i]) {
+			changedIndexes.append(indexes.at(i));
+			changedFlags.append(newFlags[i]);
+		}
+	}
+
+	if(!changedIndexes.isEmpty())
+		processAction(new SetLinesErrorsAction(this, changedIndexes, changedFlags));
 }
 
 void
@@ -1399,47 +1609,228 @@ Subtitle::beginCompositeAction(const QString &title) const
 {
 	if(appSubtitle() == this)
 		appUndoStack()->beginMacro(title);
+	if(!m_batchLevel)
+		emit const_cast<Subtitle *>(this)->compositeActionStart();
+	beginChangeBatch();
 }
 
 void
 Subtitle::endCompositeAction(UndoStack::DirtyMode dirtyOverride) const
 {
+	endChangeBatch();
+	if(!m_batchLevel)
+		emit const_cast<Subtitle *>(this)->compositeActionEnd();
 	if(appSubtitle() == this)
 		appUndoStack()->endMacro(dirtyOverride);
 }
 
+/**
+ * @brief Keep time index, change batch and snapshot on their lines after lines [@p firstIndex, @p lastIndex]
+ * were inserted, removed or reordered
+ * Called by undo actions right after the lines were moved, before the matching signal is emitted.
+ */
+void
+Subtitle::linesInsertedUpdate(int firstIndex, int lastIndex)
+{
+	m_timeIndex.insert(firstIndex, lastIndex - firstIndex + 1);
+	updateTimeIndex(firstIndex, lastIndex);
+	if(m_batchLevel)
+		moveChangeBatch(firstIndex, lastIndex, lastIndex - firstIndex + 1);
+	truncateSnapshot(firstIndex);
+}
+
+void
+Subtitle::linesRemovedUpdate(int firstIndex, int lastIndex)
+{
+	m_timeIndex.remove(firstIndex, lastIndex - firstIndex + 1);
+	if(m_batchLevel)
+		moveChangeBatch(firstIndex, lastIndex, firstIndex - lastIndex - 1);
+	truncateSnapshot(firstIndex);
+}
+
+void
+Subtitle::linesReorderedUpdate(int firstIndex, int lastIndex)
+{
+	updateTimeIndex(firstIndex, lastIndex);
+	if(m_batchLevel)
+		moveChangeBatch(firstIndex, lastIndex, 0);
+	truncateSnapshot(firstIndex);
+}
+
+void
+Subtitle::truncateSnapshot(int firstIndex) const
+{
+	// snapshot chunks after the first moved line no longer match
+	const int chunk = firstIndex >> SubtitleSnapshot::ChunkShift;
+	if(chunk < m_snapshotChunks.size())
+		m_snapshotChunks.resize(chunk);
+}
+
+void
+Subtitle::invalidateSnapshot(int firstIndex, int lastIndex) const
+{
+	const int last = qMin(lastIndex >> SubtitleSnapshot::ChunkShift, m_snapshotChunks.size() - 1);
+	for(int chunk = firstIndex >> SubtitleSnapshot::ChunkShift; chunk <= last; chunk++)
+		m_snapshotChunks[chunk].reset();
+}
+
+SubtitleSnapshot
+Subtitle::snapshot() const
+{
+	SubtitleSnapshot snap;
+	snap.m_framesPerSecond = m_framesPerSecond;
+	snap.m_stylesheet = m_stylesheet->unformattedCSS();
+	snap.m_metaData = m_metaData;
+	if(m_formatData)
+		snap.m_formatData.reset(new FormatData(*m_formatData));
+	snap.m_showTimes = m_showTimes;
+	snap.m_hideTimes = m_hideTimes;
+
+	const int chunkCount = (m_lines.size() + SubtitleSnapshot::ChunkMask) >> SubtitleSnapshot::ChunkShift;
+	m_snapshotChunks.resize(chunkCount);
+	for(int chunk = 0; chunk < chunkCount; chunk++) {
+		if(m_snapshotChunks.at(chunk))
+			continue;
+		const int first = chunk << SubtitleSnapshot::ChunkShift;
+		const int end = qMin(first + SubtitleSnapshot::ChunkSize, m_lines.size());
+		SubtitleSnapshot::Chunk *lines = new SubtitleSnapshot::Chunk();
+		lines->reserve(end - first);
+		for(int i = first; i < end; i++) {
+			const SubtitleLine *line = m_lines.at(i).obj();
+			lines->append(SubtitleSnapshot::Line{line->primaryText(), line->secondaryText(), line->m_errorFlags, line->m_metaData, line->m_position,
+				QSharedPointer<const FormatData>(line->m_formatData ? new FormatData(*line->m_formatData) : nullptr)});
+		}
+		m_snapshotChunks[chunk] = QSharedPointer<const SubtitleSnapshot::Chunk>(lines);
+	}
+	snap.m_chunks = m_snapshotChunks;
+
+	return snap;
+}
+
+void
+Subtitle::beginChangeBatch() const
+{
+	if(m_batchLevel++)
+		return;
+	std::fill_n(m_batchFirst, int(LineFieldCount), -1);
+	std::fill_n(m_batchLast, int(LineFieldCount), -1);
+}
+
+void
+Subtitle::endChangeBatch() const
+{
+	Q_ASSERT(m_batchLevel > 0);
+	if(--m_batchLevel)
+		return;
+
+	// show and hide time changes are reported together
+	if(m_batchFirst[HideTimeField] >= 0) {
+		if(m_batchFirst[ShowTimeField] < 0 || m_batchFirst[HideTimeField] < m_batchFirst[ShowTimeField])
+			m_batchFirst[ShowTimeField] = m_batchFirst[HideTimeField];
+		m_batchLast[ShowTimeField] = qMax(m_batchLast[ShowTimeField], m_batchLast[HideTimeField]);
+	}
+
+	Subtitle *self = const_cast<Subtitle *>(this);
+	const int lastLine = m_lines.count() - 1;
+	for(int field = PrimaryTextField; field < LineFieldCount; field++) {
+		if(field == HideTimeField)
+			continue;
+		const int first = m_batchFirst[field];
+		if(first < 0)
+			continue;
+		const int last = qMin(m_batchLast[field], lastLine);
+		if(first > last)
+			continue;
+		switch(field) {
+		case PrimaryTextField: emit self->linesPrimaryTextChanged(first, last); break;
+		case SecondaryTextField: emit self->linesSecondaryTextChanged(first, last); break;
+		case ShowTimeField: emit self->linesTimesChanged(first, last); break;
+		case ErrorFlagsField: emit self->linesErrorFlagsChanged(first, last); break;
+		}
+	}
+}
+
+/**
+ * @brief Keep recorded batch ranges on their lines after lines [@p firstIndex, @p lastIndex] were
+ * inserted (@p delta > 0), removed (@p delta < 0) or reordered (@p delta == 0)
+ */
+void
+Subtitle::moveChangeBatch(int firstIndex, int lastIndex, int delta) const
+{
+	for(int field = PrimaryTextField; field < LineFieldCount; field++) {
+		int &first = m_batchFirst[field];
+		int &last = m_batchLast[field];
+		if(first < 0 || last < firstIndex)
+			continue;
+		if(delta > 0) {
+			if(first >= firstIndex)
+				first += delta;
+			last += delta;
+		} else if(delta < 0) {
+			if(first > lastIndex) {
+				first += delta;
+				last += delta;
+			} else {
+				first = qMin(first, firstIndex);
+				last = last > lastIndex ? last + delta : firstIndex - 1;
+				if(first > last)
+					first = last = -1;
+			}
+		} else if(first <= lastIndex) {
+			// changed lines could have moved anywhere in the reordered range
+			first = qMin(first, firstIndex);
+			last = qMax(last, lastIndex);
+		}
+	}
+}
+
+void
+Subtitle::lineChanged(SubtitleLine *line, LineField field)
+{
+	// time index and snapshot are always kept current, batched or not
+	if(field == ShowTimeField || field == HideTimeField)
+		updateTimeIndex(line);
+	else
+		invalidateSnapshot(line->index(), line->index());
+
+	if(!m_batchLevel) {
+		switch(field) {
+		case PrimaryTextField: emit linePrimaryTextChanged(line); break;
+		case SecondaryTextField: emit lineSecondaryTextChanged(line); break;
+		case ShowTimeField: emit lineShowTimeChanged(line); break;
+		case HideTimeField: emit lineHideTimeChanged(line); break;
+		case ErrorFlagsField: emit lineErrorFlagsChanged(line); break;
+		default: break;
+		}
+		return;
+	}
+
+	const int index = line->index();
+	if(m_batchFirst[field] < 0 || index < m_batchFirst[field])
+		m_batchFirst[field] = index;
+	if(index > m_batchLast[field])
+		m_batchLast[field] = index;
+}
+
 bool
 Subtitle::isPrimaryDirty(int index) const
 {
-	int i = m_primaryCleanIndex;
-	const int d = i > index ? -1 : 1;
-	for(;;) {
-		if(i < 0)
-			return m_primaryCleanIndex >= 0;
-		const UndoStack::DirtyMode dirtyMode = i > 0 ? appUndoStack()->dirtyMode(i - 1) : UndoStack::None;
-		if(i != m_primaryCleanIndex && (dirtyMode & UndoStack::Primary))
-			return true;
-		if(i == index)
-			return false;
-		i += d;
-	}
+	return appUndoStack()->isDirty(m_primaryCleanIndex, index, UndoStack::Primary);
 }
 
 bool
 Subtitle::isSecondaryDirty(int index) const
 {
-	int i = m_secondaryCleanIndex;
-	const int d = i > index ? -1 : 1;
-	for(;;) {
-		if(i < 0)
-			return m_secondaryCleanIndex >= 0;
-		const UndoStack::DirtyMode dirtyMode = i > 0 ? appUndoStack()->dirtyMode(i - 1) : UndoStack::None;
-		if(i != m_secondaryCleanIndex && (dirtyMode & UndoStack::Secondary))
-			return true;
-		if(i == index)
-			return false;
-		i += d;
-	}
+	return appUndoStack()->isDirty(m_secondaryCleanIndex, index, UndoStack::Secondary);
+}
+
+void
+Subtitle::undoHistoryTrimmed(int droppedFront, int count)
+{
+	m_primaryCleanIndex = UndoStack::trimmedIndex(m_primaryCleanIndex, droppedFront, count);
+	m_primarySaveIndex = UndoStack::trimmedIndex(m_primarySaveIndex, droppedFront, count);
+	m_secondaryCleanIndex = UndoStack::trimmedIndex(m_secondaryCleanIndex, droppedFront, count);
+	m_secondarySaveIndex = UndoStack::trimmedIndex(m_secondarySaveIndex, droppedFront, count);
 }
 
 void
@@ -1463,6 +1854,61 @@ Subtitle::updateState()
 		emit secondaryChanged();
 }
 
+void
+Subtitle::touchLineDocs(const SubtitleLine *constLine) const
+{
+	// documents are used from subtitle's thread only, so the list needs no locking
+	if(QThread::currentThread() != thread() || m_docHead == constLine)
+		return;
+	SubtitleLine *line = const_cast<SubtitleLine *>(constLine);
+	unlinkLineDocs(line);
+	line->m_docNext = m_docHead;
+	if(m_docHead)
+		m_docHead->m_docPrev = line;
+	else
+		m_docTail = line;
+	m_docHead = line;
+	if(++m_docCount > MAX_LINE_DOCS && !m_docReleasePending) {
+		// returned document pointers must stay valid until control returns to the event loop
+		m_docReleasePending = true;
+		QTimer::singleShot(0, this, [this](){ releaseLineDocs(); });
+	}
+}
+
+void
+Subtitle::unlinkLineDocs(const SubtitleLine *constLine) const
+{
+	if(!constLine->m_docPrev && m_docHead != constLine)
+		return;
+	SubtitleLine *line = const_cast<SubtitleLine *>(constLine);
+	if(line->m_docPrev)
+		line->m_docPrev->m_docNext = line->m_docNext;
+	else
+		m_docHead = line->m_docNext;
+	if(line->m_docNext)
+		line->m_docNext->m_docPrev = line->m_docPrev;
+	else
+		m_docTail = line->m_docPrev;
+	line->m_docPrev = line->m_docNext = nullptr;
+	m_docCount--;
+}
+
+void
+Subtitle::releaseLineDocs() const
+{
+	// every line is looked at once at most, the ones still in use are moved to the front
+	for(int n = m_docCount; n > 0 && m_docCount > MAX_LINE_DOCS; n--) {
+		SubtitleLine *line = m_docTail;
+		const bool primaryReleased = line->releaseDoc(true);
+		const bool secondaryReleased = line->releaseDoc(false);
+		if(primaryReleased && secondaryReleased)
+			unlinkLineDocs(line);
+		else
+			touchLineDocs(line);
+	}
+	m_docReleasePending = false;
+}
+
 void
 Subtitle::stylesheetEdit(QTextEdit *textEdit)
 {
@@ -12,7 +12,9 @@
 #include "core/rangelist.h"
 #include "core/time.h"
 #include "core/richstring.h"
+#include "core/subtitlesnapshot.h"
 #include "core/subtitletarget.h"
+#include "core/timeindex.h"
 #include "core/undo/undostack.h"
 #include "helpers/objectref.h"
 #include "formatdata.h"
@@ -49,7 +51,9 @@ class Subtitle : public QObject, public QSharedData
 	friend class InsertLinesAction;
 	friend class RemoveLinesAction;
 	friend class MoveLineAction;
+	friend class SortLinesAction;
 	friend class EditStylesheetAction;
+	friend class SetLinesTimesAction;
 
 	friend class SubtitleLineAction;
 	friend class SetLinePrimaryTextAction;
@@ -62,6 +66,7 @@ class Subtitle : public QObject, public QSharedData
 	friend class ToggleLineMarkedAction;
 
 	friend class SubtitleCompositeActionExecutor;
+	friend class SubtitleJournal;
 
 	friend class Format;
 	friend class InputFormat;
@@ -83,9 +88,16 @@ public:
 
 	inline bool isPrimaryDirty() const { return m_primaryDirtyState; }
 	void clearPrimaryDirty();
+	/**
+	 * @brief Saving snapshot in background - once done subtitle is clean at undo position the snapshot was taken
+	 */
+	void primarySaveStarted();
+	void primarySaveFinished(bool success);
 
 	inline bool isSecondaryDirty() const { return m_secondaryDirtyState; }
 	void clearSecondaryDirty();
+	void secondarySaveStarted();
+	void secondarySaveFinished(bool success);
 
 	double framesPerSecond() const;
 	void setFramesPerSecond(double framesPerSecond);
@@ -112,6 +124,14 @@ public:
 
 //	inline const QVector<ObjectRef<SubtitleLine>> & allLines() const { return m_lines; }
 
+	QVector<SubtitleLine *> linesIntersecting(const Time &startTime, const Time &endTime);
+	inline QVector<SubtitleLine *> linesAt(const Time &time) { return linesIntersecting(time, time); }
+
+	/**
+	 * @brief Copy of current contents for background readers, only chunks with lines changed since the last call are rebuilt
+	 */
+	SubtitleSnapshot snapshot() const;
+
 //	inline const QList<const SubtitleLine *> & anchoredLines() const { return m_anchoredLines; }
 
 	bool hasAnchors() const;
@@ -122,6 +142,7 @@ public:
 	void removeAllAnchors();
 
 	void insertLine(SubtitleLine *line);
+	void insertLines(QList<SubtitleLine *> lines, bool undoable = true);
 	SubtitleLine * insertNewLine(int index, bool timeAfter, SubtitleTarget target);
 	void removeLines(const RangeList &ranges, SubtitleTarget target);
 
@@ -189,6 +210,12 @@ signals:
 	void linesInserted(int firstIndex, int lastIndex);
 	void linesAboutToBeRemoved(int firstIndex, int lastIndex);
 	void linesRemoved(int firstIndex, int lastIndex);
+	void linesAboutToBeReordered(int firstIndex, int lastIndex);
+	void linesReordered(int firstIndex, int lastIndex);
+	void linesErrorFlagsChanged(int firstIndex, int lastIndex);
+	void linesTimesChanged(int firstIndex, int lastIndex);
+	void linesPrimaryTextChanged(int firstIndex, int lastIndex);
+	void linesSecondaryTextChanged(int firstIndex, int lastIndex);
 
 	void compositeActionStart();
 	void compositeActionEnd();
@@ -204,9 +231,38 @@ signals:
 	void lineMarkChanged(SubtitleLine *line);
 
 private:
+	enum LineField {
+		PrimaryTextField,
+		SecondaryTextField,
+		ShowTimeField,
+		HideTimeField,
+		ErrorFlagsField,
+		LineFieldCount
+	};
+	/**
+	 * @brief Collect line changes until matching endChangeBatch() and emit them as line range signals
+	 */
+	void beginChangeBatch() const;
+	void endChangeBatch() const;
+	void moveChangeBatch(int firstIndex, int lastIndex, int delta) const;
+	void lineChanged(SubtitleLine *line, LineField field);
+
+	void linesInsertedUpdate(int firstIndex, int lastIndex);
+	void linesRemovedUpdate(int firstIndex, int lastIndex);
+	void linesReorderedUpdate(int firstIndex, int lastIndex);
+
+	void truncateSnapshot(int firstIndex) const;
+	void invalidateSnapshot(int firstIndex, int lastIndex) const;
+
 	inline int insertIndex(const Time &showTime) const { return insertIndex(showTime, 0, m_lines.isEmpty() ? 0 : m_lines.count() - 1); }
 	int insertIndex(const Time &showTime, int start, int end) const;
 	void insertLine(SubtitleLine *line, int index);
+	void checkLineErrors(const RangeList &ranges, int errorFlags, bool recheck);
+
+	void updateTimeIndex(const SubtitleLine *line);
+	void updateTimeIndex(int firstIndex, int lastIndex);
+	void transformLineTimes(int firstIndex, int lastIndex, double shiftMseconds, double scaleFactor, const QString &description);
+	double followingShowTime(int index) const;
 
 	FormatData * formatData() const;
 	void setFormatData(const FormatData *formatData);
@@ -218,11 +274,22 @@ private:
 	bool isPrimaryDirty(int index) const;
 	bool isSecondaryDirty(int index) const;
 	void updateState();
+	/**
+	 * @brief Undo history lost @p droppedFront oldest commands and everything past @p count
+	 * Clean states that are no longer in history become unreachable.
+	 */
+	void undoHistoryTrimmed(int droppedFront, int count);
+
+	/**
+	 * @brief Mark @p line's documents as most recently used
+	 * Documents of least recently used lines are released once control returns to the event loop.
+	 */
+	void touchLineDocs(const SubtitleLine *line) const;
+	void unlinkLineDocs(const SubtitleLine *line) const;
+	void releaseLineDocs() const;
 
 	inline int normalizeRangeIndex(int index) const { return index >= m_lines.count() ? m_lines.count() - 1 : index; }
 
-	inline SubtitleLine * takeAt(const int i) { SubtitleLine *s = m_lines.at(i).obj(); m_lines.remove(i); return s; }
-
 	inline bool ignoreDocChanges(bool ignore) {
 		bool r = m_ignoreDocChanges;
 		m_ignoreDocChanges = ignore;
@@ -232,15 +299,36 @@ private:
 private:
 	bool m_primaryDirtyState;
 	int m_primaryCleanIndex;
+	int m_primarySaveIndex = -1;
 	bool m_secondaryDirtyState;
 	int m_secondaryCleanIndex;
+	int m_secondarySaveIndex = -1;
 
 	bool m_ignoreDocChanges = false;
 
+	// changed line ranges per LineField, collected while change batch is open
+	mutable int m_batchLevel = 0;
+	mutable int m_batchFirst[LineFieldCount];
+	mutable int m_batchLast[LineFieldCount];
+
+	// shared line chunks of last snapshot, null chunks are rebuilt by next snapshot()
+	mutable QVector<QSharedPointer<const SubtitleSnapshot::Chunk>> m_snapshotChunks;
+
 	double m_framesPerSecond;
 	mutable QVector<ObjectRef<SubtitleLine>> m_lines;
+	// line times in milliseconds, in the same order as m_lines
+	QVector<double> m_showTimes;
+	QVector<double> m_hideTimes;
+	// kept in line order by line signal handlers
+	TimeIndex m_timeIndex;
 	QList<QPointer<const SubtitleLine>> m_anchoredLines;
 
+	// lines with created documents, most recently used first - used only from subtitle's thread
+	mutable SubtitleLine *m_docHead = nullptr;
+	mutable SubtitleLine *m_docTail = nullptr;
+	mutable int m_docCount = 0;
+	mutable bool m_docReleasePending = false;
+
 	QMap<QByteArray, QString> m_metaData;
 
 	RichCSS *m_stylesheet;
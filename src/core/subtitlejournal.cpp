@@ -0,0 +1,503 @@
+/*
+    SPDX-FileCopyrightText: 2010-2022 Mladen Milinkovic <max@smoothware.net>
+
+    SPDX-License-Identifier: GPL-2.0-or-later
+*/
+
+#include "subtitlejournal.h"
+
+#include "core/subtitle.h"
+#include "core/subtitleline.h"
+#include "core/undo/subtitleactions.h"
+#include "helpers/commondefs.h"
+
+#include <QCoreApplication>
+#include <QCryptographicHash>
+#include <QDataStream>
+#include <QDateTime>
+#include <QDebug>
+#include <QDir>
+#include <QFileInfo>
+#include <QLockFile>
+#include <QSaveFile>
+#include <QUuid>
+#include <QVector>
+
+#include <KLocalizedString>
+
+#include <algorithm>
+
+#define JOURNAL_MAGIC 0x53434a4c // "SCJL"
+#define JOURNAL_VERSION 3
+// edits since last checkpoint are compacted once they outgrow both this and the checkpoint
+#define JOURNAL_COMPACT_SIZE (1 << 20)
+// single line changes are written after this many milliseconds without structural changes
+#define JOURNAL_FLUSH_DELAY 500
+
+using namespace SubtitleComposer;
+
+namespace {
+struct JournalLine {
+	double showTime;
+	double hideTime;
+	RichString primaryText;
+	RichString secondaryText;
+};
+}
+
+static void
+baseFileInfo(const QUrl &url, qint64 *size, qint64 *modified)
+{
+	const QFileInfo fileInfo(url.toLocalFile());
+	if(url.isLocalFile() && fileInfo.exists()) {
+		*size = fileInfo.size();
+		*modified = fileInfo.lastModified().toMSecsSinceEpoch();
+	} else {
+		*size = *modified = -1;
+	}
+}
+
+static QString
+lockPath(const QString &journalPath)
+{
+	return journalPath + QStringLiteral(".lock");
+}
+
+/**
+ * @brief Whether journal at @p path is used by another running instance, stale locks of crashed ones don't count
+ */
+static bool
+lockedElsewhere(const QString &path)
+{
+	QLockFile lock(lockPath(path));
+	if(lock.tryLock(0))
+		return false;
+	qint64 pid;
+	QString hostname, appname;
+	return !lock.getLockInfo(&pid, &hostname, &appname) || pid != QCoreApplication::applicationPid();
+}
+
+static QByteArray
+buildRecord(quint8 type, const QByteArray &data)
+{
+	QByteArray record;
+	record.reserve(data.size() + 5);
+	QDataStream stream(&record, QIODevice::WriteOnly);
+	stream << quint32(data.size() + 1) << type;
+	record.append(data);
+	return record;
+}
+
+static bool
+readLines(QDataStream &stream, int *firstIndex, QVector<JournalLine> *lines)
+{
+	qint32 first, count;
+	stream >> first >> count;
+	if(stream.status() != QDataStream::Ok || first < 0 || count < 0)
+		return false;
+	*firstIndex = first;
+	lines->resize(count);
+	for(JournalLine &line : *lines)
+		stream >> line.showTime >> line.hideTime >> line.primaryText >> line.secondaryText;
+	return stream.status() == QDataStream::Ok;
+}
+
+static QList<SubtitleLine *>
+newLines(const QVector<JournalLine> &lines)
+{
+	QList<SubtitleLine *> res;
+	res.reserve(lines.size());
+	for(const JournalLine &jl : lines) {
+		SubtitleLine *line = new SubtitleLine(jl.showTime, jl.hideTime);
+		line->resetPrimaryText(jl.primaryText);
+		line->resetSecondaryText(jl.secondaryText);
+		res.append(line);
+	}
+	return res;
+}
+
+SubtitleJournal::SubtitleJournal(QObject *parent)
+	: QObject(parent),
+	  m_checkpointEnd(0),
+	  m_checkpointSize(0)
+{
+	m_flushTimer.setSingleShot(true);
+	m_flushTimer.setInterval(JOURNAL_FLUSH_DELAY);
+	connect(&m_flushTimer, &QTimer::timeout, this, &SubtitleJournal::flushPendingLines);
+}
+
+SubtitleJournal::~SubtitleJournal()
+{
+	// journal is left behind unless stop() was called - that's what makes recovery possible
+	flushPendingLines();
+	m_file.close();
+}
+
+QString
+SubtitleJournal::journalPath(const QUrl &url)
+{
+	if(url.isLocalFile()) {
+		const QFileInfo fileInfo(url.toLocalFile());
+		const QFileInfo dirInfo(fileInfo.absolutePath());
+		if(dirInfo.isDir() && dirInfo.isWritable())
+			return fileInfo.absoluteDir().filePath(QChar('.') + fileInfo.fileName() + QStringLiteral(".scjournal"));
+	}
+
+	// untitled and remote subtitles are journaled in temp dir, untitled ones of each session separately
+	static const QByteArray session = QUuid::createUuid().toRfc4122().toHex();
+	const QByteArray hash = url.isEmpty() ? session : QCryptographicHash::hash(url.toEncoded(), QCryptographicHash::Md5).toHex();
+	return QDir(System::tempDir()).filePath(QStringLiteral("subtitlecomposer-") + QString::fromLatin1(hash) + QStringLiteral(".scjournal"));
+}
+
+bool
+SubtitleJournal::exists(const QUrl &url)
+{
+	const QString path = journalPath(url);
+	return QFileInfo(path).size() > 0 && !lockedElsewhere(path);
+}
+
+bool
+SubtitleJournal::recover(const QUrl &url, Subtitle *subtitle)
+{
+	QFile file(journalPath(url));
+	if(lockedElsewhere(file.fileName()) || !file.open(QIODevice::ReadOnly))
+		return false;
+
+	QDataStream stream(&file);
+	stream.setVersion(QDataStream::Qt_5_9);
+
+	quint32 magic;
+	quint16 version;
+	QUrl baseUrl, baseSecondaryUrl;
+	qint64 baseSize, baseModified, baseSecondarySize, baseSecondaryModified;
+	stream >> magic >> version >> baseUrl >> baseSize >> baseModified >> baseSecondaryUrl >> baseSecondarySize >> baseSecondaryModified;
+	if(stream.status() != QDataStream::Ok || magic != JOURNAL_MAGIC || version != JOURNAL_VERSION || baseUrl != url)
+		return false;
+
+	// crash could have left a partial record at the end, it is ignored
+	QVector<QByteArray> records;
+	int lastCheckpoint = -1;
+	for(;;) {
+		quint32 size;
+		stream >> size;
+		if(stream.status() != QDataStream::Ok || size == 0 || size > quint32(file.bytesAvailable()))
+			break;
+		QByteArray record(size, Qt::Uninitialized);
+		if(stream.readRawData(record.data(), size) != int(size))
+			break;
+		if(quint8(record.at(0)) == Checkpoint)
+			lastCheckpoint = records.size();
+		records.append(record);
+	}
+	if(records.isEmpty())
+		return false;
+
+	// edits without checkpoint only apply to the exact files they were made on
+	if(lastCheckpoint < 0) {
+		qint64 size, modified, secondarySize, secondaryModified;
+		baseFileInfo(url, &size, &modified);
+		baseFileInfo(baseSecondaryUrl, &secondarySize, &secondaryModified);
+		if(size != baseSize || modified != baseModified || secondarySize != baseSecondarySize || secondaryModified != baseSecondaryModified)
+			return false;
+	}
+
+	subtitle->beginCompositeAction(i18n("Recover Unsaved Changes"));
+	for(int i = qMax(0, lastCheckpoint); i < records.size(); i++) {
+		if(!replay(subtitle, records.at(i))) {
+			qWarning() << "Subtitle journal" << file.fileName() << "is damaged, recovered" << i << "of" << records.size() << "records";
+			break;
+		}
+	}
+	subtitle->endCompositeAction();
+
+	return true;
+}
+
+bool
+SubtitleJournal::replay(Subtitle *subtitle, const QByteArray &record)
+{
+	QDataStream stream(record);
+	stream.setVersion(QDataStream::Qt_5_9);
+
+	quint8 type;
+	stream >> type;
+
+	int firstIndex;
+	QVector<JournalLine> lines;
+
+	switch(type) {
+	case Checkpoint: {
+		double fps;
+		stream >> fps;
+		if(!readLines(stream, &firstIndex, &lines))
+			return false;
+		if(subtitle->count())
+			subtitle->processAction(new RemoveLinesAction(subtitle, 0, subtitle->lastIndex()));
+		subtitle->setFramesPerSecond(fps);
+		if(!lines.isEmpty())
+			subtitle->processAction(new InsertLinesAction(subtitle, newLines(lines), 0));
+		return true;
+	}
+	case InsertLines:
+		if(!readLines(stream, &firstIndex, &lines) || firstIndex > subtitle->count())
+			return false;
+		subtitle->processAction(new InsertLinesAction(subtitle, newLines(lines), firstIndex));
+		return true;
+	case RemoveLines: {
+		qint32 lastIndex;
+		stream >> firstIndex >> lastIndex;
+		if(stream.status() != QDataStream::Ok || firstIndex < 0 || firstIndex > lastIndex || lastIndex > subtitle->lastIndex())
+			return false;
+		subtitle->processAction(new RemoveLinesAction(subtitle, firstIndex, lastIndex));
+		return true;
+	}
+	case SetLines:
+		if(!readLines(stream, &firstIndex, &lines) || firstIndex + lines.size() > subtitle->count())
+			return false;
+		for(int i = 0; i < lines.size(); i++) {
+			const JournalLine &jl = lines.at(i);
+			SubtitleLine *line = subtitle->at(firstIndex + i);
+			if(line->showTime().toMillis() != jl.showTime || line->hideTime().toMillis() != jl.hideTime)
+				line->setTimes(jl.showTime, jl.hideTime);
+			if(line->primaryText().richString() != jl.primaryText.richString())
+				line->resetPrimaryText(jl.primaryText);
+			if(line->secondaryText().richString() != jl.secondaryText.richString())
+				line->resetSecondaryText(jl.secondaryText);
+		}
+		return true;
+	case SetFramesPerSecond: {
+		double fps;
+		stream >> fps;
+		if(stream.status() != QDataStream::Ok)
+			return false;
+		subtitle->setFramesPerSecond(fps);
+		return true;
+	}
+	default:
+		return false;
+	}
+}
+
+void
+SubtitleJournal::start(Subtitle *subtitle, const QUrl &url, const QUrl &secondaryUrl)
+{
+	if(m_subtitle)
+		disconnect(m_subtitle, nullptr, this, nullptr);
+	m_flushTimer.stop();
+	m_pendingLines.clear();
+	const QString path = journalPath(url);
+	const bool wasOpen = m_file.isOpen();
+	m_file.close();
+	if(m_file.fileName() != path) {
+		// subtitle was saved under different name
+		if(wasOpen)
+			m_file.remove();
+		m_lock.reset();
+	}
+
+	m_subtitle = subtitle;
+	m_url = url;
+	m_secondaryUrl = secondaryUrl;
+	m_checkpointEnd = m_checkpointSize = 0;
+	if(!m_subtitle)
+		return;
+
+	if(!m_lock) {
+		m_lock.reset(new QLockFile(lockPath(path)));
+		if(!m_lock->tryLock(0)) {
+			qWarning() << "Subtitle journal" << path << "is used by another instance";
+			m_lock.reset();
+			return;
+		}
+	}
+
+	m_file.setFileName(path);
+	if(!m_file.open(QIODevice::WriteOnly | QIODevice::Truncate | QIODevice::Unbuffered)) {
+		qWarning() << "Failed creating subtitle journal" << m_file.fileName();
+		return;
+	}
+	writeHeader(&m_file);
+	m_checkpointEnd = m_file.pos();
+
+	// subtitle doesn't match the files on disk, or primary file alone can't restore translation texts
+	if(m_subtitle->isPrimaryDirty() || m_subtitle->isSecondaryDirty() || !m_secondaryUrl.isEmpty())
+		writeRecord(Checkpoint, checkpointData());
+
+	// pending line changes must be written with the indexes they were recorded at
+	connect(m_subtitle, &Subtitle::linesAboutToBeInserted, this, &SubtitleJournal::flushPendingLines);
+	connect(m_subtitle, &Subtitle::linesAboutToBeRemoved, this, &SubtitleJournal::flushPendingLines);
+	connect(m_subtitle, &Subtitle::linesAboutToBeReordered, this, &SubtitleJournal::flushPendingLines);
+	connect(m_subtitle, &Subtitle::linesInserted, this, &SubtitleJournal::onLinesInserted);
+	connect(m_subtitle, &Subtitle::linesRemoved, this, &SubtitleJournal::onLinesRemoved);
+	connect(m_subtitle, &Subtitle::linesReordered, this, &SubtitleJournal::onLinesChanged);
+	connect(m_subtitle, &Subtitle::linesTimesChanged, this, &SubtitleJournal::onLinesChanged);
+	connect(m_subtitle, &Subtitle::linesPrimaryTextChanged, this, &SubtitleJournal::onLinesChanged);
+	connect(m_subtitle, &Subtitle::linesSecondaryTextChanged, this, &SubtitleJournal::onLinesChanged);
+	connect(m_subtitle, &Subtitle::linePrimaryTextChanged, this, &SubtitleJournal::onLineChanged);
+	connect(m_subtitle, &Subtitle::lineSecondaryTextChanged, this, &SubtitleJournal::onLineChanged);
+	connect(m_subtitle, &Subtitle::lineShowTimeChanged, this, &SubtitleJournal::onLineChanged);
+	connect(m_subtitle, &Subtitle::lineHideTimeChanged, this, &SubtitleJournal::onLineChanged);
+	connect(m_subtitle, &Subtitle::framesPerSecondChanged, this, &SubtitleJournal::onFramesPerSecondChanged);
+}
+
+void
+SubtitleJournal::stop()
+{
+	if(m_subtitle)
+		disconnect(m_subtitle, nullptr, this, nullptr);
+	m_subtitle = nullptr;
+	m_flushTimer.stop();
+	m_pendingLines.clear();
+
+	if(m_file.isOpen()) {
+		m_file.close();
+		m_file.remove();
+	}
+	m_lock.reset();
+}
+
+void
+SubtitleJournal::writeHeader(QIODevice *device) const
+{
+	qint64 size, modified, secondarySize, secondaryModified;
+	baseFileInfo(m_url, &size, &modified);
+	baseFileInfo(m_secondaryUrl, &secondarySize, &secondaryModified);
+
+	QDataStream stream(device);
+	stream.setVersion(QDataStream::Qt_5_9);
+	stream << quint32(JOURNAL_MAGIC) << quint16(JOURNAL_VERSION) << m_url << size << modified
+		<< m_secondaryUrl << secondarySize << secondaryModified;
+}
+
+void
+SubtitleJournal::writeRecord(RecordType type, const QByteArray &data)
+{
+	if(!m_file.isOpen())
+		return;
+
+	// single write, so crash can only leave a partial record at the end
+	const QByteArray record = buildRecord(type, data);
+	if(m_file.write(record) != record.size()) {
+		qWarning() << "Failed writing subtitle journal" << m_file.fileName();
+		m_file.close();
+		return;
+	}
+
+	if(type == Checkpoint) {
+		m_checkpointEnd = m_file.pos();
+		m_checkpointSize = record.size();
+	} else if(m_file.pos() - m_checkpointEnd > qMax<qint64>(JOURNAL_COMPACT_SIZE, m_checkpointSize)) {
+		compact();
+	}
+}
+
+QByteArray
+SubtitleJournal::checkpointData() const
+{
+	QByteArray data;
+	QDataStream stream(&data, QIODevice::WriteOnly);
+	stream.setVersion(QDataStream::Qt_5_9);
+	stream << m_subtitle->framesPerSecond();
+	writeLines(stream, 0, m_subtitle->lastIndex());
+	return data;
+}
+
+void
+SubtitleJournal::writeLines(QDataStream &stream, int firstIndex, int lastIndex) const
+{
+	stream << qint32(firstIndex) << qint32(lastIndex - firstIndex + 1);
+	for(int i = firstIndex; i <= lastIndex; i++) {
+		const SubtitleLine *line = m_subtitle->at(i);
+		stream << line->showTime().toMillis() << line->hideTime().toMillis() << line->primaryText() << line->secondaryText();
+	}
+}
+
+void
+SubtitleJournal::compact()
+{
+	const QByteArray record = buildRecord(Checkpoint, checkpointData());
+
+	QSaveFile file(m_file.fileName());
+	if(!file.open(QIODevice::WriteOnly))
+		return;
+	writeHeader(&file);
+	file.write(record);
+
+	m_file.close();
+	if(!file.commit())
+		qWarning() << "Failed compacting subtitle journal" << m_file.fileName();
+	if(!m_file.open(QIODevice::WriteOnly | QIODevice::Append | QIODevice::Unbuffered)) {
+		qWarning() << "Failed reopening subtitle journal" << m_file.fileName();
+		return;
+	}
+	m_checkpointEnd = m_file.pos();
+	m_checkpointSize = record.size();
+}
+
+void
+SubtitleJournal::onLinesInserted(int firstIndex, int lastIndex)
+{
+	QByteArray data;
+	QDataStream stream(&data, QIODevice::WriteOnly);
+	stream.setVersion(QDataStream::Qt_5_9);
+	writeLines(stream, firstIndex, lastIndex);
+	writeRecord(InsertLines, data);
+}
+
+void
+SubtitleJournal::onLinesRemoved(int firstIndex, int lastIndex)
+{
+	QByteArray data;
+	QDataStream stream(&data, QIODevice::WriteOnly);
+	stream.setVersion(QDataStream::Qt_5_9);
+	stream << qint32(firstIndex) << qint32(lastIndex);
+	writeRecord(RemoveLines, data);
+}
+
+void
+SubtitleJournal::onLinesChanged(int firstIndex, int lastIndex)
+{
+	QByteArray data;
+	QDataStream stream(&data, QIODevice::WriteOnly);
+	stream.setVersion(QDataStream::Qt_5_9);
+	writeLines(stream, firstIndex, lastIndex);
+	writeRecord(SetLines, data);
+}
+
+void
+SubtitleJournal::onLineChanged(SubtitleLine *line)
+{
+	m_pendingLines.insert(line->index());
+	if(!m_flushTimer.isActive())
+		m_flushTimer.start();
+}
+
+void
+SubtitleJournal::flushPendingLines()
+{
+	m_flushTimer.stop();
+	if(m_pendingLines.isEmpty())
+		return;
+	QList<int> indexes = m_pendingLines.values();
+	m_pendingLines.clear();
+	if(!m_subtitle)
+		return;
+	std::sort(indexes.begin(), indexes.end());
+	for(int i = 0, n = indexes.size(); i < n;) {
+		const int first = indexes.at(i);
+		int last = first;
+		while(++i < n && indexes.at(i) == last + 1)
+			last++;
+		onLinesChanged(first, last);
+	}
+}
+
+void
+SubtitleJournal::onFramesPerSecondChanged(double fps)
+{
+	QByteArray data;
+	QDataStream stream(&data, QIODevice::WriteOnly);
+	stream.setVersion(QDataStream::Qt_5_9);
+	stream << fps;
+	writeRecord(SetFramesPerSecond, data);
+}
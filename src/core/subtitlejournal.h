@@ -0,0 +1,101 @@
+/*
+    SPDX-FileCopyrightText: 2010-2022 Mladen Milinkovic <max@smoothware.net>
+
+    SPDX-License-Identifier: GPL-2.0-or-later
+*/
+
+#ifndef SUBTITLEJOURNAL_H
+#define SUBTITLEJOURNAL_H
+
+#include <QFile>
+#include <QObject>
+#include <QPointer>
+#include <QScopedPointer>
+#include <QSet>
+#include <QTimer>
+#include <QUrl>
+
+QT_FORWARD_DECLARE_CLASS(QDataStream)
+QT_FORWARD_DECLARE_CLASS(QLockFile)
+
+namespace SubtitleComposer {
+class Subtitle;
+class SubtitleLine;
+
+/**
+ * @brief Append-only journal of subtitle edits used to recover unsaved changes after a crash
+ * Journal lives next to the subtitle file and holds edits made since the file was last saved.
+ * Once edits outgrow the last checkpoint, journal is compacted into a single checkpoint of the
+ * whole subtitle. Journal is locked while in use, so other instances leave it alone.
+ */
+class SubtitleJournal : public QObject
+{
+	Q_OBJECT
+
+public:
+	explicit SubtitleJournal(QObject *parent = nullptr);
+	virtual ~SubtitleJournal();
+
+	/**
+	 * @brief Journal file of @p url, untitled subtitles get a journal of their own in every session
+	 */
+	static QString journalPath(const QUrl &url);
+	/**
+	 * @brief Whether @p url has a journal that isn't used by another instance
+	 */
+	static bool exists(const QUrl &url);
+	/**
+	 * @brief Replay journal of @p url onto @p subtitle that was just loaded from @p url
+	 * @return false if there is no usable journal, @p subtitle is not touched then
+	 */
+	static bool recover(const QUrl &url, Subtitle *subtitle);
+
+	/**
+	 * @brief Start journaling @p subtitle, edits are relative to @p url and translation @p secondaryUrl as they are on disk now
+	 * Any previous journal of @p url is replaced.
+	 */
+	void start(Subtitle *subtitle, const QUrl &url, const QUrl &secondaryUrl = QUrl());
+	/**
+	 * @brief Stop journaling and remove journal file
+	 */
+	void stop();
+
+private:
+	enum RecordType {
+		Checkpoint = 1,
+		InsertLines,
+		RemoveLines,
+		SetLines,
+		SetFramesPerSecond
+	};
+
+	static bool replay(Subtitle *subtitle, const QByteArray &record);
+
+	void writeHeader(QIODevice *device) const;
+	void writeRecord(RecordType type, const QByteArray &data);
+	QByteArray checkpointData() const;
+	void writeLines(QDataStream &stream, int firstIndex, int lastIndex) const;
+	void compact();
+	void flushPendingLines();
+
+	void onLinesInserted(int firstIndex, int lastIndex);
+	void onLinesRemoved(int firstIndex, int lastIndex);
+	void onLinesChanged(int firstIndex, int lastIndex);
+	void onLineChanged(SubtitleLine *line);
+	void onFramesPerSecondChanged(double fps);
+
+private:
+	QPointer<Subtitle> m_subtitle;
+	QUrl m_url;
+	QUrl m_secondaryUrl;
+	QFile m_file;
+	QScopedPointer<QLockFile> m_lock;
+	// lines changed one by one (e.g. while typing), written together once m_flushTimer fires
+	QSet<int> m_pendingLines;
+	QTimer m_flushTimer;
+	qint64 m_checkpointEnd;
+	qint64 m_checkpointSize;
+};
+}
+
+#endif // SUBTITLEJOURNAL_H
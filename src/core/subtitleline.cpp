@@ -20,7 +20,6 @@
 
 using namespace SubtitleComposer;
 
-
 SubtitleLine::ErrorFlag
 SubtitleLine::errorFlag(SubtitleLine::ErrorID id)
 {
@@ -124,50 +123,24 @@ SubtitleLine::fullErrorText(SubtitleLine::ErrorID errorID) const
 	}
 }
 
-void
-SubtitleLine::setupSignals()
-{
-	connect(m_primaryDoc, &RichDocument::contentsChanged, this, &SubtitleLine::primaryDocumentChanged);
-	connect(m_secondaryDoc, &RichDocument::contentsChanged, this, &SubtitleLine::secondaryDocumentChanged);
-
-	QObject::connect(this, &SubtitleLine::primaryTextChanged, [this](){
-		if(subtitle()) emit subtitle()->linePrimaryTextChanged(this);
-	});
-	QObject::connect(this, &SubtitleLine::secondaryTextChanged, [this](){
-		if(subtitle()) emit subtitle()->lineSecondaryTextChanged(this);
-	});
-	QObject::connect(this, &SubtitleLine::showTimeChanged, [this](){
-		if(subtitle()) emit subtitle()->lineShowTimeChanged(this);
-	});
-	QObject::connect(this, &SubtitleLine::hideTimeChanged, [this](){
-		if(subtitle()) emit subtitle()->lineHideTimeChanged(this);
-	});
-}
-
 SubtitleLine::SubtitleLine()
 	: QObject(),
 	  m_subtitle(nullptr),
-	  m_primaryDoc(new RichDocument(this)),
-	  m_secondaryDoc(new RichDocument(this)),
 	  m_showTime(0.0),
 	  m_hideTime(0.0),
 	  m_errorFlags(0),
 	  m_formatData(nullptr)
 {
-	setupSignals();
 }
 
 SubtitleLine::SubtitleLine(const Time &showTime, const Time &hideTime)
 	: QObject(),
 	  m_subtitle(nullptr),
-	  m_primaryDoc(new RichDocument(this)),
-	  m_secondaryDoc(new RichDocument(this)),
 	  m_showTime(showTime),
 	  m_hideTime(hideTime),
 	  m_errorFlags(0),
 	  m_formatData(nullptr)
 {
-	setupSignals();
 }
 
 //SubtitleLine::SubtitleLine(const SubtitleLine &line)
@@ -198,6 +171,7 @@ SubtitleLine::SubtitleLine(const Time &showTime, const Time &hideTime)
 
 SubtitleLine::~SubtitleLine()
 {
+	unlinkDoc();
 	delete m_formatData;
 }
 
@@ -213,6 +187,9 @@ SubtitleLine::setFormatData(const FormatData *formatData)
 	delete m_formatData;
 
 	m_formatData = formatData ? new FormatData(*formatData) : NULL;
+
+	if(m_subtitle)
+		m_subtitle->invalidateSnapshot(index(), index());
 }
 
 int
@@ -252,6 +229,7 @@ SubtitleLine::index() const
 void
 SubtitleLine::primaryDocumentChanged()
 {
+	invalidateTextStats(true);
 	if(m_ignoreDocChanges || (m_subtitle && m_subtitle->m_ignoreDocChanges))
 		return;
 	processAction(new SetLinePrimaryTextAction(this, m_primaryDoc));
@@ -260,46 +238,143 @@ SubtitleLine::primaryDocumentChanged()
 void
 SubtitleLine::secondaryDocumentChanged()
 {
+	invalidateTextStats(false);
 	if(m_ignoreDocChanges || (m_subtitle && m_subtitle->m_ignoreDocChanges))
 		return;
 	processAction(new SetLineSecondaryTextAction(this, m_secondaryDoc));
 }
 
-void
-SubtitleLine::setPrimaryDoc(RichDocument *doc)
+RichDocument *
+SubtitleLine::materializeDoc(bool primary) const
 {
-	if(m_primaryDoc == doc)
-		return;
-	if(m_primaryDoc) {
-		disconnect(m_primaryDoc, &RichDocument::contentsChanged, this, &SubtitleLine::primaryDocumentChanged);
-		m_primaryDoc->setStylesheet(nullptr);
+	SubtitleLine *self = const_cast<SubtitleLine *>(this);
+	RichDocument *doc = new RichDocument(self);
+	RichString &text = primary ? m_primaryText : m_secondaryText;
+	doc->setRichText(text, true);
+	doc->setStylesheet(m_subtitle ? m_subtitle->m_stylesheet : nullptr);
+	text = RichString();
+	if(primary) {
+		m_primaryDoc = doc;
+		connect(doc, &RichDocument::contentsChanged, self, &SubtitleLine::primaryDocumentChanged);
+	} else {
+		m_secondaryDoc = doc;
+		connect(doc, &RichDocument::contentsChanged, self, &SubtitleLine::secondaryDocumentChanged);
 	}
-	m_primaryDoc = doc;
-	m_primaryDoc->setParent(this);
-	m_primaryDoc->setStylesheet(m_subtitle ? m_subtitle->m_stylesheet : nullptr);
-	connect(m_primaryDoc, &RichDocument::contentsChanged, this, &SubtitleLine::primaryDocumentChanged);
+	return touchDoc(doc);
+}
+
+RichDocument *
+SubtitleLine::touchDoc(RichDocument *doc) const
+{
+	if(m_subtitle)
+		m_subtitle->touchLineDocs(this);
+	return doc;
 }
 
 void
-SubtitleLine::setSecondaryDoc(RichDocument *doc)
+SubtitleLine::unlinkDoc() const
 {
-	if(m_secondaryDoc == doc)
-		return;
-	if(m_secondaryDoc) {
-		disconnect(m_secondaryDoc, &RichDocument::contentsChanged, this, &SubtitleLine::secondaryDocumentChanged);
-		m_secondaryDoc->setStylesheet(nullptr);
+	if(m_subtitle)
+		m_subtitle->unlinkLineDocs(this);
+}
+
+bool
+SubtitleLine::releaseDoc(bool primary) const
+{
+	RichDocument *&doc = primary ? m_primaryDoc : m_secondaryDoc;
+	if(!doc)
+		return true;
+	// document is referenced from outside or its history is still used by undo actions
+	if(doc->isPinned() || doc->isUndoAvailable() || doc->isRedoAvailable())
+		return false;
+	(primary ? m_primaryText : m_secondaryText) = RichString::intern(doc->toRichText());
+	delete doc;
+	doc = nullptr;
+	return true;
+}
+
+RichString
+SubtitleLine::primaryText() const
+{
+	return m_primaryDoc ? m_primaryDoc->toRichText() : m_primaryText;
+}
+
+RichString
+SubtitleLine::secondaryText() const
+{
+	return m_secondaryDoc ? m_secondaryDoc->toRichText() : m_secondaryText;
+}
+
+/**
+ * @brief Convert raw text the same way QTextDocument::toPlainText() does
+ */
+QString
+SubtitleLine::toPlainText(QString text)
+{
+	// don't detach unless needed - interned texts can then be compared by their data pointers
+	const QChar *cc = text.constData();
+	const QChar *ce = cc + text.size();
+	while(cc != ce && *cc != QChar::Nbsp && *cc != QChar::ParagraphSeparator && *cc != QChar::LineSeparator)
+		++cc;
+	if(cc == ce)
+		return text;
+
+	const int offset = cc - text.constData();
+	QChar *c = text.data();
+	QChar *end = c + text.size();
+	for(c += offset; c != end; ++c) {
+		if(*c == QChar::Nbsp)
+			*c = QChar::Space;
+		else if(*c == QChar::ParagraphSeparator || *c == QChar::LineSeparator)
+			*c = QChar::LineFeed;
+	}
+	return text;
+}
+
+QString
+SubtitleLine::plainText(bool primary) const
+{
+	if(const RichDocument *doc = primary ? m_primaryDoc : m_secondaryDoc)
+		return doc->toPlainText();
+	return toPlainText(primary ? m_primaryText.string() : m_secondaryText.string());
+}
+
+QString
+SubtitleLine::rawText(bool primary) const
+{
+	if(const RichDocument *doc = primary ? m_primaryDoc : m_secondaryDoc)
+		return doc->toRawText().replace(QChar::ParagraphSeparator, QChar::LineFeed);
+	return primary ? m_primaryText.string() : m_secondaryText.string();
+}
+
+void
+SubtitleLine::resetText(bool primary, const RichString &text)
+{
+	invalidateTextStats(primary);
+	if(RichDocument *doc = primary ? m_primaryDoc : m_secondaryDoc) {
+		const bool ignore = ignoreDocChanges(true);
+		doc->setRichText(text, true);
+		doc->setStylesheet(m_subtitle ? m_subtitle->m_stylesheet : nullptr);
+		ignoreDocChanges(ignore);
+	} else {
+		(primary ? m_primaryText : m_secondaryText) = RichString::intern(text);
 	}
-	m_secondaryDoc = doc;
-	m_secondaryDoc->setParent(this);
-	m_secondaryDoc->setStylesheet(m_subtitle ? m_subtitle->m_stylesheet : nullptr);
-	connect(m_secondaryDoc, &RichDocument::contentsChanged, this, &SubtitleLine::secondaryDocumentChanged);
+	if(primary)
+		notifyPrimaryTextChanged();
+	else
+		notifySecondaryTextChanged();
 }
 
 void
-SubtitleLine::setTexts(RichDocument *pText, RichDocument *sText)
+SubtitleLine::resetPrimaryText(const RichString &text)
 {
-	setPrimaryDoc(pText);
-	setSecondaryDoc(sText);
+	resetText(true, text);
+}
+
+void
+SubtitleLine::resetSecondaryText(const RichString &text)
+{
+	resetText(false, text);
 }
 
 void
@@ -307,14 +382,14 @@ SubtitleLine::breakText(int minBreakLength, SubtitleTarget target)
 {
 	switch(target) {
 	case Primary:
-		m_primaryDoc->breakText(minBreakLength);
+		primaryDoc()->breakText(minBreakLength);
 		break;
 	case Secondary:
-		m_secondaryDoc->breakText(minBreakLength);
+		secondaryDoc()->breakText(minBreakLength);
 		break;
 	case Both:
-		m_primaryDoc->breakText(minBreakLength);
-		m_secondaryDoc->breakText(minBreakLength);
+		primaryDoc()->breakText(minBreakLength);
+		secondaryDoc()->breakText(minBreakLength);
 		break;
 	default:
 		break;
@@ -326,14 +401,14 @@ SubtitleLine::unbreakText(SubtitleTarget target)
 {
 	switch(target) {
 	case Primary:
-		m_primaryDoc->joinLines();
+		primaryDoc()->joinLines();
 		break;
 	case Secondary:
-		m_secondaryDoc->joinLines();
+		secondaryDoc()->joinLines();
 		break;
 	case Both:
-		m_primaryDoc->joinLines();
-		m_secondaryDoc->joinLines();
+		primaryDoc()->joinLines();
+		secondaryDoc()->joinLines();
 		break;
 	default:
 		break;
@@ -345,14 +420,14 @@ SubtitleLine::simplifyTextWhiteSpace(SubtitleTarget target)
 {
 	switch(target) {
 	case Primary:
-		m_primaryDoc->cleanupSpaces();
+		primaryDoc()->cleanupSpaces();
 		break;
 	case Secondary:
-		m_secondaryDoc->cleanupSpaces();
+		secondaryDoc()->cleanupSpaces();
 		break;
 	case Both:
-		m_primaryDoc->cleanupSpaces();
-		m_secondaryDoc->cleanupSpaces();
+		primaryDoc()->cleanupSpaces();
+		secondaryDoc()->cleanupSpaces();
 		break;
 	default:
 		break;
@@ -376,7 +451,7 @@ SubtitleLine::processShowTimeSort(const Time &showTime)
 void
 SubtitleLine::setShowTime(const Time &showTime)
 {
-	if(m_showTime == showTime)
+	if(this->showTime() == showTime)
 		return;
 
 	if(m_subtitle)
@@ -385,8 +460,8 @@ SubtitleLine::setShowTime(const Time &showTime)
 	if(m_subtitle && m_subtitle->isLineAnchored(this)) {
 		m_subtitle->shiftAnchoredLine(this, showTime);
 	} else {
-		if(showTime > m_hideTime) {
-			setTimes(m_hideTime, showTime);
+		if(showTime > this->hideTime()) {
+			setTimes(this->hideTime(), showTime);
 		} else {
 			processShowTimeSort(showTime);
 			processAction(new SetLineShowTimeAction(this, showTime));
@@ -400,14 +475,14 @@ SubtitleLine::setShowTime(const Time &showTime)
 void
 SubtitleLine::setHideTime(const Time &hideTime)
 {
-	if(m_hideTime == hideTime)
+	if(this->hideTime() == hideTime)
 		return;
 
 	if(m_subtitle)
 		m_subtitle->beginCompositeAction(i18n("Set Line Hide Time"));
 
-	if(m_showTime > hideTime)
-		setTimes(hideTime, m_showTime);
+	if(this->showTime() > hideTime)
+		setTimes(hideTime, this->showTime());
 	else
 		processAction(new SetLineHideTimeAction(this, hideTime));
 
@@ -418,7 +493,9 @@ SubtitleLine::setHideTime(const Time &hideTime)
 QColor
 SubtitleLine::durationColor(const QColor &textColor, bool usePrimary)
 {
-	const int textLen = (usePrimary ? primaryDoc() : secondaryDoc())->length();
+	const RichDocument *doc = usePrimary ? m_primaryDoc : m_secondaryDoc;
+	// RichDocument::length() counts the final paragraph separator
+	const int textLen = doc ? doc->length() : (usePrimary ? m_primaryText : m_secondaryText).length() + 1;
 	const int minD = textLen * SCConfig::minDurationPerCharacter();
 	const int maxD = textLen * SCConfig::maxDurationPerCharacter();
 	const int avgD = textLen * SCConfig::idealDurationPerCharacter();
@@ -447,7 +524,7 @@ SubtitleLine::durationColor(const QColor &textColor, bool usePrimary)
 void
 SubtitleLine::setTimes(const Time &showTime, const Time &hideTime)
 {
-	if(m_showTime == showTime && m_hideTime == hideTime)
+	if(this->showTime() == showTime && this->hideTime() == hideTime)
 		return;
 
 	if(m_subtitle)
@@ -464,46 +541,72 @@ SubtitleLine::setTimes(const Time &showTime, const Time &hideTime)
 		m_subtitle->endCompositeAction();
 }
 
+SubtitleLine::TextStats
+SubtitleLine::textStats(const QString &text)
+{
+	TextStats stats;
+	stats.hash = qHash(text);
+
+	const QString simple = text.simplified();
+	stats.characters = simple.length();
+	stats.words = simple.isEmpty() ? 0 : simple.count(QChar::Space) + 1;
+
+	const QStringList textLines = text.split(QChar::LineFeed);
+	for(const QString &line : textLines)
+		stats.maxLineCharacters = qMax(stats.maxLineCharacters, line.simplified().length());
+
+	QString lines = text;
+	RichString::simplifyWhiteSpace(lines);
+	stats.lines = lines.isEmpty() ? 0 : lines.count(QChar::LineFeed) + 1;
+	stats.durationCharacters = lines.length();
+	stats.durationWords = lines.isEmpty() ? 0 : lines.count(QChar::Space) + stats.lines;
+
+	return stats;
+}
+
+const SubtitleLine::TextStats &
+SubtitleLine::textStats(bool primary) const
+{
+	TextStats &stats = primary ? m_primaryStats : m_secondaryStats;
+	if(stats.characters == -1)
+		stats = textStats(plainText(primary));
+	return stats;
+}
+
 int
 SubtitleLine::primaryCharacters() const
 {
-	return m_primaryDoc->toPlainText().simplified().length();
+	return textStats(true).characters;
 }
 
 int
 SubtitleLine::primaryWords() const
 {
-	QString text(m_primaryDoc->toPlainText().simplified());
-	return text.length() ? text.count(' ') + 1 : 0;
+	return textStats(true).words;
 }
 
 int
 SubtitleLine::primaryLines() const
 {
-	RichString text(m_primaryDoc->toPlainText());
-	text.simplifyWhiteSpace();
-	return text.isEmpty() ? 0 : text.count('\n') + 1;
+	return textStats(true).lines;
 }
 
 int
 SubtitleLine::secondaryCharacters() const
 {
-	return m_secondaryDoc->toPlainText().simplified().length();
+	return textStats(false).characters;
 }
 
 int
 SubtitleLine::secondaryWords() const
 {
-	QString text(m_secondaryDoc->toPlainText().simplified());
-	return text.length() ? text.count(' ') + 1 : 0;
+	return textStats(false).words;
 }
 
 int
 SubtitleLine::secondaryLines() const
 {
-	RichString text(m_secondaryDoc->toPlainText());
-	text.simplifyWhiteSpace();
-	return text.isEmpty() ? 0 : text.count('\n') + 1;
+	return textStats(false).lines;
 }
 
 Time
@@ -528,17 +631,26 @@ SubtitleLine::autoDuration(const QString &t, int msecsPerChar, int msecsPerWord,
 Time
 SubtitleLine::autoDuration(int msecsPerChar, int msecsPerWord, int msecsPerLine, SubtitleTarget calculationTarget)
 {
+	Q_ASSERT(msecsPerChar >= 0);
+	Q_ASSERT(msecsPerWord >= 0);
+	Q_ASSERT(msecsPerLine >= 0);
+
+	const auto duration = [&](bool primary){
+		const TextStats &stats = textStats(primary);
+		return Time(stats.durationCharacters * msecsPerChar + stats.durationWords * msecsPerWord + stats.lines * msecsPerLine);
+	};
+
 	switch(calculationTarget) {
 	case Secondary:
-		return autoDuration(m_secondaryDoc->toPlainText(), msecsPerChar, msecsPerWord, msecsPerLine);
+		return duration(false);
 	case Both: {
-		Time primary = autoDuration(m_primaryDoc->toPlainText(), msecsPerChar, msecsPerWord, msecsPerLine);
-		Time secondary = autoDuration(m_secondaryDoc->toPlainText(), msecsPerChar, msecsPerWord, msecsPerLine);
+		Time primary = duration(true);
+		Time secondary = duration(false);
 		return primary > secondary ? primary : secondary;
 	}
 	case Primary:
 	default:
-		return autoDuration(m_primaryDoc->toPlainText(), msecsPerChar, msecsPerWord, msecsPerLine);
+		return duration(true);
 	}
 }
 
@@ -548,7 +660,7 @@ SubtitleLine::shiftTimes(long mseconds)
 	if(!mseconds)
 		return;
 
-	processAction(new SetLineTimesAction(this, m_showTime.shifted(mseconds), m_hideTime.shifted(mseconds), i18n("Shift Line Times")));
+	processAction(new SetLineTimesAction(this, showTime().shifted(mseconds), hideTime().shifted(mseconds), i18n("Shift Line Times")));
 }
 
 void
@@ -556,8 +668,8 @@ SubtitleLine::adjustTimes(double shiftMseconds, double scaleFactor)
 {
 	if(shiftMseconds || scaleFactor != 1.0)
 		processAction(new SetLineTimesAction(this,
-			Time(m_showTime.toMillis() * scaleFactor + shiftMseconds),
-			Time(m_hideTime.toMillis() * scaleFactor + shiftMseconds),
+			Time(showTime().toMillis() * scaleFactor + shiftMseconds),
+			Time(hideTime().toMillis() * scaleFactor + shiftMseconds),
 			i18n("Adjust Line Times")));
 }
 
@@ -565,6 +677,8 @@ void
 SubtitleLine::setPosition(const SubtitleRect &pos)
 {
 	m_position = pos;
+	if(m_subtitle)
+		m_subtitle->invalidateSnapshot(index(), index());
 	emit positionChanged();
 }
 
@@ -576,6 +690,22 @@ SubtitleLine::errorFlags() const
 	return m_errorFlags;
 }
 
+int
+SubtitleLine::metaRemove(const QByteArray &key)
+{
+	if(m_subtitle)
+		m_subtitle->invalidateSnapshot(index(), index());
+	return m_metaData.remove(key);
+}
+
+void
+SubtitleLine::meta(const QByteArray &key, const QString &value)
+{
+	if(m_subtitle)
+		m_subtitle->invalidateSnapshot(index(), index());
+	m_metaData.insert(key, value);
+}
+
 int
 SubtitleLine::errorCount() const
 {
@@ -598,7 +728,7 @@ SubtitleLine::setErrorFlags(int errorFlags, bool value)
 bool
 SubtitleLine::checkEmptyPrimaryText(bool update)
 {
-	bool error = m_primaryDoc->isEmpty() || m_primaryDoc->toPlainText().trimmed().isEmpty();
+	bool error = textStats(true).characters == 0;
 
 	if(update)
 		setErrorFlags(EmptyPrimaryText, error);
@@ -609,7 +739,7 @@ SubtitleLine::checkEmptyPrimaryText(bool update)
 bool
 SubtitleLine::checkEmptySecondaryText(bool update)
 {
-	bool error = m_secondaryDoc->isEmpty() || m_secondaryDoc->toPlainText().trimmed().isEmpty();
+	bool error = textStats(false).characters == 0;
 
 	if(update)
 		setErrorFlags(EmptySecondaryText, error);
@@ -620,7 +750,9 @@ SubtitleLine::checkEmptySecondaryText(bool update)
 bool
 SubtitleLine::checkUntranslatedText(bool update)
 {
-	bool error = m_primaryDoc->toPlainText() == m_secondaryDoc->toPlainText();
+	// identical texts are interned and share their data when documents aren't created
+	bool error = (!m_primaryDoc && !m_secondaryDoc && m_primaryText.isSharedWith(m_secondaryText))
+		|| (textStats(true).hash == textStats(false).hash && plainText(true) == plainText(false));
 
 	if(update)
 		setErrorFlags(UntranslatedText, error);
@@ -631,8 +763,8 @@ SubtitleLine::checkUntranslatedText(bool update)
 bool
 SubtitleLine::checkOverlapsWithNext(bool update)
 {
-	SubtitleLine *nextLine = this->nextLine();
-	bool error = nextLine && nextLine->m_showTime <= m_hideTime;
+	// any following line, not just the next one, can start first on unsorted subtitles
+	bool error = m_subtitle && m_subtitle->followingShowTime(index()) <= hideTime().toMillis();
 
 	if(update)
 		setErrorFlags(OverlapsWithNext, error);
@@ -779,17 +911,7 @@ SubtitleLine::checkMaxPrimaryCharsPerLine(int maxCharactersPerLine, bool update)
 {
 	Q_ASSERT(maxCharactersPerLine >= 0);
 
-	bool error = false;
-
-	QString text = primaryDoc()->toPlainText();
-	QStringList lines = text.split(u'\n');
-
-	for(auto line = lines.cbegin(); line != lines.cend(); ++line) {
-		if(line->simplified().length() > maxCharactersPerLine) {
-			error = true;
-			break;
-		}
-	}
+	bool error = textStats(true).maxLineCharacters > maxCharactersPerLine;
 
 	if(update)
 		setErrorFlags(MaxPrimaryCharsPerLine, error);
@@ -802,17 +924,7 @@ SubtitleLine::checkMaxSecondaryCharsPerLine(int maxCharactersPerLine, bool updat
 {
 	Q_ASSERT(maxCharactersPerLine >= 0);
 
-	bool error = false;
-
-	QString text = secondaryDoc()->toPlainText();
-	QStringList lines = text.split(u'\n');
-
-	for(auto line = lines.cbegin(); line != lines.cend(); ++line) {
-		if(line->simplified().length() > maxCharactersPerLine) {
-			error = true;
-			break;
-		}
-	}
+	bool error = textStats(false).maxLineCharacters > maxCharactersPerLine;
 
 	if(update)
 		setErrorFlags(MaxSecondaryCharsPerLine, error);
@@ -820,12 +932,46 @@ SubtitleLine::checkMaxSecondaryCharsPerLine(int maxCharactersPerLine, bool updat
 	return error;
 }
 
-bool
-SubtitleLine::checkPrimaryUnneededSpaces(bool update)
+/**
+ * @brief Unneeded spaces are looked for in each line separately, same as RichDocument::indexOf() does with blocks
+ */
+static bool
+hasUnneededSpaces(const QString &rawText)
 {
 	static const QRegularExpression unneededSpaceRegExp("(^\\s|\\s$|¿\\s|¡\\s|\\s\\s|\\s!|\\s\\?|\\s:|\\s;|\\s,|\\s\\.)");
 
-	bool error = m_primaryDoc->indexOf(unneededSpaceRegExp) != -1;
+	const QStringList lines = rawText.split(QChar::LineFeed);
+	for(const QString &line : lines) {
+		if(unneededSpaceRegExp.match(line).hasMatch())
+			return true;
+	}
+	return false;
+}
+
+static bool
+hasCapitalAfterEllipsis(const QString &text)
+{
+	staticRE$(capitalAfterEllipsisRegExp, "^\\s*\\.\\.\\.[¡¿\\.,;\\(\\[\\{\"'\\s]*", REu);
+
+	QRegularExpressionMatchIterator it = capitalAfterEllipsisRegExp.globalMatch(text);
+	if(!it.hasNext())
+		return false;
+	const QChar chr = text.at(it.next().capturedEnd());
+	return chr.isLetter() && chr == chr.toUpper();
+}
+
+static bool
+hasUnneededDash(const QString &text)
+{
+	staticRE$(unneededDashRegExp, "(^|\n)\\s*-[^-]", REu);
+
+	return text.count(unneededDashRegExp) == 1;
+}
+
+bool
+SubtitleLine::checkPrimaryUnneededSpaces(bool update)
+{
+	bool error = hasUnneededSpaces(rawText(true));
 
 	if(update)
 		setErrorFlags(PrimaryUnneededSpaces, error);
@@ -836,9 +982,7 @@ SubtitleLine::checkPrimaryUnneededSpaces(bool update)
 bool
 SubtitleLine::checkSecondaryUnneededSpaces(bool update)
 {
-	static const QRegularExpression unneededSpaceRegExp("(^\\s|\\s$|¿\\s|¡\\s|\\s\\s|\\s!|\\s\\?|\\s:|\\s;|\\s,|\\s\\.)");
-
-	bool error = m_secondaryDoc->indexOf(unneededSpaceRegExp) != -1;
+	bool error = hasUnneededSpaces(rawText(false));
 
 	if(update)
 		setErrorFlags(SecondaryUnneededSpaces, error);
@@ -849,15 +993,7 @@ SubtitleLine::checkSecondaryUnneededSpaces(bool update)
 bool
 SubtitleLine::checkPrimaryCapitalAfterEllipsis(bool update)
 {
-	staticRE$(capitalAfterEllipsisRegExp, "^\\s*\\.\\.\\.[¡¿\\.,;\\(\\[\\{\"'\\s]*", REu);
-
-	const QString text = m_primaryDoc->toPlainText();
-	QRegularExpressionMatchIterator it = capitalAfterEllipsisRegExp.globalMatch(text);
-	bool success = it.hasNext();
-	if(success) {
-		const QChar chr = text.at(it.next().capturedEnd());
-		success = chr.isLetter() && chr == chr.toUpper();
-	}
+	bool success = hasCapitalAfterEllipsis(plainText(true));
 
 	if(update)
 		setErrorFlags(PrimaryCapitalAfterEllipsis, success);
@@ -868,15 +1004,7 @@ SubtitleLine::checkPrimaryCapitalAfterEllipsis(bool update)
 bool
 SubtitleLine::checkSecondaryCapitalAfterEllipsis(bool update)
 {
-	staticRE$(capitalAfterEllipsisRegExp, "^\\s*\\.\\.\\.[¡¿\\.,;\\(\\[\\{\"'\\s]*", REu);
-
-	const QString text = m_secondaryDoc->toPlainText();
-	QRegularExpressionMatchIterator it = capitalAfterEllipsisRegExp.globalMatch(text);
-	bool success = it.hasNext();
-	if(success) {
-		const QChar chr = text.at(it.next().capturedEnd());
-		success = chr.isLetter() && chr == chr.toUpper();
-	}
+	bool success = hasCapitalAfterEllipsis(plainText(false));
 
 	if(update)
 		setErrorFlags(SecondaryCapitalAfterEllipsis, success);
@@ -887,9 +1015,7 @@ SubtitleLine::checkSecondaryCapitalAfterEllipsis(bool update)
 bool
 SubtitleLine::checkPrimaryUnneededDash(bool update)
 {
-	staticRE$(unneededDashRegExp, "(^|\n)\\s*-[^-]", REu);
-
-	bool success = m_primaryDoc->toPlainText().count(unneededDashRegExp) == 1;
+	bool success = hasUnneededDash(plainText(true));
 
 	if(update)
 		setErrorFlags(PrimaryUnneededDash, success);
@@ -900,9 +1026,7 @@ SubtitleLine::checkPrimaryUnneededDash(bool update)
 bool
 SubtitleLine::checkSecondaryUnneededDash(bool update)
 {
-	staticRE$(unneededDashRegExp, "(^|\n)\\s*-[^-]", REu);
-
-	bool success = m_secondaryDoc->toPlainText().count(unneededDashRegExp) == 1;
+	bool success = hasUnneededDash(plainText(false));
 
 	if(update)
 		setErrorFlags(SecondaryUnneededDash, success);
@@ -910,98 +1034,92 @@ SubtitleLine::checkSecondaryUnneededDash(bool update)
 	return success;
 }
 
-int
-SubtitleLine::check(int errorFlagsToCheck, bool update)
+SubtitleLine::CheckLimits
+SubtitleLine::checkLimits()
 {
-	int lineErrorFlags = m_errorFlags & ~errorFlagsToCheck; // clear the flags we're going to (re)check
-
-	if(errorFlagsToCheck & EmptyPrimaryText)
-		if(checkEmptyPrimaryText(false))
-			lineErrorFlags |= EmptyPrimaryText;
-
-	if(errorFlagsToCheck & EmptySecondaryText)
-		if(checkEmptySecondaryText(false))
-			lineErrorFlags |= EmptySecondaryText;
-
-	if(errorFlagsToCheck & OverlapsWithNext)
-		if(checkOverlapsWithNext(false))
-			lineErrorFlags |= OverlapsWithNext;
-
-	if(errorFlagsToCheck & UntranslatedText)
-		if(checkUntranslatedText(false))
-			lineErrorFlags |= UntranslatedText;
-
-	if(errorFlagsToCheck & MaxDuration)
-		if(checkMaxDuration(SCConfig::maxDuration(), false))
-			lineErrorFlags |= MaxDuration;
-
-	if(errorFlagsToCheck & MinDuration)
-		if(checkMinDuration(SCConfig::minDuration(), false))
-			lineErrorFlags |= MinDuration;
-
-	if(errorFlagsToCheck & MaxDurationPerPrimaryChar)
-		if(checkMaxDurationPerPrimaryChar(SCConfig::maxDurationPerCharacter(), false))
-			lineErrorFlags |= MaxDurationPerPrimaryChar;
-
-	if(errorFlagsToCheck & MaxDurationPerSecondaryChar)
-		if(checkMaxDurationPerSecondaryChar(SCConfig::maxDurationPerCharacter(), false))
-			lineErrorFlags |= MaxDurationPerSecondaryChar;
-
-	if(errorFlagsToCheck & MinDurationPerPrimaryChar)
-		if(checkMinDurationPerPrimaryChar(SCConfig::minDurationPerCharacter(), false))
-			lineErrorFlags |= MinDurationPerPrimaryChar;
-
-	if(errorFlagsToCheck & MinDurationPerSecondaryChar)
-		if(checkMinDurationPerSecondaryChar(SCConfig::minDurationPerCharacter(), false))
-			lineErrorFlags |= MinDurationPerSecondaryChar;
-
-	if(errorFlagsToCheck & MaxPrimaryChars)
-		if(checkMaxPrimaryChars(SCConfig::maxCharacters(), false))
-			lineErrorFlags |= MaxPrimaryChars;
-
-	if(errorFlagsToCheck & MaxSecondaryChars)
-		if(checkMaxSecondaryChars(SCConfig::maxCharacters(), false))
-			lineErrorFlags |= MaxSecondaryChars;
-
-	if(errorFlagsToCheck & MaxPrimaryLines)
-		if(checkMaxPrimaryLines(SCConfig::maxLines(), false))
-			lineErrorFlags |= MaxPrimaryLines;
-
-	if(errorFlagsToCheck & MaxSecondaryLines)
-		if(checkMaxSecondaryLines(SCConfig::maxLines(), false))
-			lineErrorFlags |= MaxSecondaryLines;
-
-	if(errorFlagsToCheck & MaxPrimaryCharsPerLine)
-		if(checkMaxPrimaryCharsPerLine(SCConfig::maxCharactersPerLine(), false))
-			lineErrorFlags |= MaxPrimaryCharsPerLine;
-
-	if(errorFlagsToCheck & MaxSecondaryCharsPerLine)
-		if(checkMaxSecondaryCharsPerLine(SCConfig::maxCharactersPerLine(), false))
-			lineErrorFlags |= MaxSecondaryCharsPerLine;
-
-	if(errorFlagsToCheck & PrimaryUnneededSpaces)
-		if(checkPrimaryUnneededSpaces(false))
-			lineErrorFlags |= PrimaryUnneededSpaces;
-
-	if(errorFlagsToCheck & SecondaryUnneededSpaces)
-		if(checkSecondaryUnneededSpaces(false))
-			lineErrorFlags |= SecondaryUnneededSpaces;
+	CheckLimits limits;
+	limits.minDuration = SCConfig::minDuration();
+	limits.maxDuration = SCConfig::maxDuration();
+	limits.minDurationPerCharacter = SCConfig::minDurationPerCharacter();
+	limits.maxDurationPerCharacter = SCConfig::maxDurationPerCharacter();
+	limits.maxCharacters = SCConfig::maxCharacters();
+	limits.maxLines = SCConfig::maxLines();
+	limits.maxCharactersPerLine = SCConfig::maxCharactersPerLine();
+	return limits;
+}
 
-	if(errorFlagsToCheck & PrimaryCapitalAfterEllipsis)
-		if(checkPrimaryCapitalAfterEllipsis(false))
-			lineErrorFlags |= PrimaryCapitalAfterEllipsis;
+SubtitleLine::CheckSnapshot
+SubtitleLine::checkSnapshot() const
+{
+	CheckSnapshot snapshot;
+	snapshot.primaryText = rawText(true);
+	snapshot.secondaryText = rawText(false);
+	snapshot.primaryStats = m_primaryStats;
+	snapshot.secondaryStats = m_secondaryStats;
+	snapshot.showTime = showTime().toMillis();
+	snapshot.hideTime = hideTime().toMillis();
+	if(m_subtitle)
+		snapshot.nextShowTime = m_subtitle->followingShowTime(index());
+	snapshot.errorFlags = m_errorFlags;
+	return snapshot;
+}
 
-	if(errorFlagsToCheck & SecondaryCapitalAfterEllipsis)
-		if(checkSecondaryCapitalAfterEllipsis(false))
-			lineErrorFlags |= SecondaryCapitalAfterEllipsis;
+int
+SubtitleLine::check(CheckSnapshot *line, int errorFlagsToCheck, const CheckLimits &limits)
+{
+	int lineErrorFlags = line->errorFlags & ~errorFlagsToCheck; // clear the flags we're going to (re)check
+
+	if(!(errorFlagsToCheck & AllErrors))
+		return lineErrorFlags;
+
+	const QString primaryText = toPlainText(line->primaryText);
+	const QString secondaryText = toPlainText(line->secondaryText);
+	if(line->primaryStats.characters == -1)
+		line->primaryStats = textStats(primaryText);
+	if(line->secondaryStats.characters == -1)
+		line->secondaryStats = textStats(secondaryText);
+	const TextStats &primary = line->primaryStats;
+	const TextStats &secondary = line->secondaryStats;
+	const double duration = qMax(0., line->hideTime - line->showTime); // same as durationTime()
+
+	const auto flag = [&](int errorFlag, auto test){
+		if((errorFlagsToCheck & errorFlag) && test())
+			lineErrorFlags |= errorFlag;
+	};
+
+	flag(EmptyPrimaryText, [&](){ return primary.characters == 0; });
+	flag(EmptySecondaryText, [&](){ return secondary.characters == 0; });
+	flag(OverlapsWithNext, [&](){ return line->nextShowTime <= line->hideTime; });
+	flag(UntranslatedText, [&](){ return primary.hash == secondary.hash && primaryText == secondaryText; });
+	flag(MaxDuration, [&](){ return duration > limits.maxDuration; });
+	flag(MinDuration, [&](){ return duration < limits.minDuration; });
+	flag(MaxDurationPerPrimaryChar, [&](){ return primary.characters && duration / primary.characters > limits.maxDurationPerCharacter; });
+	flag(MaxDurationPerSecondaryChar, [&](){ return secondary.characters && duration / secondary.characters > limits.maxDurationPerCharacter; });
+	flag(MinDurationPerPrimaryChar, [&](){ return primary.characters && duration / primary.characters < limits.minDurationPerCharacter; });
+	flag(MinDurationPerSecondaryChar, [&](){ return secondary.characters && duration / secondary.characters < limits.minDurationPerCharacter; });
+	flag(MaxPrimaryChars, [&](){ return primary.characters > limits.maxCharacters; });
+	flag(MaxSecondaryChars, [&](){ return secondary.characters > limits.maxCharacters; });
+	flag(MaxPrimaryLines, [&](){ return primary.lines > limits.maxLines; });
+	flag(MaxSecondaryLines, [&](){ return secondary.lines > limits.maxLines; });
+	flag(MaxPrimaryCharsPerLine, [&](){ return primary.maxLineCharacters > limits.maxCharactersPerLine; });
+	flag(MaxSecondaryCharsPerLine, [&](){ return secondary.maxLineCharacters > limits.maxCharactersPerLine; });
+	flag(PrimaryUnneededSpaces, [&](){ return hasUnneededSpaces(line->primaryText); });
+	flag(SecondaryUnneededSpaces, [&](){ return hasUnneededSpaces(line->secondaryText); });
+	flag(PrimaryCapitalAfterEllipsis, [&](){ return hasCapitalAfterEllipsis(primaryText); });
+	flag(SecondaryCapitalAfterEllipsis, [&](){ return hasCapitalAfterEllipsis(secondaryText); });
+	flag(PrimaryUnneededDash, [&](){ return hasUnneededDash(primaryText); });
+	flag(SecondaryUnneededDash, [&](){ return hasUnneededDash(secondaryText); });
 
-	if(errorFlagsToCheck & PrimaryUnneededDash)
-		if(checkPrimaryUnneededDash(false))
-			lineErrorFlags |= PrimaryUnneededDash;
+	return lineErrorFlags;
+}
 
-	if(errorFlagsToCheck & SecondaryUnneededDash)
-		if(checkSecondaryUnneededDash(false))
-			lineErrorFlags |= SecondaryUnneededDash;
+int
+SubtitleLine::check(int errorFlagsToCheck, bool update)
+{
+	CheckSnapshot snapshot = checkSnapshot();
+	const int lineErrorFlags = check(&snapshot, errorFlagsToCheck, checkLimits());
+	m_primaryStats = snapshot.primaryStats;
+	m_secondaryStats = snapshot.secondaryStats;
 
 	if(update)
 		setErrorFlags(lineErrorFlags);
@@ -10,6 +10,7 @@
 
 #include "core/time.h"
 #include "core/formatdata.h"
+#include "core/richstring.h"
 #include "core/subtitletarget.h"
 #include "helpers/objectref.h"
 
@@ -17,11 +18,12 @@
 #include <QObject>
 #include <QString>
 
+#include <limits>
+
 class QUndoCommand;
 
 namespace SubtitleComposer {
 class Subtitle;
-class RichString;
 class RichDocument;
 class UndoAction;
 
@@ -44,6 +46,7 @@ class SubtitleLine : public QObject
 	friend class Subtitle;
 	friend class SubtitleAction;
 	friend class SwapLinesTextsAction;
+	friend class SetLinesErrorsAction;
 	friend class SubtitleLineAction;
 	friend class SetLinePrimaryTextAction;
 	friend class SetLineSecondaryTextAction;
@@ -55,6 +58,7 @@ class SubtitleLine : public QObject
 	friend class SetLineErrorsAction;
 	friend class ToggleLineMarkedAction;
 	friend class Format;
+	friend class InputFormat;
 	friend class ObjectRef<SubtitleLine>;
 
 public:
@@ -148,31 +152,45 @@ public:
 	inline SubtitleLine * prevLine() const;
 	inline SubtitleLine * nextLine() const;
 
-	inline RichDocument * doc(bool primary) const { return primary ? m_primaryDoc : m_secondaryDoc; }
-	inline RichDocument * primaryDoc() const { return m_primaryDoc; }
-	inline RichDocument * secondaryDoc() const { return m_secondaryDoc; }
+	inline RichDocument * doc(bool primary) const { return primary ? primaryDoc() : secondaryDoc(); }
+	inline RichDocument * primaryDoc() const { return m_primaryDoc ? touchDoc(m_primaryDoc) : materializeDoc(true); }
+	inline RichDocument * secondaryDoc() const { return m_secondaryDoc ? touchDoc(m_secondaryDoc) : materializeDoc(false); }
+
+	/**
+	 * @brief Line text, read without creating the document
+	 */
+	RichString primaryText() const;
+	RichString secondaryText() const;
+	QString plainText(bool primary) const;
+	static QString toPlainText(QString rawText);
+
+	/**
+	 * @brief Replace text and drop its undo history - for lines that are being loaded
+	 */
+	void resetPrimaryText(const RichString &text);
+	void resetSecondaryText(const RichString &text);
 
 	void breakText(int minBreakLength, SubtitleTarget target);
 	void unbreakText(SubtitleTarget target);
 	void simplifyTextWhiteSpace(SubtitleTarget target);
 
-	inline Time showTime() const { return m_showTime; }
+	inline Time showTime() const;
 	void setShowTime(const Time &showTime);
 
-	inline Time hideTime() const { return m_hideTime; }
+	inline Time hideTime() const;
 	void setHideTime(const Time &hideTime);
 
-	inline double duration() const { return m_hideTime.toMillis() - m_showTime.toMillis(); }
+	inline double duration() const { return hideTime().toMillis() - showTime().toMillis(); }
 	inline Time durationTime() const { return Time(duration()); }
-	inline void setDurationTime(const Time &durationTime) { setHideTime(m_showTime + durationTime); }
+	inline void setDurationTime(const Time &durationTime) { setHideTime(showTime() + durationTime); }
 	QColor durationColor(const QColor &textColor, bool usePrimary=true);
 
 	inline Time pauseTime() const { const SubtitleLine *p = prevLine(); return Time(showTime().toMillis() - (p ? p->hideTime().toMillis() : 0.)); }
 
 	void setTimes(const Time &showTime, const Time &hideTime);
 
-	inline bool containsTime(const Time &time) const { return m_showTime <= time && time <= m_hideTime; }
-	inline bool intersectsTimespan(const Time &start, const Time &end) const { return m_showTime <= end && start <= m_hideTime; }
+	inline bool containsTime(const Time &time) const { return showTime() <= time && time <= hideTime(); }
+	inline bool intersectsTimespan(const Time &start, const Time &end) const { return showTime() <= end && start <= hideTime(); }
 
 	int primaryCharacters() const;
 	int primaryWords() const;
@@ -223,9 +241,9 @@ public:
 	int check(int errorFlagsToCheck, bool update = true);
 
 	inline bool metaExists(const QByteArray &key) const { return m_metaData.contains(key); }
-	inline int metaRemove(const QByteArray &key) { return m_metaData.remove(key); }
+	int metaRemove(const QByteArray &key);
 	inline const QString meta(const QByteArray &key) const { return m_metaData.value(key); }
-	inline void meta(const QByteArray &key, const QString &value) { m_metaData.insert(key, value); }
+	void meta(const QByteArray &key, const QString &value);
 
 	inline const SubtitleRect & pos() const { return m_position; }
 	void setPosition(const SubtitleRect &pos);
@@ -245,13 +263,65 @@ private:
 	void processAction(UndoAction *action);
 	void processShowTimeSort(const Time &showTime);
 
-	void setPrimaryDoc(RichDocument *doc);
-	void setSecondaryDoc(RichDocument *doc);
-	void setTexts(RichDocument *pText, RichDocument *sText);
+	inline void storeShowTime(const Time &showTime);
+	inline void storeHideTime(const Time &hideTime);
+
+	RichDocument * materializeDoc(bool primary) const;
+	RichDocument * touchDoc(RichDocument *doc) const;
+	bool releaseDoc(bool primary) const;
+	void unlinkDoc() const;
+	void resetText(bool primary, const RichString &text);
+
 	void primaryDocumentChanged();
 	void secondaryDocumentChanged();
 
-	void setupSignals();
+	struct TextStats {
+		int characters = -1; // -1 when stats need to be recalculated
+		int words = 0;
+		int lines = 0;
+		int maxLineCharacters = 0;
+		// counts on simplifyWhiteSpace() text used by autoDuration()
+		int durationCharacters = 0;
+		int durationWords = 0;
+		size_t hash = 0;
+	};
+	static TextStats textStats(const QString &plainText);
+	const TextStats & textStats(bool primary) const;
+	inline void invalidateTextStats(bool primary) const { (primary ? m_primaryStats : m_secondaryStats).characters = -1; }
+
+	// copy of everything check() looks at, so lines can be checked away from the gui thread
+	struct CheckSnapshot {
+		QString primaryText; // raw text - lines are separated by \n, but nbsp's etc. are kept
+		QString secondaryText;
+		TextStats primaryStats;
+		TextStats secondaryStats;
+		double showTime = 0.;
+		double hideTime = 0.;
+		double nextShowTime = std::numeric_limits<double>::infinity(); // earliest show time of following lines
+		int errorFlags = 0;
+	};
+	struct CheckLimits {
+		int minDuration;
+		int maxDuration;
+		int minDurationPerCharacter;
+		int maxDurationPerCharacter;
+		int maxCharacters;
+		int maxLines;
+		int maxCharactersPerLine;
+	};
+	static CheckLimits checkLimits();
+	CheckSnapshot checkSnapshot() const;
+	static int check(CheckSnapshot *line, int errorFlagsToCheck, const CheckLimits &limits);
+	QString rawText(bool primary) const;
+
+	/**
+	 * @brief Report change to owning subtitle directly and emit line's own signal for any single-line listeners
+	 */
+	inline void notifyPrimaryTextChanged();
+	inline void notifySecondaryTextChanged();
+	inline void notifyShowTimeChanged();
+	inline void notifyHideTimeChanged();
+	inline void notifyErrorFlagsChanged();
 
 	inline bool ignoreDocChanges(bool ignore) {
 		bool r = m_ignoreDocChanges;
@@ -261,8 +331,17 @@ private:
 
 private:
 	QExplicitlySharedDataPointer<Subtitle> m_subtitle;
-	RichDocument *m_primaryDoc;
-	RichDocument *m_secondaryDoc;
+	// documents are created on first access, until then (and after eviction) text is kept in m_*Text
+	mutable RichDocument *m_primaryDoc = nullptr;
+	mutable RichDocument *m_secondaryDoc = nullptr;
+	mutable RichString m_primaryText;
+	mutable RichString m_secondaryText;
+	mutable TextStats m_primaryStats;
+	mutable TextStats m_secondaryStats;
+	// subtitle's LRU list of lines with created documents
+	mutable SubtitleLine *m_docPrev = nullptr;
+	mutable SubtitleLine *m_docNext = nullptr;
+	// times are kept in subtitle's time arrays while the line belongs to one
 	Time m_showTime;
 	Time m_hideTime;
 	int m_errorFlags;
@@ -295,6 +374,76 @@ SubtitleLine::nextLine() const
 	return m_subtitle ? m_subtitle->line(index() + 1) : nullptr;
 }
 
+inline Time
+SubtitleLine::showTime() const
+{
+	return m_subtitle ? Time(m_subtitle->m_showTimes.at(index())) : m_showTime;
+}
+
+inline Time
+SubtitleLine::hideTime() const
+{
+	return m_subtitle ? Time(m_subtitle->m_hideTimes.at(index())) : m_hideTime;
+}
+
+inline void
+SubtitleLine::storeShowTime(const Time &showTime)
+{
+	if(m_subtitle)
+		m_subtitle->m_showTimes[index()] = showTime.toMillis();
+	else
+		m_showTime = showTime;
+}
+
+inline void
+SubtitleLine::storeHideTime(const Time &hideTime)
+{
+	if(m_subtitle)
+		m_subtitle->m_hideTimes[index()] = hideTime.toMillis();
+	else
+		m_hideTime = hideTime;
+}
+
+inline void
+SubtitleLine::notifyPrimaryTextChanged()
+{
+	emit primaryTextChanged();
+	if(m_subtitle)
+		m_subtitle->lineChanged(this, Subtitle::PrimaryTextField);
+}
+
+inline void
+SubtitleLine::notifySecondaryTextChanged()
+{
+	emit secondaryTextChanged();
+	if(m_subtitle)
+		m_subtitle->lineChanged(this, Subtitle::SecondaryTextField);
+}
+
+inline void
+SubtitleLine::notifyShowTimeChanged()
+{
+	emit showTimeChanged(showTime());
+	if(m_subtitle)
+		m_subtitle->lineChanged(this, Subtitle::ShowTimeField);
+}
+
+inline void
+SubtitleLine::notifyHideTimeChanged()
+{
+	emit hideTimeChanged(hideTime());
+	if(m_subtitle)
+		m_subtitle->lineChanged(this, Subtitle::HideTimeField);
+}
+
+inline void
+SubtitleLine::notifyErrorFlagsChanged()
+{
+	emit errorFlagsChanged(m_errorFlags);
+	if(m_subtitle)
+		m_subtitle->lineChanged(this, Subtitle::ErrorFlagsField);
+}
+
 }
 
 #endif
@@ -0,0 +1,76 @@
+/*
+    SPDX-FileCopyrightText: 2010-2022 Mladen Milinkovic <max@smoothware.net>
+
+    SPDX-License-Identifier: GPL-2.0-or-later
+*/
+
+#ifndef SUBTITLESNAPSHOT_H
+#define SUBTITLESNAPSHOT_H
+
+#include "core/formatdata.h"
+#include "core/richstring.h"
+#include "core/subtitleline.h"
+#include "core/time.h"
+
+#include <QByteArray>
+#include <QMap>
+#include <QSharedPointer>
+#include <QString>
+#include <QVector>
+
+namespace SubtitleComposer {
+/**
+ * @brief Read-only copy of subtitle contents that can be used from any thread
+ * All data is implicitly shared with the subtitle, lines are kept in chunks so editing a line
+ * only makes the next snapshot rebuild that line's chunk.
+ */
+class SubtitleSnapshot
+{
+	friend class Subtitle;
+
+public:
+	enum { ChunkShift = 8, ChunkSize = 1 << ChunkShift, ChunkMask = ChunkSize - 1 };
+
+	inline int count() const { return m_showTimes.size(); }
+	inline bool isEmpty() const { return m_showTimes.isEmpty(); }
+
+	inline double framesPerSecond() const { return m_framesPerSecond; }
+	inline const QString & stylesheet() const { return m_stylesheet; }
+	inline const QString meta(const QByteArray &key) const { return m_metaData.value(key); }
+	inline bool metaExists(const QByteArray &key) const { return m_metaData.contains(key); }
+	inline const FormatData * formatData() const { return m_formatData.data(); }
+
+	inline Time showTime(int index) const { return m_showTimes.at(index); }
+	inline Time hideTime(int index) const { return m_hideTimes.at(index); }
+	inline const RichString & primaryText(int index) const { return line(index).primaryText; }
+	inline const RichString & secondaryText(int index) const { return line(index).secondaryText; }
+	inline QString plainText(int index, bool primary) const { return SubtitleLine::toPlainText((primary ? primaryText(index) : secondaryText(index)).string()); }
+	inline int errorFlags(int index) const { return line(index).errorFlags; }
+	inline const QString meta(int index, const QByteArray &key) const { return line(index).metaData.value(key); }
+	inline const SubtitleRect & pos(int index) const { return line(index).position; }
+	inline const FormatData * formatData(int index) const { return line(index).formatData.data(); }
+
+private:
+	struct Line {
+		RichString primaryText;
+		RichString secondaryText;
+		int errorFlags;
+		QMap<QByteArray, QString> metaData;
+		SubtitleRect position;
+		QSharedPointer<const FormatData> formatData;
+	};
+	typedef QVector<Line> Chunk;
+
+	inline const Line & line(int index) const { return m_chunks.at(index >> ChunkShift)->at(index & ChunkMask); }
+
+	double m_framesPerSecond = 0.;
+	QString m_stylesheet;
+	QMap<QByteArray, QString> m_metaData;
+	QSharedPointer<const FormatData> m_formatData;
+	QVector<double> m_showTimes;
+	QVector<double> m_hideTimes;
+	QVector<QSharedPointer<const Chunk>> m_chunks;
+};
+}
+
+#endif // SUBTITLESNAPSHOT_H
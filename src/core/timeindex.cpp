@@ -0,0 +1,133 @@
+/*
+    SPDX-FileCopyrightText: 2010-2022 Mladen Milinkovic <max@smoothware.net>
+
+    SPDX-License-Identifier: GPL-2.0-or-later
+*/
+
+#include "timeindex.h"
+
+#include <QVarLengthArray>
+
+#include <algorithm>
+#include <limits>
+
+using namespace SubtitleComposer;
+
+void
+TimeIndex::reset(int count)
+{
+	m_count = count;
+	m_size = 1;
+	while(m_size < count)
+		m_size <<= 1;
+	// unused leaves never match
+	m_minShow.fill(std::numeric_limits<double>::infinity(), 2 * m_size);
+	m_maxHide.fill(-std::numeric_limits<double>::infinity(), 2 * m_size);
+}
+
+void
+TimeIndex::build()
+{
+	for(int node = m_size - 1; node > 0; node--)
+		pull(node);
+}
+
+void
+TimeIndex::build(int first, int last)
+{
+	for(int l = (m_size + first) >> 1, r = (m_size + last) >> 1; l > 0; l >>= 1, r >>= 1) {
+		for(int node = l; node <= r; node++)
+			pull(node);
+	}
+}
+
+void
+TimeIndex::update(int index, double showTime, double hideTime)
+{
+	Q_ASSERT(index >= 0 && index < m_count);
+	set(index, showTime, hideTime);
+	for(int node = (m_size + index) >> 1; node > 0; node >>= 1)
+		pull(node);
+}
+
+void
+TimeIndex::insert(int index, int count)
+{
+	Q_ASSERT(index >= 0 && index <= m_count);
+	const int oldCount = m_count;
+	if(oldCount + count > m_size) {
+		// out of leaves - double the tree, nodes left of the new lines won't be rebuilt by the caller
+		const QVector<double> minShow = m_minShow.mid(m_size, oldCount);
+		const QVector<double> maxHide = m_maxHide.mid(m_size, oldCount);
+		reset(qMax(oldCount + count, 2 * m_size));
+		std::copy(minShow.cbegin(), minShow.cbegin() + index, m_minShow.begin() + m_size);
+		std::copy(maxHide.cbegin(), maxHide.cbegin() + index, m_maxHide.begin() + m_size);
+		std::copy(minShow.cbegin() + index, minShow.cend(), m_minShow.begin() + m_size + index + count);
+		std::copy(maxHide.cbegin() + index, maxHide.cend(), m_maxHide.begin() + m_size + index + count);
+		m_count = oldCount + count;
+		build(0, index);
+		return;
+	}
+	m_count += count;
+	double *minShow = m_minShow.data() + m_size;
+	double *maxHide = m_maxHide.data() + m_size;
+	std::copy_backward(minShow + index, minShow + oldCount, minShow + m_count);
+	std::copy_backward(maxHide + index, maxHide + oldCount, maxHide + m_count);
+}
+
+void
+TimeIndex::remove(int index, int count)
+{
+	Q_ASSERT(index >= 0 && index + count <= m_count);
+	const int oldCount = m_count;
+	m_count -= count;
+	double *minShow = m_minShow.data() + m_size;
+	double *maxHide = m_maxHide.data() + m_size;
+	std::copy(minShow + index + count, minShow + oldCount, minShow + index);
+	std::copy(maxHide + index + count, maxHide + oldCount, maxHide + index);
+	// unused leaves never match
+	std::fill(minShow + m_count, minShow + oldCount, std::numeric_limits<double>::infinity());
+	std::fill(maxHide + m_count, maxHide + oldCount, -std::numeric_limits<double>::infinity());
+	if(count)
+		build(index, oldCount - 1);
+}
+
+void
+TimeIndex::intersecting(double start, double end, QVector<int> *indexes) const
+{
+	if(!m_count)
+		return;
+
+	// depth first, left child on top of the stack keeps results sorted
+	QVarLengthArray<int, 64> stack;
+	stack.append(1);
+	while(!stack.isEmpty()) {
+		const int node = stack.last();
+		stack.removeLast();
+		if(m_minShow.at(node) > end || m_maxHide.at(node) < start)
+			continue;
+		if(node >= m_size) {
+			indexes->append(node - m_size);
+			continue;
+		}
+		stack.append(2 * node + 1);
+		stack.append(2 * node);
+	}
+}
+
+double
+TimeIndex::minShowTime(int first, int last) const
+{
+	double res = std::numeric_limits<double>::infinity();
+	if(first < 0)
+		first = 0;
+	if(last >= m_count)
+		last = m_count - 1;
+	for(int l = m_size + first, r = m_size + last + 1; l < r; l >>= 1, r >>= 1) {
+		if(l & 1)
+			res = qMin(res, m_minShow.at(l++));
+		if(r & 1)
+			res = qMin(res, m_minShow.at(--r));
+	}
+	return res;
+}
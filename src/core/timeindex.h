@@ -0,0 +1,68 @@
+/*
+    SPDX-FileCopyrightText: 2010-2022 Mladen Milinkovic <max@smoothware.net>
+
+    SPDX-License-Identifier: GPL-2.0-or-later
+*/
+
+#ifndef TIMEINDEX_H
+#define TIMEINDEX_H
+
+#include <QVector>
+
+namespace SubtitleComposer {
+/**
+ * @brief Segment tree over line order, every node keeps earliest show time and latest hide time of its lines
+ * Subtrees that can't contain a match are skipped, so on subtitles sorted by show time queries take O(log n + k).
+ */
+class TimeIndex
+{
+public:
+	inline int count() const { return m_count; }
+
+	/**
+	 * @brief Discard all data and make room for @p count lines, set() them and call build() afterwards
+	 */
+	void reset(int count);
+	inline void set(int index, double showTime, double hideTime) {
+		m_minShow[m_size + index] = showTime;
+		m_maxHide[m_size + index] = hideTime;
+	}
+	void build();
+	/**
+	 * @brief Recalculate nodes above lines [@p first, @p last] after they were set()
+	 */
+	void build(int first, int last);
+
+	void update(int index, double showTime, double hideTime);
+
+	/**
+	 * @brief Make room for @p count lines at @p index, set() them and call build(@p index, count() - 1) afterwards
+	 */
+	void insert(int index, int count);
+	void remove(int index, int count);
+
+	/**
+	 * @brief Append indexes of all lines intersecting [@p start, @p end] to @p indexes in ascending order
+	 */
+	void intersecting(double start, double end, QVector<int> *indexes) const;
+
+	/**
+	 * @brief Earliest show time of lines [@p first, @p last], infinity if range is empty
+	 */
+	double minShowTime(int first, int last) const;
+
+private:
+	inline void pull(int node) {
+		m_minShow[node] = qMin(m_minShow[2 * node], m_minShow[2 * node + 1]);
+		m_maxHide[node] = qMax(m_maxHide[2 * node], m_maxHide[2 * node + 1]);
+	}
+
+private:
+	int m_count = 0;
+	int m_size = 0;
+	QVector<double> m_minShow;
+	QVector<double> m_maxHide;
+};
+}
+
+#endif // TIMEINDEX_H
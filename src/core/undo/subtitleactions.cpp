@@ -16,6 +16,9 @@
 
 #include <KLocalizedString>
 
+#include <algorithm>
+#include <utility>
+
 using namespace SubtitleComposer;
 
 // *** SubtitleAction
@@ -26,6 +29,59 @@ SubtitleAction::SubtitleAction(Subtitle *subtitle, UndoStack::DirtyMode dirtyMod
 SubtitleAction::~SubtitleAction()
 {}
 
+void
+SubtitleAction::insertSubtitleLines(int index, QList<SubtitleLine *> *lines)
+{
+	QVector<ObjectRef<SubtitleLine>> &refs = m_subtitle->m_lines;
+	const int n = lines->size();
+
+	refs.reserve(refs.size() + n);
+	refs.insert(index, n, ObjectRef<SubtitleLine>());
+	m_subtitle->m_showTimes.insert(index, n, 0.);
+	m_subtitle->m_hideTimes.insert(index, n, 0.);
+	double *showTimes = m_subtitle->m_showTimes.data() + index;
+	double *hideTimes = m_subtitle->m_hideTimes.data() + index;
+	for(int i = 0; i < n; i++) {
+		SubtitleLine *line = lines->at(i);
+		showTimes[i] = line->m_showTime.toMillis();
+		hideTimes[i] = line->m_hideTime.toMillis();
+		setLineSubtitle(line);
+		refs[index + i] = ObjectRef<SubtitleLine>(line);
+	}
+	lines->clear();
+	if(n)
+		m_subtitle->linesInsertedUpdate(index, index + n - 1);
+}
+
+void
+SubtitleAction::takeSubtitleLines(int firstIndex, int lastIndex, QList<SubtitleLine *> *lines)
+{
+	QVector<ObjectRef<SubtitleLine>> &refs = m_subtitle->m_lines;
+
+	const int n = lastIndex - firstIndex + 1;
+	lines->reserve(lines->size() + n);
+	for(int index = firstIndex; index <= lastIndex; ++index) {
+		SubtitleLine *line = refs.at(index).obj();
+		line->m_showTime = m_subtitle->m_showTimes.at(index);
+		line->m_hideTime = m_subtitle->m_hideTimes.at(index);
+		clearLineSubtitle(line);
+		lines->append(line);
+	}
+	refs.remove(firstIndex, n);
+	m_subtitle->m_showTimes.remove(firstIndex, n);
+	m_subtitle->m_hideTimes.remove(firstIndex, n);
+	m_subtitle->linesRemovedUpdate(firstIndex, lastIndex);
+}
+
+quint64
+SubtitleAction::lineMemoryUsage(const SubtitleLine *line)
+{
+	quint64 size = sizeof(SubtitleLine);
+	size += (line->m_primaryDoc ? line->m_primaryDoc->characterCount() : line->m_primaryText.size()) * sizeof(QChar);
+	size += (line->m_secondaryDoc ? line->m_secondaryDoc->characterCount() : line->m_secondaryText.size()) * sizeof(QChar);
+	return size;
+}
+
 
 // *** SetFramesPerSecondAction
 SetFramesPerSecondAction::SetFramesPerSecondAction(Subtitle *subtitle, double framesPerSecond)
@@ -88,16 +144,7 @@ InsertLinesAction::redo()
 {
 	emit m_subtitle->linesAboutToBeInserted(m_insertIndex, m_lastIndex);
 
-	SubtitleLine *line;
-	int insertOffset = 0;
-	int lineIndex = -1;
-
-	while(!m_lines.isEmpty()) {
-		line = m_lines.takeFirst();
-		lineIndex = m_insertIndex + insertOffset++;
-		setLineSubtitle(line);
-		m_subtitle->m_lines.insert(lineIndex, line);
-	}
+	insertSubtitleLines(m_insertIndex, &m_lines);
 
 	emit m_subtitle->linesInserted(m_insertIndex, m_lastIndex);
 }
@@ -107,15 +154,20 @@ InsertLinesAction::undo()
 {
 	emit m_subtitle->linesAboutToBeRemoved(m_insertIndex, m_lastIndex);
 
-	for(int index = m_insertIndex; index <= m_lastIndex; ++index) {
-		SubtitleLine *line = m_subtitle->takeAt(m_insertIndex);
-		clearLineSubtitle(line);
-		m_lines.append(line);
-	}
+	takeSubtitleLines(m_insertIndex, m_lastIndex, &m_lines);
 
 	emit m_subtitle->linesRemoved(m_insertIndex, m_lastIndex);
 }
 
+quint64
+InsertLinesAction::memoryUsage() const
+{
+	quint64 size = SubtitleAction::memoryUsage();
+	for(const SubtitleLine *line : m_lines)
+		size += lineMemoryUsage(line);
+	return size;
+}
+
 
 // *** RemoveLinesAction
 RemoveLinesAction::RemoveLinesAction(Subtitle *subtitle, int firstIndex, int lastIndex)
@@ -167,11 +219,7 @@ RemoveLinesAction::redo()
 {
 	emit m_subtitle->linesAboutToBeRemoved(m_firstIndex, m_lastIndex);
 
-	for(int index = m_firstIndex; index <= m_lastIndex; ++index) {
-		SubtitleLine *line = m_subtitle->takeAt(m_firstIndex);
-		clearLineSubtitle(line);
-		m_lines.append(line);
-	}
+	takeSubtitleLines(m_firstIndex, m_lastIndex, &m_lines);
 
 	emit m_subtitle->linesRemoved(m_firstIndex, m_lastIndex);
 }
@@ -181,19 +229,20 @@ RemoveLinesAction::undo()
 {
 	emit m_subtitle->linesAboutToBeInserted(m_firstIndex, m_lastIndex);
 
-	int insertOffset = 0;
-	int lineIndex = -1;
-
-	while(!m_lines.isEmpty()) {
-		SubtitleLine *line = m_lines.takeFirst();
-		lineIndex = m_firstIndex + insertOffset++;
-		setLineSubtitle(line);
-		m_subtitle->m_lines.insert(lineIndex, line);
-	}
+	insertSubtitleLines(m_firstIndex, &m_lines);
 
 	emit m_subtitle->linesInserted(m_firstIndex, m_lastIndex);
 }
 
+quint64
+RemoveLinesAction::memoryUsage() const
+{
+	quint64 size = SubtitleAction::memoryUsage();
+	for(const SubtitleLine *line : m_lines)
+		size += lineMemoryUsage(line);
+	return size;
+}
+
 
 // *** MoveLineAction
 MoveLineAction::MoveLineAction(Subtitle *subtitle, int fromIndex, int toIndex) :
@@ -254,32 +303,92 @@ MoveLineAction::mergeWith(const QUndoCommand *command)
 void
 MoveLineAction::redo()
 {
+	QList<SubtitleLine *> lines;
+
 	emit m_subtitle->linesAboutToBeRemoved(m_fromIndex, m_fromIndex);
-	SubtitleLine *line = m_subtitle->takeAt(m_fromIndex);
-	clearLineSubtitle(line);
+	takeSubtitleLines(m_fromIndex, m_fromIndex, &lines);
 	emit m_subtitle->linesRemoved(m_fromIndex, m_fromIndex);
 
 	emit m_subtitle->linesAboutToBeInserted(m_toIndex, m_toIndex);
-	setLineSubtitle(line);
-	m_subtitle->m_lines.insert(m_toIndex, line);
+	insertSubtitleLines(m_toIndex, &lines);
 	emit m_subtitle->linesInserted(m_toIndex, m_toIndex);
 }
 
 void
 MoveLineAction::undo()
 {
+	QList<SubtitleLine *> lines;
+
 	emit m_subtitle->linesAboutToBeRemoved(m_toIndex, m_toIndex);
-	SubtitleLine *line = m_subtitle->takeAt(m_toIndex);
-	clearLineSubtitle(line);
+	takeSubtitleLines(m_toIndex, m_toIndex, &lines);
 	emit m_subtitle->linesRemoved(m_toIndex, m_toIndex);
 
 	emit m_subtitle->linesAboutToBeInserted(m_fromIndex, m_fromIndex);
-	setLineSubtitle(line);
-	m_subtitle->m_lines.insert(m_fromIndex, line);
+	insertSubtitleLines(m_fromIndex, &lines);
 	emit m_subtitle->linesInserted(m_fromIndex, m_fromIndex);
 }
 
 
+// *** SortLinesAction
+SortLinesAction::SortLinesAction(Subtitle *subtitle, int firstIndex, const QVector<int> &order)
+	: SubtitleAction(subtitle, UndoStack::Both, i18n("Sort")),
+	  m_firstIndex(firstIndex),
+	  m_order(order)
+{
+	Q_ASSERT(m_firstIndex >= 0);
+	Q_ASSERT(m_firstIndex + m_order.size() <= m_subtitle->linesCount());
+}
+
+SortLinesAction::~SortLinesAction()
+{}
+
+void
+SortLinesAction::reorder(bool inverse)
+{
+	QVector<ObjectRef<SubtitleLine>> &refs = m_subtitle->m_lines;
+	const int n = m_order.size();
+
+	emit m_subtitle->linesAboutToBeReordered(m_firstIndex, m_firstIndex + n - 1);
+
+	QVector<SubtitleLine *> lines(n);
+	for(int i = 0; i < n; i++)
+		lines[i] = refs.at(m_firstIndex + i).obj();
+	const QVector<double> oldShowTimes = m_subtitle->m_showTimes.mid(m_firstIndex, n);
+	const QVector<double> oldHideTimes = m_subtitle->m_hideTimes.mid(m_firstIndex, n);
+	double *showTimes = m_subtitle->m_showTimes.data() + m_firstIndex;
+	double *hideTimes = m_subtitle->m_hideTimes.data() + m_firstIndex;
+
+	for(int i = 0; i < n; i++) {
+		const int from = inverse ? i : m_order.at(i);
+		const int to = inverse ? m_order.at(i) : i;
+		refs[m_firstIndex + to] = ObjectRef<SubtitleLine>(lines.at(from));
+		showTimes[to] = oldShowTimes.at(from);
+		hideTimes[to] = oldHideTimes.at(from);
+	}
+	m_subtitle->linesReorderedUpdate(m_firstIndex, m_firstIndex + n - 1);
+
+	emit m_subtitle->linesReordered(m_firstIndex, m_firstIndex + n - 1);
+}
+
+void
+SortLinesAction::redo()
+{
+	reorder(false);
+}
+
+void
+SortLinesAction::undo()
+{
+	reorder(true);
+}
+
+quint64
+SortLinesAction::memoryUsage() const
+{
+	return SubtitleAction::memoryUsage() + m_order.size() * sizeof(int);
+}
+
+
 // *** SwapLinesTextsAction
 SwapLinesTextsAction::SwapLinesTextsAction(Subtitle *subtitle, const RangeList &ranges) :
 	SubtitleAction(subtitle, UndoStack::Both, i18n("Swap Texts")),
@@ -294,15 +403,85 @@ SwapLinesTextsAction::redo()
 {
 	for(SubtitleIterator it(*m_subtitle, m_ranges); it.current(); ++it) {
 		SubtitleLine *line = it.current();
-		RichDocument *tmp = line->m_primaryDoc;
-		line->m_primaryDoc = line->m_secondaryDoc;
-		line->m_secondaryDoc = tmp;
-		emit line->primaryTextChanged();
-		emit line->secondaryTextChanged();
+		std::swap(line->m_primaryDoc, line->m_secondaryDoc);
+		std::swap(line->m_primaryText, line->m_secondaryText);
+		std::swap(line->m_primaryStats, line->m_secondaryStats);
+		line->notifyPrimaryTextChanged();
+		line->notifySecondaryTextChanged();
 	}
 }
 
 
+// *** SetLinesErrorsAction
+SetLinesErrorsAction::SetLinesErrorsAction(Subtitle *subtitle, const QVector<int> &indexes, const QVector<int> &errorFlags)
+	: SubtitleAction(subtitle, UndoStack::None, i18n("Check Lines Errors")),
+	  m_indexes(indexes),
+	  m_errorFlags(errorFlags)
+{
+	Q_ASSERT(m_indexes.size() == m_errorFlags.size());
+}
+
+SetLinesErrorsAction::~SetLinesErrorsAction()
+{}
+
+void
+SetLinesErrorsAction::redo()
+{
+	if(m_indexes.isEmpty())
+		return;
+	for(int i = 0, n = m_indexes.size(); i < n; i++)
+		std::swap(m_subtitle->at(m_indexes.at(i))->m_errorFlags, m_errorFlags[i]);
+	// only lines with changed flags are stored, notify each consecutive run of them
+	for(int i = 0, n = m_indexes.size(); i < n;) {
+		const int first = m_indexes.at(i);
+		int last = first;
+		while(++i < n && m_indexes.at(i) == last + 1)
+			last++;
+		m_subtitle->invalidateSnapshot(first, last);
+		emit m_subtitle->linesErrorFlagsChanged(first, last);
+	}
+}
+
+quint64
+SetLinesErrorsAction::memoryUsage() const
+{
+	return SubtitleAction::memoryUsage() + (m_indexes.size() + m_errorFlags.size()) * sizeof(int);
+}
+
+
+// *** SetLinesTimesAction
+SetLinesTimesAction::SetLinesTimesAction(Subtitle *subtitle, int firstIndex, const QVector<double> &showTimes, const QVector<double> &hideTimes, const QString &description)
+	: SubtitleAction(subtitle, UndoStack::Both, description),
+	  m_firstIndex(firstIndex),
+	  m_showTimes(showTimes),
+	  m_hideTimes(hideTimes)
+{
+	Q_ASSERT(m_showTimes.size() == m_hideTimes.size());
+	Q_ASSERT(m_firstIndex >= 0 && m_firstIndex + m_showTimes.size() <= m_subtitle->linesCount());
+}
+
+SetLinesTimesAction::~SetLinesTimesAction()
+{}
+
+void
+SetLinesTimesAction::redo()
+{
+	const int n = m_showTimes.size();
+	if(!n)
+		return;
+	std::swap_ranges(m_showTimes.begin(), m_showTimes.end(), m_subtitle->m_showTimes.begin() + m_firstIndex);
+	std::swap_ranges(m_hideTimes.begin(), m_hideTimes.end(), m_subtitle->m_hideTimes.begin() + m_firstIndex);
+	m_subtitle->updateTimeIndex(m_firstIndex, m_firstIndex + n - 1);
+	emit m_subtitle->linesTimesChanged(m_firstIndex, m_firstIndex + n - 1);
+}
+
+quint64
+SetLinesTimesAction::memoryUsage() const
+{
+	return SubtitleAction::memoryUsage() + (m_showTimes.size() + m_hideTimes.size()) * sizeof(double);
+}
+
+
 // *** ChangeStylesheetAction
 EditStylesheetAction::EditStylesheetAction(Subtitle *subtitle, QTextEdit *textEdit)
 	: SubtitleAction(subtitle, UndoStack::Primary, i18n("Change stylesheet")),
@@ -16,6 +16,7 @@
 
 #include <QString>
 #include <QList>
+#include <QVector>
 
 QT_FORWARD_DECLARE_CLASS(QTextEdit)
 
@@ -29,17 +30,36 @@ public:
 
 	inline void setLineSubtitle(SubtitleLine *line)
 	{
-		line->m_primaryDoc->setStylesheet(m_subtitle->stylesheet());
-		line->m_secondaryDoc->setStylesheet(m_subtitle->stylesheet());
+		if(line->m_primaryDoc)
+			line->m_primaryDoc->setStylesheet(m_subtitle->stylesheet());
+		if(line->m_secondaryDoc)
+			line->m_secondaryDoc->setStylesheet(m_subtitle->stylesheet());
 		line->m_subtitle = m_subtitle;
+		if(line->m_primaryDoc || line->m_secondaryDoc)
+			m_subtitle->touchLineDocs(line);
 	}
 
 	inline void clearLineSubtitle(SubtitleLine *line)
 	{
+		line->unlinkDoc();
 		line->m_subtitle = nullptr;
-		line->m_primaryDoc->setStylesheet(nullptr);
-		line->m_secondaryDoc->setStylesheet(nullptr);
+		if(line->m_primaryDoc)
+			line->m_primaryDoc->setStylesheet(nullptr);
+		if(line->m_secondaryDoc)
+			line->m_secondaryDoc->setStylesheet(nullptr);
 	}
+
+	/**
+	 * @brief Move all @p lines into subtitle at @p index with a single reallocation
+	 */
+	void insertSubtitleLines(int index, QList<SubtitleLine *> *lines);
+	/**
+	 * @brief Move lines between @p firstIndex and @p lastIndex out of subtitle and append them to @p lines
+	 */
+	void takeSubtitleLines(int firstIndex, int lastIndex, QList<SubtitleLine *> *lines);
+
+protected:
+	static quint64 lineMemoryUsage(const SubtitleLine *line);
 };
 
 class SetFramesPerSecondAction : public SubtitleAction
@@ -65,6 +85,7 @@ public:
 
 	inline int id() const override { return UndoAction::InsertLines; }
 	bool mergeWith(const QUndoCommand *command) override;
+	quint64 memoryUsage() const override;
 
 protected:
 	void redo() override;
@@ -84,6 +105,7 @@ public:
 
 	inline int id() const override { return UndoAction::RemoveLines; }
 	bool mergeWith(const QUndoCommand *command) override;
+	quint64 memoryUsage() const override;
 
 protected:
 	void redo() override;
@@ -113,6 +135,26 @@ private:
 	int m_toIndex;
 };
 
+class SortLinesAction : public SubtitleAction
+{
+public:
+	SortLinesAction(Subtitle *subtitle, int firstIndex, const QVector<int> &order);
+	virtual ~SortLinesAction();
+
+	inline int id() const override { return UndoAction::SortLines; }
+	quint64 memoryUsage() const override;
+
+protected:
+	void redo() override;
+	void undo() override;
+
+private:
+	void reorder(bool inverse);
+
+	int m_firstIndex;
+	QVector<int> m_order; // m_order[i] is offset (from m_firstIndex) of the line that is moved to i
+};
+
 class SwapLinesTextsAction : public SubtitleAction
 {
 public:
@@ -128,6 +170,42 @@ private:
 	const RangeList m_ranges;
 };
 
+class SetLinesErrorsAction : public SubtitleAction
+{
+public:
+	SetLinesErrorsAction(Subtitle *subtitle, const QVector<int> &indexes, const QVector<int> &errorFlags);
+	virtual ~SetLinesErrorsAction();
+
+	inline int id() const override { return UndoAction::SetLinesErrors; }
+	quint64 memoryUsage() const override;
+
+protected:
+	void redo() override;
+
+private:
+	const QVector<int> m_indexes; // ascending line indexes
+	QVector<int> m_errorFlags;
+};
+
+class SetLinesTimesAction : public SubtitleAction
+{
+public:
+	SetLinesTimesAction(Subtitle *subtitle, int firstIndex, const QVector<double> &showTimes, const QVector<double> &hideTimes, const QString &description);
+	virtual ~SetLinesTimesAction();
+
+	inline int id() const override { return UndoAction::SetLinesTimes; }
+	quint64 memoryUsage() const override;
+
+protected:
+	void redo() override;
+
+private:
+	const int m_firstIndex;
+	// times swapped in by the next redo/undo
+	QVector<double> m_showTimes;
+	QVector<double> m_hideTimes;
+};
+
 class EditStylesheetAction : public SubtitleAction
 {
 public:
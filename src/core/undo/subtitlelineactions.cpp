@@ -28,16 +28,22 @@ SetLinePrimaryTextAction::SetLinePrimaryTextAction(SubtitleLine *line, RichDocum
 	: SubtitleLineAction(line, UndoStack::Primary, i18n("Set Line Text")),
 	  m_primaryDoc(primaryDoc),
 	  m_primaryDocState(primaryDoc->availableUndoSteps())
-{}
+{
+	primaryDoc->holdHistory();
+}
 
 SetLinePrimaryTextAction::~SetLinePrimaryTextAction()
-{}
+{
+	// history older than the remaining actions can't be stepped through anymore
+	if(m_primaryDoc && m_primaryDoc->releaseHistory() && m_discarded)
+		m_primaryDoc->clearUndoRedoStacks();
+}
 
 bool
 SetLinePrimaryTextAction::mergeWith(const QUndoCommand *command)
 {
 	const SetLinePrimaryTextAction *cur = static_cast<const SetLinePrimaryTextAction *>(command);
-	return cur->m_primaryDoc == m_primaryDoc && cur->m_primaryDocState == m_primaryDocState;
+	return cur->m_primaryDoc.data() == m_primaryDoc.data() && cur->m_primaryDocState == m_primaryDocState;
 }
 
 void
@@ -47,7 +53,7 @@ SetLinePrimaryTextAction::undo()
 	while(m_primaryDoc->isUndoAvailable() && m_primaryDoc->availableUndoSteps() >= m_primaryDocState)
 		m_primaryDoc->undo();
 	m_line->ignoreDocChanges(prev);
-	emit m_line->primaryTextChanged();
+	m_line->notifyPrimaryTextChanged();
 }
 
 void
@@ -57,7 +63,20 @@ SetLinePrimaryTextAction::redo()
 	while(m_primaryDoc->isRedoAvailable() && m_primaryDoc->availableUndoSteps() < m_primaryDocState)
 		m_primaryDoc->redo();
 	m_line->ignoreDocChanges(prev);
-	emit m_line->primaryTextChanged();
+	m_line->notifyPrimaryTextChanged();
+}
+
+quint64
+SetLinePrimaryTextAction::memoryUsage() const
+{
+	// edits are kept in document's own undo history, a step holds at most the whole text
+	return SubtitleLineAction::memoryUsage() + (m_primaryDoc ? m_primaryDoc->characterCount() * sizeof(QChar) : 0);
+}
+
+void
+SetLinePrimaryTextAction::discard()
+{
+	m_discarded = true;
 }
 
 
@@ -66,16 +85,22 @@ SetLineSecondaryTextAction::SetLineSecondaryTextAction(SubtitleLine *line, RichD
 	: SubtitleLineAction(line, UndoStack::Secondary, i18n("Set Line Secondary Text")),
 	  m_secondaryDoc(secondaryDoc),
 	  m_secondaryDocState(secondaryDoc->availableUndoSteps())
-{}
+{
+	secondaryDoc->holdHistory();
+}
 
 SetLineSecondaryTextAction::~SetLineSecondaryTextAction()
-{}
+{
+	// history older than the remaining actions can't be stepped through anymore
+	if(m_secondaryDoc && m_secondaryDoc->releaseHistory() && m_discarded)
+		m_secondaryDoc->clearUndoRedoStacks();
+}
 
 bool
 SetLineSecondaryTextAction::mergeWith(const QUndoCommand *command)
 {
 	const SetLineSecondaryTextAction *cur = static_cast<const SetLineSecondaryTextAction *>(command);
-	return cur->m_secondaryDoc == m_secondaryDoc && cur->m_secondaryDocState == m_secondaryDocState;
+	return cur->m_secondaryDoc.data() == m_secondaryDoc.data() && cur->m_secondaryDocState == m_secondaryDocState;
 }
 
 void
@@ -85,7 +110,7 @@ SetLineSecondaryTextAction::undo()
 	while(m_secondaryDoc->isUndoAvailable() && m_secondaryDoc->availableUndoSteps() >= m_secondaryDocState)
 		m_secondaryDoc->undo();
 	m_line->ignoreDocChanges(prev);
-	emit m_line->secondaryTextChanged();
+	m_line->notifySecondaryTextChanged();
 }
 
 void
@@ -95,7 +120,20 @@ SetLineSecondaryTextAction::redo()
 	while(m_secondaryDoc->isRedoAvailable() && m_secondaryDoc->availableUndoSteps() < m_secondaryDocState)
 		m_secondaryDoc->redo();
 	m_line->ignoreDocChanges(prev);
-	emit m_line->secondaryTextChanged();
+	m_line->notifySecondaryTextChanged();
+}
+
+quint64
+SetLineSecondaryTextAction::memoryUsage() const
+{
+	// edits are kept in document's own undo history, a step holds at most the whole text
+	return SubtitleLineAction::memoryUsage() + (m_secondaryDoc ? m_secondaryDoc->characterCount() * sizeof(QChar) : 0);
+}
+
+void
+SetLineSecondaryTextAction::discard()
+{
+	m_discarded = true;
 }
 
 
@@ -119,11 +157,11 @@ SetLineShowTimeAction::mergeWith(const QUndoCommand *command)
 void
 SetLineShowTimeAction::redo()
 {
-	Time tmp = m_line->m_showTime;
-	m_line->m_showTime = m_showTime;
+	Time tmp = m_line->showTime();
+	m_line->storeShowTime(m_showTime);
 	m_showTime = tmp;
 
-	emit m_line->showTimeChanged(m_line->m_showTime);
+	m_line->notifyShowTimeChanged();
 }
 
 
@@ -146,11 +184,11 @@ SetLineHideTimeAction::mergeWith(const QUndoCommand *command)
 void
 SetLineHideTimeAction::redo()
 {
-	Time tmp = m_line->m_hideTime;
-	m_line->m_hideTime = m_hideTime;
+	Time tmp = m_line->hideTime();
+	m_line->storeHideTime(m_hideTime);
 	m_hideTime = tmp;
 
-	emit m_line->hideTimeChanged(m_line->m_hideTime);
+	m_line->notifyHideTimeChanged();
 }
 
 
@@ -174,20 +212,20 @@ SetLineTimesAction::mergeWith(const QUndoCommand *command)
 void
 SetLineTimesAction::redo()
 {
-	if(m_line->m_showTime != m_showTime) {
-		Time tmp = m_line->m_showTime;
-		m_line->m_showTime = m_showTime;
+	if(m_line->showTime() != m_showTime) {
+		Time tmp = m_line->showTime();
+		m_line->storeShowTime(m_showTime);
 		m_showTime = tmp;
 
-		emit m_line->showTimeChanged(m_line->m_showTime);
+		m_line->notifyShowTimeChanged();
 	}
 
-	if(m_line->m_hideTime != m_hideTime) {
-		Time tmp = m_line->m_hideTime;
-		m_line->m_hideTime = m_hideTime;
+	if(m_line->hideTime() != m_hideTime) {
+		Time tmp = m_line->hideTime();
+		m_line->storeHideTime(m_hideTime);
 		m_hideTime = tmp;
 
-		emit m_line->hideTimeChanged(m_line->m_hideTime);
+		m_line->notifyHideTimeChanged();
 	}
 }
 
@@ -214,5 +252,5 @@ SetLineErrorsAction::redo()
 	m_line->m_errorFlags = m_errorFlags;
 	m_errorFlags = tmp;
 
-	emit m_line->errorFlagsChanged(m_line->m_errorFlags);
+	m_line->notifyErrorFlagsChanged();
 }
@@ -11,6 +11,7 @@
 #include "core/undo/undoaction.h"
 #include "core/time.h"
 #include "core/richstring.h"
+#include "core/richtext/richdocumentptr.h"
 #include "core/subtitleline.h"
 
 #include <QString>
@@ -43,14 +44,17 @@ public:
 
 	inline int id() const override { return UndoAction::SetLinePrimaryText; }
 	bool mergeWith(const QUndoCommand *command) override;
+	quint64 memoryUsage() const override;
+	void discard() override;
 
 protected:
 	void undo() override;
 	void redo() override;
 
 private:
-	RichDocument *m_primaryDoc;
+	RichDocumentPtr m_primaryDoc;
 	int m_primaryDocState = -1;
+	bool m_discarded = false;
 };
 
 class SetLineSecondaryTextAction : public SubtitleLineAction
@@ -63,14 +67,17 @@ public:
 
 	inline int id() const override { return UndoAction::SetLineSecondaryText; }
 	bool mergeWith(const QUndoCommand *command) override;
+	quint64 memoryUsage() const override;
+	void discard() override;
 
 protected:
 	void undo() override;
 	void redo() override;
 
 private:
-	RichDocument *m_secondaryDoc;
+	RichDocumentPtr m_secondaryDoc;
 	int m_secondaryDocState = -1;
+	bool m_discarded = false;
 };
 
 class SetLineShowTimeAction : public SubtitleLineAction
@@ -25,3 +25,14 @@ UndoAction::undo()
 {
 	redo();
 }
+
+quint64
+UndoAction::memoryUsage() const
+{
+	return sizeof(*this) + text().size() * sizeof(QChar);
+}
+
+void
+UndoAction::discard()
+{
+}
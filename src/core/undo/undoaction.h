@@ -27,8 +27,11 @@ public:
 		InsertLines,
 		RemoveLines,
 		MoveLine,
+		SortLines,
 		SwapLinesTexts,
 		ChangeStylesheet,
+		SetLinesErrors,
+		SetLinesTimes,
 
 		// subtitle line actions
 		SetLinePrimaryText,
@@ -47,6 +50,16 @@ public:
 	void redo() override = 0;
 	void undo() override;
 
+	/**
+	 * @brief Approximate number of bytes held by this action, used to keep undo history within its memory limit
+	 */
+	virtual quint64 memoryUsage() const;
+
+	/**
+	 * @brief Action is being dropped from undo history and will never be undone or redone again
+	 */
+	virtual void discard();
+
 protected:
 	const UndoStack::DirtyMode m_dirtyMode;
 	QExplicitlySharedDataPointer<Subtitle> m_subtitle;
@@ -10,39 +10,157 @@
 #include "application.h"
 #include "actions/useraction.h"
 #include "actions/useractionnames.h"
+#include "core/subtitle.h"
 #include "core/undo/undoaction.h"
 #include "gui/treeview/lineswidget.h"
 #include "gui/treeview/linesmodel.h"
 
+#include "scconfig.h"
+
+#include <KLocalizedString>
+
+#include <QAction>
+
 using namespace SubtitleComposer;
 
+namespace SubtitleComposer {
+class UndoMacro : public UndoAction
+{
+public:
+	UndoMacro(const QString &text)
+		: UndoAction(UndoStack::None, nullptr, text)
+	{}
+
+	~UndoMacro()
+	{
+		qDeleteAll(m_children);
+	}
+
+	void redo() override
+	{
+		for(UndoAction *cmd : qAsConst(m_children))
+			cmd->redo();
+	}
+
+	void undo() override
+	{
+		for(auto it = m_children.crbegin(); it != m_children.crend(); ++it)
+			(*it)->undo();
+	}
+
+	quint64 memoryUsage() const override
+	{
+		quint64 size = UndoAction::memoryUsage();
+		for(const UndoAction *cmd : m_children)
+			size += cmd->memoryUsage();
+		return size;
+	}
+
+	void discard() override
+	{
+		for(UndoAction *cmd : qAsConst(m_children))
+			cmd->discard();
+	}
+
+	QVector<UndoAction *> m_children;
+};
+}
+
 UndoStack::UndoStack(QObject *parent)
-	: QUndoStack(parent),
+	: QObject(parent),
 	  m_level(0),
-	  m_undoAction(QUndoStack::createUndoAction(UserActionManager::instance())),
-	  m_redoAction(QUndoStack::createRedoAction(UserActionManager::instance()))
+	  m_undoAction(new QAction(i18n("Undo"), UserActionManager::instance())),
+	  m_redoAction(new QAction(i18n("Redo"), UserActionManager::instance())),
+	  m_index(0),
+	  m_memoryUsage(0),
+	  m_memoryLimit(quint64(SCConfig::undoMemoryLimit()) << 20)
 {
 	m_selectionStack.push(Selection(app()->linesWidget()->selectionModel()));
 
+	m_undoAction->setEnabled(false);
+	m_redoAction->setEnabled(false);
+	connect(m_undoAction, &QAction::triggered, this, &UndoStack::undo);
+	connect(m_redoAction, &QAction::triggered, this, &UndoStack::redo);
+	connect(this, &UndoStack::canUndoChanged, m_undoAction, &QAction::setEnabled);
+	connect(this, &UndoStack::canRedoChanged, m_redoAction, &QAction::setEnabled);
+	connect(this, &UndoStack::undoTextChanged, m_undoAction, [this](const QString &text){
+		m_undoAction->setText(text.isEmpty() ? i18n("Undo") : i18n("Undo %1", text));
+	});
+	connect(this, &UndoStack::redoTextChanged, m_redoAction, [this](const QString &text){
+		m_redoAction->setText(text.isEmpty() ? i18n("Redo") : i18n("Redo %1", text));
+	});
 	connect(this, &UndoStack::undoTextChanged, undoAction(), &QAction::setToolTip);
 	connect(this, &UndoStack::redoTextChanged, redoAction(), &QAction::setToolTip);
 	connect(this, &UndoStack::indexChanged, parent, [](){ if(Subtitle *s = appSubtitle()) s->updateState(); });
-	connect(this, &UndoStack::cleanChanged, parent, [](){ if(Subtitle *s = appSubtitle()) s->updateState(); });
+	connect(SCConfig::self(), &KCoreConfigSkeleton::configChanged, this, [this](){
+		setMemoryLimit(quint64(SCConfig::undoMemoryLimit()) << 20);
+	});
 }
 
 UndoStack::~UndoStack()
 {
-
+	if(!m_macros.isEmpty())
+		delete m_macros.first();
+	qDeleteAll(m_commands);
 }
 
 void
 UndoStack::clear()
 {
+	if(!m_macros.isEmpty()) {
+		delete m_macros.first();
+		m_macros.clear();
+	}
+	qDeleteAll(m_commands);
+	m_commands.clear();
+	m_commandSizes.clear();
+	m_index = 0;
+	m_memoryUsage = 0;
+	m_level = 0;
+
+	m_dirtyStack.clear();
 	m_selectionStack.clear();
 	m_selectionStack.push(Selection(app()->linesWidget()->selectionModel()));
-	QUndoStack::clear();
+
+	emitStateChanged();
+	emit memoryUsageChanged(m_memoryUsage);
+}
+
+QString
+UndoStack::undoText() const
+{
+	return canUndo() ? m_commands.at(m_index - 1)->actionText() : QString();
+}
+
+QString
+UndoStack::redoText() const
+{
+	return canRedo() ? m_commands.at(m_index)->actionText() : QString();
 }
 
+QString
+UndoStack::text(int idx) const
+{
+	return idx >= 0 && idx < m_commands.size() ? m_commands.at(idx)->text() : QString();
+}
+
+const QUndoCommand *
+UndoStack::command(int index) const
+{
+	return index >= 0 && index < m_commands.size() ? m_commands.at(index) : nullptr;
+}
+
+void
+UndoStack::setMemoryLimit(quint64 bytes)
+{
+	if(m_memoryLimit == bytes)
+		return;
+	m_memoryLimit = bytes;
+	if(m_macros.isEmpty() && m_level == 0) {
+		compact();
+		emit memoryUsageChanged(m_memoryUsage);
+	}
+}
 
 inline static void
 restoreSelection(int current, const QList<std::pair<int, int>> &selection)
@@ -110,38 +228,187 @@ UndoStack::levelDecrease(int idx)
 	}
 }
 
+void
+UndoStack::dropRedoCommands()
+{
+	if(m_commands.size() == m_index)
+		return;
+	while(m_commands.size() > m_index) {
+		m_commands.last()->discard();
+		delete m_commands.takeLast();
+		m_memoryUsage -= m_commandSizes.takeLast();
+	}
+	if(m_dirtyStack.size() > m_index)
+		m_dirtyStack.resize(m_index);
+	if(m_selectionStack.size() > m_index + 1)
+		m_selectionStack.resize(m_index + 1);
+	if(Subtitle *s = appSubtitle())
+		s->undoHistoryTrimmed(0, m_index);
+}
+
+void
+UndoStack::commandsChanged()
+{
+	// last command might have grown by merging
+	const int last = m_index - 1;
+	m_memoryUsage -= m_commandSizes.at(last);
+	m_commandSizes[last] = m_commands.at(last)->memoryUsage();
+	m_memoryUsage += m_commandSizes.at(last);
+
+	compact();
+	emitStateChanged();
+	emit memoryUsageChanged(m_memoryUsage);
+}
+
+void
+UndoStack::compact()
+{
+	// drop oldest commands, the last executed one is always kept so it can be undone
+	int dropped = 0;
+	quint64 usage = m_memoryUsage;
+	while(usage > m_memoryLimit && dropped < m_index - 1)
+		usage -= m_commandSizes.at(dropped++);
+	if(!dropped)
+		return;
+
+	for(int i = 0; i < dropped; i++) {
+		m_commands.at(i)->discard();
+		delete m_commands.at(i);
+	}
+	m_commands.remove(0, dropped);
+	m_commandSizes.remove(0, dropped);
+	m_dirtyStack.remove(0, qMin(dropped, m_dirtyStack.size()));
+	m_selectionStack.remove(1, qMin(dropped, m_selectionStack.size() - 1));
+	m_index -= dropped;
+	m_memoryUsage = usage;
+
+	if(Subtitle *s = appSubtitle())
+		s->undoHistoryTrimmed(dropped, m_commands.size());
+}
+
+bool
+UndoStack::isDirty(const QVector<DirtyMode> &dirtyModes, int cleanIndex, int index, DirtyMode mode)
+{
+	if(cleanIndex < 0)
+		return true;
+	const int d = cleanIndex > index ? -1 : 1;
+	for(int i = cleanIndex; ; i += d) {
+		const DirtyMode dirtyMode = i > 0 ? dirtyModes.at(i - 1) : None;
+		if(i != cleanIndex && (dirtyMode & mode))
+			return true;
+		if(i == index)
+			return false;
+	}
+}
+
+int
+UndoStack::trimmedIndex(int index, int droppedFront, int count)
+{
+	if(index < 0)
+		return -1;
+	index -= droppedFront;
+	return index < 0 || index > count ? -1 : index;
+}
+
+void
+UndoStack::emitStateChanged()
+{
+	emit indexChanged(m_index);
+	emit canUndoChanged(canUndo());
+	emit undoTextChanged(undoText());
+	emit canRedoChanged(canRedo());
+	emit redoTextChanged(redoText());
+}
+
 void
 UndoStack::push(UndoAction *cmd)
 {
+	if(m_macros.isEmpty())
+		dropRedoCommands();
+
 	const int idx = index();
 	const int idx1 = idx + 1;
 	levelIncrease(idx1);
-	m_dirtyStack[idx] = static_cast<DirtyMode>(m_dirtyStack.at(idx) | cmd->m_dirtyMode);
-	QUndoStack::push(cmd); // NOTE: cmd can/will be deleted after push()
+
+	const UndoStack::DirtyMode dirtyMode = cmd->m_dirtyMode;
+	cmd->redo();
+
+	UndoAction *prev;
+	if(m_macros.isEmpty())
+		prev = m_index > 0 ? m_commands.at(m_index - 1) : nullptr;
+	else
+		prev = m_macros.last()->m_children.isEmpty() ? nullptr : m_macros.last()->m_children.last();
+	const bool merged = prev && prev->id() != -1 && prev->id() == cmd->id() && prev->mergeWith(cmd);
+	if(merged) {
+		delete cmd;
+	} else if(m_macros.isEmpty()) {
+		m_commands.append(cmd);
+		m_commandSizes.append(0);
+		m_index++;
+	} else {
+		m_macros.last()->m_children.append(cmd);
+	}
+
+	// merged top level command stays in its previous slot
+	const int slot = merged && m_macros.isEmpty() ? idx - 1 : idx;
+	m_dirtyStack[slot] = static_cast<DirtyMode>(m_dirtyStack.at(slot) | dirtyMode);
+
 	levelDecrease(idx1);
+
+	if(m_macros.isEmpty())
+		commandsChanged();
 }
 
 void
 UndoStack::beginMacro(const QString &text)
 {
-	QUndoStack::beginMacro(text);
+	UndoMacro *macro = new UndoMacro(text);
+	if(m_macros.isEmpty()) {
+		dropRedoCommands();
+		m_macros.append(macro);
+		emit canUndoChanged(false);
+		emit undoTextChanged(QString());
+		emit canRedoChanged(false);
+		emit redoTextChanged(QString());
+	} else {
+		m_macros.last()->m_children.append(macro);
+		m_macros.append(macro);
+	}
 	levelIncrease(index() + 1);
 }
 
 void
 UndoStack::endMacro(DirtyMode dirtyOverride)
 {
+	Q_ASSERT(!m_macros.isEmpty());
 	const int idx = index();
 	levelDecrease(idx + 1);
 	if(dirtyOverride != Invalid)
 		m_dirtyStack[idx] = dirtyOverride;
-	QUndoStack::endMacro();
+
+	UndoMacro *macro = m_macros.takeLast();
+	if(m_macros.isEmpty()) {
+		m_commands.append(macro);
+		m_commandSizes.append(0);
+		m_index++;
+		commandsChanged();
+	}
 }
 
 void
 UndoStack::undo()
 {
-	QUndoStack::undo();
+	if(!canUndo())
+		return;
+
+	Subtitle *subtitle = appSubtitle();
+	if(subtitle)
+		subtitle->beginChangeBatch();
+	m_commands.at(m_index - 1)->undo();
+	if(subtitle)
+		subtitle->endChangeBatch();
+	m_index--;
+	emitStateChanged();
 
 	const Selection &sel = m_selectionStack.at(index() + 1);
 	restoreSelection(sel.preCurrentRow, sel.preSelection);
@@ -150,7 +417,17 @@ UndoStack::undo()
 void
 UndoStack::redo()
 {
-	QUndoStack::redo();
+	if(!canRedo())
+		return;
+
+	Subtitle *subtitle = appSubtitle();
+	if(subtitle)
+		subtitle->beginChangeBatch();
+	m_commands.at(m_index)->redo();
+	if(subtitle)
+		subtitle->endChangeBatch();
+	m_index++;
+	emitStateChanged();
 
 	const Selection &sel = m_selectionStack.at(index());
 	restoreSelection(sel.postCurrentRow, sel.postSelection);
@@ -7,16 +7,23 @@
 #ifndef UNDOSTACK_H
 #define UNDOSTACK_H
 
-#include <QUndoStack>
-
+#include <QObject>
 #include <QStack>
+#include <QVector>
 
+QT_FORWARD_DECLARE_CLASS(QAction)
 QT_FORWARD_DECLARE_CLASS(QItemSelectionModel)
+QT_FORWARD_DECLARE_CLASS(QUndoCommand)
 
 namespace SubtitleComposer {
 class UndoAction;
+class UndoMacro;
 
-class UndoStack : private QUndoStack
+/**
+ * @brief Undo history with the QUndoStack interface that keeps its memory use under SCConfig::undoMemoryLimit()
+ * Oldest commands are dropped once the limit is exceeded.
+ */
+class UndoStack : public QObject
 {
 	Q_OBJECT
 
@@ -47,43 +54,70 @@ public:
 	void beginMacro(const QString &text);
 	void endMacro(DirtyMode dirtyOverride = Invalid);
 
-	using QUndoStack::canUndo;
-	using QUndoStack::canRedo;
-	using QUndoStack::undoText;
-	using QUndoStack::redoText;
+	inline bool canUndo() const { return m_macros.isEmpty() && m_index > 0; }
+	inline bool canRedo() const { return m_macros.isEmpty() && m_index < m_commands.size(); }
+	QString undoText() const;
+	QString redoText() const;
 
-	using QUndoStack::count;
-	using QUndoStack::index;
-	using QUndoStack::text;
+	inline int count() const { return m_commands.size(); }
+	inline int index() const { return m_index; }
+	QString text(int idx) const;
+	const QUndoCommand * command(int index) const;
 
 	inline QAction *undoAction() const { return m_undoAction; }
 	inline QAction *redoAction() const { return m_redoAction; }
 
-	// Subtitle handles/implements these
-//	using QUndoStack::isActive;
-//	using QUndoStack::isClean;
-//	using QUndoStack::cleanIndex;
-
-	using QUndoStack::beginMacro;
-	using QUndoStack::endMacro;
-
 	inline DirtyMode dirtyMode(int index) const { return m_dirtyStack.at(index); }
-	using QUndoStack::command;
+
+	/**
+	 * @brief Whether commands between clean state @p cleanIndex and @p index change @p mode data
+	 * Clean states that are no longer in history (negative index) are always dirty.
+	 */
+	inline bool isDirty(int cleanIndex, int index, DirtyMode mode) const { return isDirty(m_dirtyStack, cleanIndex, index, mode); }
+	static bool isDirty(const QVector<DirtyMode> &dirtyModes, int cleanIndex, int index, DirtyMode mode);
+	/**
+	 * @brief State @p index after history lost @p droppedFront oldest commands and everything past @p count, -1 if it's gone
+	 */
+	static int trimmedIndex(int index, int droppedFront, int count);
+
+	inline quint64 memoryUsage() const { return m_memoryUsage; }
+	inline quint64 memoryLimit() const { return m_memoryLimit; }
+	void setMemoryLimit(quint64 bytes);
 
 public slots:
 	void undo();
 	void redo();
 
+signals:
+	void indexChanged(int idx);
+	void canUndoChanged(bool canUndo);
+	void canRedoChanged(bool canRedo);
+	void undoTextChanged(const QString &undoText);
+	void redoTextChanged(const QString &redoText);
+	void memoryUsageChanged(quint64 bytes);
+
 private:
 	void levelIncrease(int idx);
 	void levelDecrease(int idx);
 
+	void dropRedoCommands();
+	void commandsChanged();
+	void compact();
+	void emitStateChanged();
+
 private:
 	int m_level;
 	QStack<Selection> m_selectionStack;
 	QStack<DirtyMode> m_dirtyStack;
 	QAction *m_undoAction;
 	QAction *m_redoAction;
+
+	QVector<UndoAction *> m_commands;
+	QVector<quint64> m_commandSizes;
+	QVector<UndoMacro *> m_macros;
+	int m_index;
+	quint64 m_memoryUsage;
+	quint64 m_memoryLimit;
 };
 
 }
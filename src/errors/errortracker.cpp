@@ -46,6 +46,9 @@ ErrorTracker::connectSlots()
 	connect(m_subtitle.constData(), &Subtitle::lineSecondaryTextChanged, this, &ErrorTracker::onLineSecondaryTextChanged);
 	connect(m_subtitle.constData(), &Subtitle::lineShowTimeChanged, this, &ErrorTracker::onLineTimesChanged);
 	connect(m_subtitle.constData(), &Subtitle::lineHideTimeChanged, this, &ErrorTracker::onLineTimesChanged);
+	connect(m_subtitle.constData(), &Subtitle::linesTimesChanged, this, &ErrorTracker::onLinesTimesChanged);
+	connect(m_subtitle.constData(), &Subtitle::linesPrimaryTextChanged, this, &ErrorTracker::onLinesPrimaryTextChanged);
+	connect(m_subtitle.constData(), &Subtitle::linesSecondaryTextChanged, this, &ErrorTracker::onLinesSecondaryTextChanged);
 }
 
 void
@@ -72,6 +75,24 @@ ErrorTracker::onLineSecondaryTextChanged(SubtitleLine *line)
 	updateLineErrors(line, line->errorFlags() & SubtitleLine::SecondaryOnlyErrors);
 }
 
+void
+ErrorTracker::onLinesPrimaryTextChanged(int firstIndex, int lastIndex)
+{
+	for(int i = firstIndex; i <= lastIndex; i++) {
+		SubtitleLine *line = m_subtitle->at(i);
+		updateLineErrors(line, line->errorFlags() & SubtitleLine::PrimaryOnlyErrors);
+	}
+}
+
+void
+ErrorTracker::onLinesSecondaryTextChanged(int firstIndex, int lastIndex)
+{
+	for(int i = firstIndex; i <= lastIndex; i++) {
+		SubtitleLine *line = m_subtitle->at(i);
+		updateLineErrors(line, line->errorFlags() & SubtitleLine::SecondaryOnlyErrors);
+	}
+}
+
 void
 ErrorTracker::onLineTimesChanged(SubtitleLine *line)
 {
@@ -82,6 +103,13 @@ ErrorTracker::onLineTimesChanged(SubtitleLine *line)
 		updateLineErrors(prevLine, prevLine->errorFlags() & SubtitleLine::OverlapsWithNext);
 }
 
+void
+ErrorTracker::onLinesTimesChanged(int firstIndex, int lastIndex)
+{
+	// text errors don't depend on times, rechecking them changes nothing
+	m_subtitle->recheckErrors(RangeList(Range(qMax(0, firstIndex - 1), lastIndex)));
+}
+
 void
 ErrorTracker::onConfigChanged()
 {
@@ -35,7 +35,10 @@ private:
 private slots:
 	void onLinePrimaryTextChanged(SubtitleLine *line);
 	void onLineSecondaryTextChanged(SubtitleLine *line);
+	void onLinesPrimaryTextChanged(int firstIndex, int lastIndex);
+	void onLinesSecondaryTextChanged(int firstIndex, int lastIndex);
 	void onLineTimesChanged(SubtitleLine *line);
+	void onLinesTimesChanged(int firstIndex, int lastIndex);
 
 	void onConfigChanged();
 
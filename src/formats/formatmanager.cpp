@@ -41,6 +41,7 @@
 #include <QFileDevice>
 #include <QFileInfo>
 #include <QSaveFile>
+#include <QScopedPointer>
 #include <QTextCodec>
 
 #include <QUrl>
@@ -49,6 +50,9 @@
 #	include <unicode/ucsdet.h>
 #endif
 
+#include <algorithm>
+#include <limits>
+
 using namespace SubtitleComposer;
 
 FormatManager &
@@ -169,62 +173,188 @@ FormatManager::readBinary(Subtitle &subtitle, const QUrl &url, bool primary,
 	return ERROR;
 }
 
+/**
+ * @brief Append decoded chunk to @p text converting CRLF and CR line endings to LF
+ * @param pendingCR true if previous chunk ended with CR - carried between calls
+ */
+static void
+appendNormalized(QString *text, QString chunk, bool *pendingCR)
+{
+	QChar *out = chunk.data();
+	const QChar *in = out;
+	const QChar *end = in + chunk.size();
+	for(; in != end; ++in) {
+		if(*pendingCR) {
+			*pendingCR = false;
+			if(*in == QChar::LineFeed)
+				continue;
+		}
+		if(*in == QChar::CarriageReturn) {
+			*pendingCR = true;
+			*out++ = QChar::LineFeed;
+		} else {
+			*out++ = *in;
+		}
+	}
+	chunk.truncate(out - chunk.constData());
+	text->append(chunk);
+}
+
+/**
+ * @brief Decode whole @p file into @p text in a single pass
+ * File is memory mapped when possible and decoded in fixed size chunks, so apart from resulting
+ * string only one chunk is held in memory. Line endings are normalized while decoding.
+ * @param codec when nullptr data is decoded as latin1
+ * @param cancel checked between chunks, decoding fails when it is set
+ */
+static bool
+decodeFile(QFile &file, QTextCodec *codec, QString *text, const QAtomicInt *cancel)
+{
+	const qint64 chunkSize = 256 * 1024;
+	const qint64 fileSize = file.size();
+
+	QScopedPointer<QTextDecoder> decoder(codec ? codec->makeDecoder() : nullptr);
+	auto decode = [&](const char *data, int len) -> QString {
+		return decoder ? decoder->toUnicode(data, len) : QString::fromLatin1(data, len);
+	};
+
+	text->clear();
+	text->reserve(qMin<qint64>(fileSize, std::numeric_limits<int>::max() / 2));
+	bool pendingCR = false;
+
+	if(uchar *map = fileSize > 0 ? file.map(0, fileSize) : nullptr) {
+		const char *data = reinterpret_cast<const char *>(map);
+		qint64 off = 0;
+		for(; off < fileSize && !(cancel && cancel->loadAcquire()); off += chunkSize)
+			appendNormalized(text, decode(data + off, int(qMin(chunkSize, fileSize - off))), &pendingCR);
+		file.unmap(map);
+		return off >= fileSize;
+	}
+
+	if(!file.seek(0))
+		return false;
+	QByteArray buf(chunkSize, Qt::Uninitialized);
+	for(;;) {
+		if(cancel && cancel->loadAcquire())
+			return false;
+		const qint64 len = file.read(buf.data(), chunkSize);
+		if(len < 0)
+			return false;
+		if(len == 0)
+			break;
+		appendNormalized(text, decode(buf.constData(), int(len)), &pendingCR);
+	}
+	return true;
+}
+
+/**
+ * @brief Score all text input formats against beginning of @p data
+ * Formats that know @p extension get a bonus. Formats that didn't recognize the sample are
+ * kept at the end with zero score, so they are still tried as last resort.
+ * @return format names and scores, best candidates first
+ */
+FormatManager::ProbeScores
+FormatManager::probeText(const QString &data, const QString &extension) const
+{
+	const QString sample = data.left(8 * 1024);
+
+	ProbeScores scores;
+	for(auto it = m_inputFormats.cbegin(), end = m_inputFormats.cend(); it != end; ++it) {
+		const InputFormat *format = it.value();
+		if(format->isBinary())
+			continue;
+		int score = format->probe(sample);
+		if(format->knowsExtension(extension))
+			score += 20;
+		scores.push_back(std::make_pair(format->name(), qMax(score, 0)));
+	}
+	std::stable_sort(scores.begin(), scores.end(), [](const std::pair<QString, int> &a, const std::pair<QString, int> &b){
+		return a.second > b.second;
+	});
+
+	return scores;
+}
+
 FormatManager::Status
-FormatManager::readText(Subtitle &subtitle, const QUrl &url, bool primary,
-						QTextCodec **codec, QString *formatName) const
+FormatManager::textCodec(const QUrl &url, QTextCodec **codec) const
 {
+	if(!codec || *codec)
+		return SUCCESS;
+
 	QFile file(url.toLocalFile());
 	if(!file.open(QIODevice::ReadOnly))
 		return ERROR;
-	// WARNING: only 1MB of text subtitle is being read here
-	QByteArray byteData = file.read(1024 * 1024);
-	file.close();
 
-	QString stringData;
-	if(!codec) {
-		// don't care about text nor text encoding
-		stringData = QString::fromLatin1(byteData);
-	} else {
-		if(!*codec) {
-			QTextCodec *c = detectEncoding(byteData);
-			if(!c)
-				return CANCEL;
-			*codec = c;
-		}
-		if(*codec)
-			stringData = (*codec)->toUnicode(byteData);
-	}
+	// encoding detection only needs a sample of the file
+	QTextCodec *c = detectEncoding(file.peek(1024 * 1024));
+	if(!c)
+		return CANCEL;
+	*codec = c;
+	return SUCCESS;
+}
 
-	stringData.replace(QLatin1String("\r\n"), QLatin1String("\n"));
-	stringData.replace('\r', '\n');
+FormatManager::Status
+FormatManager::parseText(const QUrl &url, QTextCodec *codec, ParsedSubtitle *subtitle,
+						 const std::function<void(const QString &formatName)> &started, const QAtomicInt *cancel) const
+{
+	QFile file(url.toLocalFile());
+	if(!file.open(QIODevice::ReadOnly))
+		return ERROR;
 
-	const QString extension = QFileInfo(url.path()).suffix();
+	QString stringData;
+	if(!decodeFile(file, codec, &stringData, cancel))
+		return cancel && cancel->loadAcquire() ? CANCEL : ERROR;
+	file.close();
 
-	// attempt to parse subtitles based on extension information first
-	for(QMap<QString, InputFormat *>::ConstIterator it = m_inputFormats.begin(), end = m_inputFormats.end(); it != end; ++it) {
-		if(it.value()->knowsExtension(extension)) {
-			if(it.value()->readSubtitle(subtitle, primary, stringData)) {
-				if(formatName)
-					*formatName = it.value()->name();
-				return SUCCESS;
-			}
-		}
-	}
+	const QString extension = QFileInfo(url.path()).suffix();
 
-	// attempt to parse subtitles based on content
-	for(QMap<QString, InputFormat *>::ConstIterator it = m_inputFormats.begin(), end = m_inputFormats.end(); it != end; ++it) {
-		if(!it.value()->knowsExtension(extension)) {
-			if(it.value()->readSubtitle(subtitle, primary, stringData)) {
-				if(formatName)
-					*formatName = it.value()->name();
-				return SUCCESS;
-			}
+	// parse with best scoring format first, others are tried only if it fails
+	const ProbeScores scores = probeText(stringData, extension);
+	for(const std::pair<QString, int> &score : scores) {
+		if(cancel && cancel->loadAcquire())
+			return CANCEL;
+		const InputFormat *format = input(score.first);
+		if(started)
+			started(format->name());
+		ParsedSubtitle parsed;
+		parsed.sink = subtitle->sink;
+		if(format->parseSubtitles(parsed, stringData)) {
+			*subtitle = std::move(parsed);
+			return SUCCESS;
 		}
 	}
 
 	return ERROR;
 }
 
+FormatManager::Status
+FormatManager::readText(Subtitle &subtitle, const QUrl &url, bool primary,
+						QTextCodec **codec, QString *formatName) const
+{
+	const Status res = textCodec(url, codec);
+	if(res != SUCCESS)
+		return res;
+
+	ParsedSubtitle parsed;
+	const InputFormat *format = nullptr;
+	const auto started = [this, &format](const QString &name){ format = input(name); };
+	if(parseText(url, codec ? *codec : nullptr, &parsed, started) != SUCCESS)
+		return ERROR;
+	if(formatName)
+		*formatName = format->name();
+
+	QExplicitlySharedDataPointer<Subtitle> newSubtitle(new Subtitle());
+	format->setSubtitleData(*newSubtitle, parsed);
+	newSubtitle->insertLines(format->createLines(parsed.lines), false);
+
+	if(primary)
+		subtitle.setPrimaryData(*newSubtitle, true);
+	else
+		subtitle.setSecondaryData(*newSubtitle, true);
+
+	return SUCCESS;
+}
+
 FormatManager::Status
 FormatManager::readSubtitle(Subtitle &subtitle, bool primary, const QUrl &url,
 							QTextCodec **codec, QString *formatName) const
@@ -261,8 +391,8 @@ FormatManager::outputNames() const
 }
 
 bool
-FormatManager::writeSubtitle(const Subtitle &subtitle, bool primary, const QUrl &url,
-							 QTextCodec *codec, const QString &formatName, bool overwrite) const
+FormatManager::writeSubtitle(const SubtitleSnapshot &subtitle, bool primary, const QUrl &url,
+							 QTextCodec *codec, const QString &formatName, bool overwrite, const QAtomicInt *cancel) const
 {
 	const OutputFormat *format = output(formatName);
 	if(format == nullptr) {
@@ -284,20 +414,14 @@ FormatManager::writeSubtitle(const Subtitle &subtitle, bool primary, const QUrl
 	if(!file.open(QIODevice::WriteOnly | QIODevice::Truncate))
 		return false;
 
-	QString data = format->writeSubtitle(subtitle, primary);
+	OutputSink out(&file, codec, OutputSink::LineBreak(SCConfig::textLineBreak()), cancel);
 	if(codec->name().startsWith("UTF-") || codec->name().contains("UCS-"))
-		data.prepend(QChar::ByteOrderMark);
-	switch(SCConfig::textLineBreak()) {
-	case 1: // CRLF
-		file.write(codec->fromUnicode(data.replace(QChar::LineFeed, QLatin1String("\r\n"))));
-		break;
-	case 2: // CR
-		file.write(codec->fromUnicode(data.replace(QChar::LineFeed, QChar::CarriageReturn)));
-		break;
-	default: // LF
-		file.write(codec->fromUnicode(data));
-		break;
-	}
+		out << QChar(QChar::ByteOrderMark);
+	format->writeSubtitle(subtitle, primary, out);
 
+	if(!out.flush()) {
+		file.cancelWriting();
+		return false;
+	}
 	return file.commit();
 }
@@ -10,9 +10,15 @@
 
 #include "format.h"
 
+#include <QAtomicInt>
+#include <QExplicitlySharedDataPointer>
 #include <QString>
 #include <QStringList>
 #include <QMap>
+#include <QVector>
+
+#include <functional>
+#include <utility>
 
 #include <QUrl>
 #include <KEncodingProber>
@@ -23,6 +29,8 @@ namespace SubtitleComposer {
 class InputFormat;
 class OutputFormat;
 class Subtitle;
+class SubtitleSnapshot;
+struct ParsedSubtitle;
 class FormatManager
 {
 public:
@@ -31,29 +39,55 @@ public:
 		CANCEL = 0,
 		ERROR = -1
 	};
+	typedef QVector<std::pair<QString, int>> ProbeScores;
+
 	static FormatManager & instance();
 
 	bool hasInput(const QString &name) const;
 	const InputFormat * input(const QString &name) const;
 	QStringList inputNames() const;
 
+	ProbeScores probeText(const QString &data, const QString &extension = QString()) const;
+
 	Status readSubtitle(Subtitle &subtitle, bool primary, const QUrl &url,
 						QTextCodec **codec, QString *format = nullptr) const;
 
+	Status readBinary(Subtitle &subtitle, const QUrl &url, bool primary,
+					  QTextCodec **codec, QString *format) const;
+	/**
+	 * @brief Detect text encoding of @p url if *@p codec is nullptr, user is asked to confirm it
+	 * Must be called on GUI thread. When @p codec is nullptr text will be decoded as latin1.
+	 */
+	Status textCodec(const QUrl &url, QTextCodec **codec) const;
+	/**
+	 * @brief Decode and parse text subtitle @p url into @p subtitle
+	 * Doesn't touch GUI or create any QObjects, so it can run on a worker thread.
+	 * Lines are handed to subtitle->sink while parsing when it is set.
+	 * @param started called with format name before each parse attempt, lines already handed to sink
+	 * by a previous attempt belong to a format that failed and must be dropped
+	 * @param cancel when set to non-zero reading stops and CANCEL is returned
+	 */
+	Status parseText(const QUrl &url, QTextCodec *codec, ParsedSubtitle *subtitle,
+					 const std::function<void(const QString &formatName)> &started = nullptr,
+					 const QAtomicInt *cancel = nullptr) const;
+
 	bool hasOutput(const QString &name) const;
 	const OutputFormat * output(const QString &name) const;
 	const OutputFormat * defaultOutput() const;
 	QStringList outputNames() const;
 
-	bool writeSubtitle(const Subtitle &subtitle, bool primary, const QUrl &url,
-					   QTextCodec *codec, const QString &format, bool overwrite) const;
+	/**
+	 * @brief Stream @p subtitle snapshot into @p url, file is replaced only once everything is written
+	 * Doesn't touch GUI, so it can run on a worker thread.
+	 * @param cancel when set to non-zero writing stops and existing file is left untouched
+	 */
+	bool writeSubtitle(const SubtitleSnapshot &subtitle, bool primary, const QUrl &url,
+					   QTextCodec *codec, const QString &format, bool overwrite, const QAtomicInt *cancel = nullptr) const;
 
 protected:
 	FormatManager();
 	~FormatManager();
 
-	Status readBinary(Subtitle &subtitle, const QUrl &url, bool primary,
-					  QTextCodec **codec, QString *format) const;
 	Status readText(Subtitle &subtitle, const QUrl &url, bool primary,
 					QTextCodec **codec, QString *formatName) const;
 
@@ -0,0 +1,100 @@
+/*
+    SPDX-FileCopyrightText: 2010-2022 Mladen Milinkovic <max@smoothware.net>
+
+    SPDX-License-Identifier: GPL-2.0-or-later
+*/
+
+#include "inputformat.h"
+
+#include "core/subtitle.h"
+#include "core/subtitleline.h"
+#include "helpers/parallel.h"
+
+#include <QScopedArrayPointer>
+#include <QSemaphore>
+
+using namespace SubtitleComposer;
+
+// chunks smaller than this are not worth a thread
+#define MIN_CHUNK_SIZE (256 * 1024)
+
+bool
+InputFormat::parseChunked(ParsedSubtitle &subtitle, const QString &data, int begin, const ChunkBoundary &chunkBoundary, const ChunkParser &parseChunk) const
+{
+	const int end = data.size();
+	const int chunkCount = qBound(1, (end - begin) / MIN_CHUNK_SIZE, qMax(1, QThread::idealThreadCount()));
+
+	QVector<int> bounds;
+	bounds.reserve(chunkCount + 1);
+	bounds.append(begin);
+	for(int i = 1; i < chunkCount; i++) {
+		const int from = begin + int(qint64(end - begin) * i / chunkCount);
+		bounds.append(qMax(bounds.last(), chunkBoundary(data, qMax(from, bounds.last()))));
+	}
+	bounds.append(end);
+
+	const int firstCount = subtitle.lineCount;
+	QVector<ParsedLines> chunks(chunkCount);
+	if(chunkCount == 1) {
+		parseChunk(data, begin, end, &chunks[0]);
+		for(const ParsedLine &line : qAsConst(chunks[0]))
+			subtitle.append(line);
+	} else {
+		// chunks are released to subtitle in file order, each one as soon as it's parsed
+		QScopedArrayPointer<QSemaphore> parsed(new QSemaphore[chunkCount]);
+		QThreadPool pool;
+		pool.setMaxThreadCount(chunkCount);
+		for(int i = 0; i < chunkCount; i++) {
+			if(bounds.at(i) == bounds.at(i + 1)) {
+				parsed[i].release();
+				continue;
+			}
+			ParsedLines *lines = &chunks[i];
+			QSemaphore *done = &parsed[i];
+			const int chunkBegin = bounds.at(i);
+			const int chunkEnd = bounds.at(i + 1);
+			pool.start(new FunctionRunnable([&parseChunk, &data, chunkBegin, chunkEnd, lines, done](){
+				parseChunk(data, chunkBegin, chunkEnd, lines);
+				done->release();
+			}));
+		}
+		for(int i = 0; i < chunkCount; i++) {
+			parsed[i].acquire();
+			for(const ParsedLine &line : qAsConst(chunks[i]))
+				subtitle.append(line);
+			chunks[i].clear();
+		}
+		pool.waitForDone();
+	}
+	subtitle.flush();
+
+	return subtitle.lineCount > firstCount;
+}
+
+QList<SubtitleLine *>
+InputFormat::createLines(const ParsedLines &lines) const
+{
+	QList<SubtitleLine *> newLines;
+	newLines.reserve(lines.size());
+	for(const ParsedLine &pl : lines) {
+		SubtitleLine *line = new SubtitleLine(pl.showTime, pl.hideTime);
+		line->resetPrimaryText(pl.text);
+		line->m_position = pl.position;
+		line->m_metaData = pl.meta;
+		if(pl.formatData)
+			setFormatData(line, pl.formatData.data());
+		newLines.append(line);
+	}
+	return newLines;
+}
+
+void
+InputFormat::setSubtitleData(Subtitle &subtitle, const ParsedSubtitle &parsed) const
+{
+	subtitle.m_framesPerSecond = parsed.framesPerSecond;
+	subtitle.m_metaData = parsed.meta;
+	subtitle.stylesheetClear();
+	for(const QString &css : parsed.stylesheet)
+		subtitle.stylesheetAppend(css);
+	setFormatData(subtitle, parsed.formatData.data());
+}
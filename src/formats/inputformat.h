@@ -10,18 +10,32 @@
 
 #include "format.h"
 #include "formatmanager.h"
+#include "parsedsubtitle.h"
+
+#include "core/richstring.h"
+#include "core/time.h"
+
+#include <QRegularExpression>
+#include <QVector>
+
+#include <functional>
 
 namespace SubtitleComposer {
 class InputFormat : public Format
 {
+	friend class FormatManager;
+
 public:
 	bool readSubtitle(Subtitle &subtitle, bool primary, const QString &data) const
 	{
-		QExplicitlySharedDataPointer<Subtitle> newSubtitle(new Subtitle());
-
-		if(!parseSubtitles(*newSubtitle, data))
+		ParsedSubtitle parsed;
+		if(!parseSubtitles(parsed, data))
 			return false;
 
+		QExplicitlySharedDataPointer<Subtitle> newSubtitle(new Subtitle());
+		setSubtitleData(*newSubtitle, parsed);
+		newSubtitle->insertLines(createLines(parsed.lines), false);
+
 		if(primary)
 			subtitle.setPrimaryData(*newSubtitle, true);
 		else
@@ -30,11 +44,62 @@ public:
 		return true;
 	}
 
+	/**
+	 * @brief Parse @p data into @p subtitle
+	 * It can run on a worker thread, so it must not touch any subtitle or create any QObjects.
+	 * @return false if data is not in this format
+	 */
+	virtual bool parseSubtitles(ParsedSubtitle &subtitle, const QString &data) const = 0;
+
+	/**
+	 * @brief Create subtitle lines from @p lines, they belong to the calling thread
+	 */
+	QList<SubtitleLine *> createLines(const ParsedLines &lines) const;
+	/**
+	 * @brief Set subtitle wide data of @p parsed on @p subtitle without undo
+	 */
+	void setSubtitleData(Subtitle &subtitle, const ParsedSubtitle &parsed) const;
+
+	/**
+	 * @brief Cheaply estimate if @p sample (beginning of the file) is in this format
+	 * Used to pick the parser before doing full parse, it must not create any subtitle lines.
+	 * @return score from 0 (not this format) to 100 (certainly this format)
+	 */
+	virtual int probe(const QString &/*sample*/) const { return 1; }
+
 	virtual bool isBinary() const { return false; }
 	virtual FormatManager::Status readBinary(Subtitle &, const QUrl &) { return FormatManager::ERROR; }
 
+	/**
+	 * @brief Return offset of the first cue that starts at or after @p from, or data size if there is none
+	 */
+	typedef std::function<int(const QString &data, int from)> ChunkBoundary;
+	/**
+	 * @brief Parse all cues between @p begin and @p end offsets into @p lines
+	 * It runs on worker threads, so it must not touch the subtitle or create any QObjects.
+	 */
+	typedef std::function<void(const QString &data, int begin, int end, ParsedLines *lines)> ChunkParser;
+
 protected:
-	virtual bool parseSubtitles(Subtitle &subtitle, const QString &data) const = 0;
+	/**
+	 * @brief Split @p data (starting at @p begin) into chunks on cue boundaries and parse them in parallel
+	 * Parsed chunks are appended to @p subtitle in file order as soon as they and all chunks before them are done.
+	 * Small files are parsed in a single chunk on the calling thread.
+	 * @return false if no lines were parsed
+	 */
+	bool parseChunked(ParsedSubtitle &subtitle, const QString &data, int begin, const ChunkBoundary &chunkBoundary, const ChunkParser &parseChunk) const;
+
+	/**
+	 * @brief Score @p sample by number of cue headers @p re finds in it
+	 * Three or more cues give @p maxScore, less than that give proportionally smaller score.
+	 */
+	static int probeCues(const QRegularExpression &re, const QString &sample, int maxScore)
+	{
+		int matches = 0;
+		for(QRegularExpressionMatchIterator it = re.globalMatch(sample); it.hasNext() && matches < 3; it.next())
+			matches++;
+		return matches * maxScore / 3;
+	}
 
 	InputFormat(const QString &name, const QStringList &extensions) : Format(name, extensions) {}
 };
@@ -10,7 +10,6 @@
 
 #include "formats/outputformat.h"
 #include "core/richtext/richdocument.h"
-#include "core/subtitleiterator.h"
 
 namespace SubtitleComposer {
 class MicroDVDOutputFormat : public OutputFormat
@@ -22,49 +21,44 @@ public:
 
 protected:
 
-	QString dumpSubtitles(const Subtitle &subtitle, bool primary) const override
+	void dumpSubtitles(const SubtitleSnapshot &subtitle, bool primary, OutputSink &out) const override
 	{
-		QString ret;
-
 		double framesPerSecond = subtitle.framesPerSecond();
-		ret += m_lineBuilder
+		out << m_lineBuilder
 				.arg(1)
 				.arg(1)
 				.arg(QString::number(framesPerSecond, 'f', 3));
 
-		for(SubtitleIterator it(subtitle); it.current(); ++it) {
-			const SubtitleLine *line = it.current();
-
-			const RichString &text = (primary ? line->primaryDoc() : line->secondaryDoc())->toRichText();
-			QString subtitle;
+		for(int i = 0, n = subtitle.count(); i < n; i++) {
+			const RichString &text = (primary ? subtitle.primaryText(i) : subtitle.secondaryText(i));
+			QString line;
 
 			int prevStyle = 0;
 			QRgb prevColor = 0;
-			for(int i = 0, sz = text.length(); i < sz; i++) {
-				int curStyle = text.styleFlagsAt(i);
-				QRgb curColor = (curStyle &RichString::Color) != 0 ? text.styleColorAt(i) : 0;
+			for(int c = 0, sz = text.length(); c < sz; c++) {
+				int curStyle = text.styleFlagsAt(c);
+				QRgb curColor = (curStyle &RichString::Color) != 0 ? text.styleColorAt(c) : 0;
 				curStyle &= RichString::Bold | RichString::Italic | RichString::Underline;
 				if(prevStyle != curStyle)
-					subtitle += m_stylesMap[curStyle];
+					line += m_stylesMap[curStyle];
 				if(prevColor != curColor)
-					subtitle += "{c:" + (curColor != 0 ? "$" + QColor(qBlue(curColor), qGreen(curColor), qRed(curColor)).name().mid(1).toLower() : "") + "}";
+					line += "{c:" + (curColor != 0 ? "$" + QColor(qBlue(curColor), qGreen(curColor), qRed(curColor)).name().mid(1).toLower() : "") + "}";
 
-				const QChar ch = text.at(i);
+				const QChar ch = text.at(c);
 				if(ch == '\n' || ch == '\r')
-					subtitle += '|';
+					line += '|';
 				else
-					subtitle += ch;
+					line += ch;
 
 				prevStyle = curStyle;
 				prevColor = curColor;
 			}
 
-			ret += m_lineBuilder
-					.arg(static_cast<long>((line->showTime().toMillis() / 1000.0) * framesPerSecond + 0.5))
-					.arg(static_cast<long>((line->hideTime().toMillis() / 1000.0) * framesPerSecond + 0.5))
-					.arg(subtitle);
+			out << m_lineBuilder
+					.arg(static_cast<long>((subtitle.showTime(i).toMillis() / 1000.0) * framesPerSecond + 0.5))
+					.arg(static_cast<long>((subtitle.hideTime(i).toMillis() / 1000.0) * framesPerSecond + 0.5))
+					.arg(line);
 		}
-		return ret;
 	}
 
 	MicroDVDOutputFormat() :
@@ -24,11 +24,17 @@ protected:
 		: InputFormat($("MPlayer"), QStringList($("mpl")))
 	{}
 
-	bool parseSubtitles(Subtitle &subtitle, const QString &data) const override
+	int probe(const QString &sample) const override
+	{
+		staticRE$(reCue, "(?:^|\n)\\d+,\\d+,0,", REu);
+		return probeCues(reCue, sample, 80);
+	}
+
+	bool parseSubtitles(ParsedSubtitle &subtitle, const QString &data) const override
 	{
 		staticRE$(lineRE, "(^|\n)(\\d+),(\\d+),0,([^\n]+)[^\n]", REu | REi);
 
-		const double fps = subtitle.framesPerSecond();
+		const double fps = subtitle.framesPerSecond;
 
 		QRegularExpressionMatchIterator itLine = lineRE.globalMatch(data);
 		if(!itLine.hasNext())
@@ -40,11 +46,15 @@ protected:
 			const Time hideTime(static_cast<long>((mLine.captured(2).toLong() / fps) * 1000));
 			const QString text = mLine.captured(3).replace(QChar('|'), QChar('\n'));
 
-			SubtitleLine *line = new SubtitleLine(showTime, hideTime);
-			line->primaryDoc()->setPlainText(text);
-			subtitle.insertLine(line);
+			ParsedLine line;
+			line.showTime = showTime;
+			line.hideTime = hideTime;
+			line.text = RichString(text);
+			subtitle.append(line);
 		} while(itLine.hasNext());
 
+		subtitle.flush();
+
 		return true;
 	}
 };
@@ -24,7 +24,13 @@ protected:
 		: InputFormat($("MPlayer2"), QStringList($("mpl")))
 	{}
 
-	bool parseSubtitles(Subtitle &subtitle, const QString &data) const override
+	int probe(const QString &sample) const override
+	{
+		staticRE$(reCue, "(?:^|\n)\\[\\d+\\]\\[\\d+\\]", REu);
+		return probeCues(reCue, sample, 80);
+	}
+
+	bool parseSubtitles(ParsedSubtitle &subtitle, const QString &data) const override
 	{
 		staticRE$(lineRE, "\\[(\\d+)\\]\\[(\\d+)\\]([^\n]+)\n", REu | REi);
 
@@ -38,11 +44,15 @@ protected:
 			const Time hideTime(mLine.captured(2).toInt() * 100);
 			const QString text = mLine.captured(3).replace(QChar('|'), QChar('\n'));
 
-			SubtitleLine *line = new SubtitleLine(showTime, hideTime);
-			line->primaryDoc()->setPlainText(text);
-			subtitle.insertLine(line);
+			ParsedLine line;
+			line.showTime = showTime;
+			line.hideTime = hideTime;
+			line.text = RichString(text);
+			subtitle.append(line);
 		} while(itLine.hasNext());
 
+		subtitle.flush();
+
 		return true;
 	}
 };
@@ -10,7 +10,6 @@
 
 #include "formats/outputformat.h"
 #include "core/richtext/richdocument.h"
-#include "core/subtitleiterator.h"
 
 namespace SubtitleComposer {
 class MPlayer2OutputFormat : public OutputFormat
@@ -18,20 +17,15 @@ class MPlayer2OutputFormat : public OutputFormat
 	friend class FormatManager;
 
 protected:
-	QString dumpSubtitles(const Subtitle &subtitle, bool primary) const override
+	void dumpSubtitles(const SubtitleSnapshot &subtitle, bool primary, OutputSink &out) const override
 	{
-		QString ret;
+		for(int i = 0, n = subtitle.count(); i < n; i++) {
+			QString text = subtitle.plainText(i, primary);
 
-		for(SubtitleIterator it(subtitle); it.current(); ++it) {
-			const SubtitleLine *line = it.current();
-
-			QString text = (primary ? line->primaryDoc() : line->secondaryDoc())->toPlainText();
-
-			ret += m_lineBuilder.arg(static_cast<long>((line->showTime().toMillis() / 100.0) + 0.5))
-					.arg(static_cast<long>((line->hideTime().toMillis() / 100.0) + 0.5))
+			out << m_lineBuilder.arg(static_cast<long>((subtitle.showTime(i).toMillis() / 100.0) + 0.5))
+					.arg(static_cast<long>((subtitle.hideTime(i).toMillis() / 100.0) + 0.5))
 					.arg(text.replace('\n', '|'));
 		}
-		return ret;
 	}
 
 	MPlayer2OutputFormat() :
@@ -9,19 +9,35 @@
 #define OUTPUTFORMAT_H
 
 #include "format.h"
+#include "formats/outputsink.h"
+#include "core/subtitlesnapshot.h"
 
 namespace SubtitleComposer {
 class OutputFormat : public Format
 {
 public:
-
-	QString writeSubtitle(const Subtitle &subtitle, bool primary) const
+	/**
+	 * @brief Write subtitle cue by cue into sink - snapshot makes this safe to run on any thread
+	 */
+	void writeSubtitle(const SubtitleSnapshot &subtitle, bool primary, OutputSink &out) const
 	{
-		return dumpSubtitles(subtitle, primary);
+		dumpSubtitles(subtitle, primary, out);
 	}
 
 protected:
-	virtual QString dumpSubtitles(const Subtitle &subtitle, bool primary) const = 0;
+	virtual void dumpSubtitles(const SubtitleSnapshot &subtitle, bool primary, OutputSink &out) const = 0;
+
+	const FormatData * formatData(const SubtitleSnapshot &subtitle) const
+	{
+		const FormatData *formatData = subtitle.formatData();
+		return formatData && formatData->formatName() == m_name ? formatData : nullptr;
+	}
+
+	const FormatData * formatData(const SubtitleSnapshot &subtitle, int index) const
+	{
+		const FormatData *formatData = subtitle.formatData(index);
+		return formatData && formatData->formatName() == m_name ? formatData : nullptr;
+	}
 
 	OutputFormat(const QString &name, const QStringList &extensions) : Format(name, extensions) {}
 };
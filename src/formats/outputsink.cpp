@@ -0,0 +1,95 @@
+/*
+    SPDX-FileCopyrightText: 2010-2022 Mladen Milinkovic <max@smoothware.net>
+
+    SPDX-License-Identifier: GPL-2.0-or-later
+*/
+
+#include "outputsink.h"
+
+#include <QIODevice>
+#include <QTextCodec>
+
+using namespace SubtitleComposer;
+
+OutputSink::OutputSink(QIODevice *device, QTextCodec *codec, LineBreak lineBreak, const QAtomicInt *cancel)
+	: m_device(device),
+	  // BOM is written by format manager only for unicode codecs
+	  m_encoder(codec->makeEncoder(QTextCodec::IgnoreHeader)),
+	  m_lineBreak(lineBreak),
+	  m_cancel(cancel)
+{
+	m_buffer.reserve(BufferSize + BufferSize / 4);
+}
+
+OutputSink::~OutputSink()
+{
+	delete m_encoder;
+}
+
+void
+OutputSink::append(const QString &text)
+{
+	switch(m_lineBreak) {
+	case CRLF:
+		m_buffer.append(QString(text).replace(QChar::LineFeed, QLatin1String("\r\n")));
+		break;
+	case CR:
+		m_buffer.append(QString(text).replace(QChar::LineFeed, QChar::CarriageReturn));
+		break;
+	default:
+		m_buffer.append(text);
+		break;
+	}
+	flushIfFull();
+}
+
+OutputSink &
+OutputSink::operator<<(const QString &text)
+{
+	if(!m_error)
+		append(text);
+	return *this;
+}
+
+OutputSink &
+OutputSink::operator<<(QLatin1String text)
+{
+	if(!m_error)
+		append(QString(text));
+	return *this;
+}
+
+OutputSink &
+OutputSink::operator<<(QChar ch)
+{
+	if(m_error)
+		return *this;
+	if(ch != QChar::LineFeed)
+		m_buffer.append(ch);
+	else if(m_lineBreak == CRLF)
+		m_buffer.append(QLatin1String("\r\n"));
+	else
+		m_buffer.append(m_lineBreak == CR ? QChar(QChar::CarriageReturn) : ch);
+	flushIfFull();
+	return *this;
+}
+
+bool
+OutputSink::flush()
+{
+	if(m_error)
+		return false;
+	if(m_cancel && m_cancel->loadAcquire()) {
+		m_error = true;
+		return false;
+	}
+	if(m_buffer.isEmpty())
+		return true;
+
+	// encoder keeps state, so surrogate pairs split between blocks are encoded correctly
+	const QByteArray data = m_encoder->fromUnicode(m_buffer);
+	m_buffer.clear();
+	if(m_device->write(data) != data.size())
+		m_error = true;
+	return !m_error;
+}
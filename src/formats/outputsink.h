@@ -0,0 +1,58 @@
+/*
+    SPDX-FileCopyrightText: 2010-2022 Mladen Milinkovic <max@smoothware.net>
+
+    SPDX-License-Identifier: GPL-2.0-or-later
+*/
+
+#ifndef OUTPUTSINK_H
+#define OUTPUTSINK_H
+
+#include <QAtomicInt>
+#include <QString>
+
+QT_FORWARD_DECLARE_CLASS(QIODevice)
+QT_FORWARD_DECLARE_CLASS(QTextCodec)
+QT_FORWARD_DECLARE_CLASS(QTextEncoder)
+
+namespace SubtitleComposer {
+/**
+ * @brief Encodes text written by output formats and streams it to device in small blocks
+ * Line feeds are converted to requested line break as text passes through.
+ */
+class OutputSink
+{
+public:
+	enum LineBreak { LF, CRLF, CR };
+
+	OutputSink(QIODevice *device, QTextCodec *codec, LineBreak lineBreak, const QAtomicInt *cancel = nullptr);
+	~OutputSink();
+
+	OutputSink & operator<<(const QString &text);
+	OutputSink & operator<<(QLatin1String text);
+	OutputSink & operator<<(const char *text) { return *this << QLatin1String(text); }
+	OutputSink & operator<<(QChar ch);
+
+	/**
+	 * @brief Write out buffered text
+	 * @return false if writing failed or was canceled
+	 */
+	bool flush();
+	inline bool hasError() const { return m_error; }
+
+private:
+	void append(const QString &text);
+	inline void flushIfFull() { if(m_buffer.size() >= BufferSize) flush(); }
+
+private:
+	enum { BufferSize = 1 << 16 };
+
+	QIODevice *m_device;
+	QTextEncoder *m_encoder;
+	LineBreak m_lineBreak;
+	const QAtomicInt *m_cancel;
+	QString m_buffer;
+	bool m_error = false;
+};
+}
+
+#endif // OUTPUTSINK_H
@@ -0,0 +1,71 @@
+/*
+    SPDX-FileCopyrightText: 2010-2022 Mladen Milinkovic <max@smoothware.net>
+
+    SPDX-License-Identifier: GPL-2.0-or-later
+*/
+
+#ifndef PARSEDSUBTITLE_H
+#define PARSEDSUBTITLE_H
+
+#include "core/formatdata.h"
+#include "core/richstring.h"
+#include "core/subtitle.h"
+#include "core/subtitleline.h"
+#include "core/time.h"
+
+#include <QByteArray>
+#include <QMap>
+#include <QSharedPointer>
+#include <QStringList>
+#include <QVector>
+
+#include <functional>
+
+// lines handed to ParsedSubtitle::sink at once
+#define PARSED_BATCH_SIZE 1000
+
+namespace SubtitleComposer {
+struct ParsedLine {
+	Time showTime;
+	Time hideTime;
+	RichString text;
+	SubtitleRect position;
+	QMap<QByteArray, QString> meta;
+	QSharedPointer<FormatData> formatData;
+};
+typedef QVector<ParsedLine> ParsedLines;
+
+/**
+ * @brief Subtitle as read by input format - plain data that can be filled on any thread
+ * If sink is set, lines are handed to it in batches while parsing, otherwise they are all kept in lines.
+ */
+struct ParsedSubtitle {
+	double framesPerSecond = Subtitle::defaultFramesPerSecond();
+	QMap<QByteArray, QString> meta;
+	QStringList stylesheet;
+	QSharedPointer<FormatData> formatData;
+
+	ParsedLines lines;
+	int lineCount = 0;
+	std::function<void(ParsedSubtitle &)> sink;
+
+	inline void append(const ParsedLine &line)
+	{
+		lines.append(line);
+		lineCount++;
+		if(sink && lines.size() >= PARSED_BATCH_SIZE)
+			flush();
+	}
+
+	/**
+	 * @brief Hand lines parsed so far to the sink, which takes them out of lines
+	 */
+	inline void flush()
+	{
+		if(sink && !lines.isEmpty())
+			sink(*this);
+	}
+};
+}
+
+#endif // PARSEDSUBTITLE_H
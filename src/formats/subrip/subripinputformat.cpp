@@ -0,0 +1,173 @@
+/*
+    SPDX-FileCopyrightText: 2007-2009 Sergio Pistone <sergio_pistone@yahoo.com.ar>
+    SPDX-FileCopyrightText: 2010-2022 Mladen Milinkovic <max@smoothware.net>
+
+    SPDX-License-Identifier: GPL-2.0-or-later
+*/
+
+#include "subripinputformat.h"
+
+#if QT_VERSION < QT_VERSION_CHECK(6, 0, 0)
+// QStringView use is unoptimized in Qt5, and some methods are missing pre 5.15
+#include <QStringRef>
+#define QStringView(x) QStringRef(&(x))
+#else
+#include <QStringView>
+#endif
+
+using namespace SubtitleComposer;
+
+static inline int
+nextLine(const QChar *str, int end, int off)
+{
+	while(off < end && str[off] != QChar::LineFeed)
+		off++;
+	return off < end ? off + 1 : end;
+}
+
+static inline bool
+skipChar(const QChar *str, int end, int *off, QChar ch)
+{
+	if(*off >= end || str[*off] != ch)
+		return false;
+	++*off;
+	return true;
+}
+
+static inline bool
+parseNumber(const QChar *str, int end, int *off, int minDigits, int maxDigits, int *value)
+{
+	int digits = 0;
+	int val = 0;
+	for(int i = *off; i < end && digits < maxDigits; i++, digits++) {
+		const ushort ch = str[i].unicode();
+		if(ch < '0' || ch > '9')
+			break;
+		val = val * 10 + (ch - '0');
+	}
+	if(digits < minDigits)
+		return false;
+	*off += digits;
+	*value = val;
+	return true;
+}
+
+/**
+ * @brief Parse "HH:MM:SS,mmm" timestamp (dot is accepted instead of comma) at @p off
+ */
+static bool
+parseTime(const QChar *str, int end, int *off, Time *time)
+{
+	int hours;
+	int minutes;
+	int seconds;
+	int millis;
+	int pos = *off;
+
+	if(!parseNumber(str, end, &pos, 2, 2, &hours) || hours > 29 || !skipChar(str, end, &pos, QChar(':')))
+		return false;
+	if(!parseNumber(str, end, &pos, 2, 2, &minutes) || minutes > 59 || !skipChar(str, end, &pos, QChar(':')))
+		return false;
+	if(!parseNumber(str, end, &pos, 2, 2, &seconds) || seconds > 59)
+		return false;
+	if(!skipChar(str, end, &pos, QChar(',')) && !skipChar(str, end, &pos, QChar('.')))
+		return false;
+	if(!parseNumber(str, end, &pos, 1, 9, &millis))
+		return false;
+
+	*time = Time(hours, minutes, seconds, millis);
+	*off = pos;
+	return true;
+}
+
+/**
+ * @brief Parse cue number and timing lines starting at @p off
+ * @return offset where cue text starts or -1 if there is no cue header at @p off
+ */
+static int
+parseCueHeader(const QChar *str, int end, int off, Time *showTime, Time *hideTime)
+{
+	int number;
+	if(!parseNumber(str, end, &off, 1, 9, &number) || !skipChar(str, end, &off, QChar::LineFeed))
+		return -1;
+
+	if(!parseTime(str, end, &off, showTime))
+		return -1;
+	const char arrow[] = " --> ";
+	for(int i = 0; arrow[i]; i++) {
+		if(!skipChar(str, end, &off, QChar::fromLatin1(arrow[i])))
+			return -1;
+	}
+	if(!parseTime(str, end, &off, hideTime))
+		return -1;
+
+	// ignore anything following hide time (e.g. coordinates)
+	return nextLine(str, end, off);
+}
+
+/**
+ * @brief Find start of the first cue header line at or after @p from
+ */
+static int
+cueBoundary(const QString &data, int from)
+{
+	const QChar *str = data.constData();
+	const int end = data.size();
+
+	Time showTime;
+	Time hideTime;
+	// start on a line beginning
+	int off = from;
+	if(off > 0 && str[off - 1] != QChar::LineFeed)
+		off = nextLine(str, end, off);
+	for(; off < end; off = nextLine(str, end, off)) {
+		if(parseCueHeader(str, end, off, &showTime, &hideTime) != -1)
+			return off;
+	}
+	return end;
+}
+
+static void
+parseCues(const QString &data, int begin, int end, ParsedLines *lines)
+{
+	const QChar *str = data.constData();
+
+	Time showTime;
+	Time hideTime;
+	int textStart = -1;
+	for(int off = begin; off < end && textStart == -1; off = nextLine(str, end, off))
+		textStart = parseCueHeader(str, end, off, &showTime, &hideTime);
+	if(textStart == -1)
+		return;
+
+	for(;;) {
+		// cue text spans everything up to the next cue header
+		Time nextShowTime;
+		Time nextHideTime;
+		int nextTextStart = -1;
+		int textEnd = textStart;
+		for(; textEnd < end; textEnd = nextLine(str, end, textEnd)) {
+			nextTextStart = parseCueHeader(str, end, textEnd, &nextShowTime, &nextHideTime);
+			if(nextTextStart != -1)
+				break;
+		}
+
+		ParsedLine line;
+		line.showTime = showTime;
+		line.hideTime = hideTime;
+		line.text.setRichString(QStringView(data).mid(textStart, textEnd - textStart).trimmed());
+		lines->append(line);
+
+		if(nextTextStart == -1)
+			break;
+		showTime = nextShowTime;
+		hideTime = nextHideTime;
+		textStart = nextTextStart;
+	}
+}
+
+bool
+SubRipInputFormat::parseSubtitles(ParsedSubtitle &subtitle, const QString &data) const
+{
+	return parseChunked(subtitle, data, 0, cueBoundary, parseCues);
+}
@@ -10,7 +10,6 @@
 
 #include "formats/outputformat.h"
 #include "core/richtext/richdocument.h"
-#include "core/subtitleiterator.h"
 
 namespace SubtitleComposer {
 class SubRipOutputFormat : public OutputFormat
@@ -18,24 +17,19 @@ class SubRipOutputFormat : public OutputFormat
 	friend class FormatManager;
 
 protected:
-	QString dumpSubtitles(const Subtitle &subtitle, bool primary) const override
+	void dumpSubtitles(const SubtitleSnapshot &subtitle, bool primary, OutputSink &out) const override
 	{
-		QString ret;
+		for(int i = 0, n = subtitle.count(); i < n; i++) {
+			Time showTime = subtitle.showTime(i);
+			Time hideTime = subtitle.hideTime(i);
+			out << QString::asprintf("%d\n%02d:%02d:%02d,%03d --> %02d:%02d:%02d,%03d\n", i + 1, showTime.hours(), showTime.minutes(), showTime.seconds(), showTime.millis(), hideTime.hours(), hideTime.minutes(), hideTime.seconds(), hideTime.millis());
 
-		for(SubtitleIterator it(subtitle); it.current(); ++it) {
-			const SubtitleLine *line = it.current();
+			const RichString text = (primary ? subtitle.primaryText(i) : subtitle.secondaryText(i));
 
-			Time showTime = line->showTime();
-			Time hideTime = line->hideTime();
-			ret += QString::asprintf("%d\n%02d:%02d:%02d,%03d --> %02d:%02d:%02d,%03d\n", it.index() + 1, showTime.hours(), showTime.minutes(), showTime.seconds(), showTime.millis(), hideTime.hours(), hideTime.minutes(), hideTime.seconds(), hideTime.millis());
+			out << text.richString().replace(QLatin1String("&amp;"), QLatin1String("&")).replace(QLatin1String("&lt;"), QLatin1String("<")).replace(QLatin1String("&gt;"), QLatin1String(">"));
 
-			const RichString text = (primary ? line->primaryDoc() : line->secondaryDoc())->toRichText();
-
-			ret += text.richString().replace(QLatin1String("&amp;"), QLatin1String("&")).replace(QLatin1String("&lt;"), QLatin1String("<")).replace(QLatin1String("&gt;"), QLatin1String(">"));
-
-			ret += QStringLiteral("\n\n");
+			out << QStringLiteral("\n\n");
 		}
-		return ret;
 	}
 
 	SubRipOutputFormat() :
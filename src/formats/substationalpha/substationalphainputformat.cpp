@@ -0,0 +1,348 @@
+/*
+    SPDX-FileCopyrightText: 2007-2009 Sergio Pistone <sergio_pistone@yahoo.com.ar>
+    SPDX-FileCopyrightText: 2010-2022 Mladen Milinkovic <max@smoothware.net>
+
+    SPDX-License-Identifier: GPL-2.0-or-later
+*/
+
+#include "substationalphainputformat.h"
+
+#include "core/richtext/richdocument.h"
+#include "core/subtitle.h"
+#include "core/subtitleline.h"
+
+#include <QColor>
+#include <QDebug>
+#include <QStringBuilder>
+#include <QVarLengthArray>
+
+#include <algorithm>
+
+#if QT_VERSION < QT_VERSION_CHECK(6, 0, 0)
+// QStringView use is unoptimized in Qt5, and some methods are missing pre 5.15
+#include <QStringRef>
+#define QStringView(x) QStringRef(&(x))
+#define QStringView_ QStringRef
+#define capturedView capturedRef
+#else
+#include <QStringView>
+#define QStringView_ QStringView
+#endif
+
+using namespace SubtitleComposer;
+
+static inline int
+lineEnd(const QChar *str, int end, int off)
+{
+	while(off < end && str[off] != QChar::LineFeed)
+		off++;
+	return off;
+}
+
+static inline int
+skipSpaces(const QChar *str, int end, int off)
+{
+	while(off < end && str[off] == QChar::Space)
+		off++;
+	return off;
+}
+
+static inline bool
+skipLiteral(const QChar *str, int end, int *off, QLatin1String literal)
+{
+	const int len = literal.size();
+	if(end - *off < len)
+		return false;
+	for(int i = 0; i < len; i++) {
+		if(str[*off + i] != QLatin1Char(literal.at(i)))
+			return false;
+	}
+	*off += len;
+	return true;
+}
+
+static inline bool
+parseNumber(const QChar *str, int end, int *off, int *value)
+{
+	int n = 0;
+	int i = *off;
+	while(i < end && str[i].isDigit())
+		n = n * 10 + str[i++].digitValue();
+	if(i == *off)
+		return false;
+	*off = i;
+	*value = n;
+	return true;
+}
+
+/**
+ * @brief Parse "H:MM:SS.CC" - the separator before centiseconds is not checked
+ */
+static bool
+parseTime(const QChar *str, int end, int off, Time *time)
+{
+	int h, m, s, cs;
+	off = skipSpaces(str, end, off);
+	if(!parseNumber(str, end, &off, &h) || off >= end || str[off++] != QChar(':'))
+		return false;
+	if(!parseNumber(str, end, &off, &m) || off >= end || str[off++] != QChar(':'))
+		return false;
+	if(!parseNumber(str, end, &off, &s) || ++off > end)
+		return false;
+	if(!parseNumber(str, end, &off, &cs))
+		return false;
+	*time = Time(h, m, s, cs * 10);
+	return true;
+}
+
+namespace {
+struct EventFormat {
+	int fields = 10;
+	int start = 1;
+	int end = 2;
+};
+}
+
+/**
+ * @brief Read column order from the [Events] "Format:" line - Text is always the last column
+ */
+static EventFormat
+parseEventFormat(QStringView_ line)
+{
+	EventFormat fmt;
+
+	line = line.mid(line.indexOf(QChar(':')) + 1);
+	const auto columns = line.split(QChar(','));
+	if(columns.size() < 3)
+		return fmt;
+
+	fmt.fields = columns.size();
+	fmt.start = fmt.end = -1;
+	for(int i = 0; i < fmt.fields - 1; i++) {
+		const auto col = columns.at(i).trimmed();
+		if(col.compare(QLatin1String("Start"), Qt::CaseInsensitive) == 0)
+			fmt.start = i;
+		else if(col.compare(QLatin1String("End"), Qt::CaseInsensitive) == 0)
+			fmt.end = i;
+	}
+	if(fmt.start == -1 || fmt.end == -1)
+		return EventFormat();
+	return fmt;
+}
+
+RichString
+SubStationAlphaInputFormat::toRichString(const QString &string) const
+{
+	RichString ret;
+
+	int currentStyle = 0;
+	QRgb currentColor = 0;
+
+	const QChar *str = string.constData();
+	const int end = string.size();
+
+	QString text;
+	text.reserve(end);
+
+	// position of the next '}' - override blocks need at least one character inside braces
+	int closePos = string.indexOf(QChar('}'));
+	int off = 0;
+	while(off < end) {
+		const QChar ch = str[off];
+		if(ch == QChar('\\') && off + 1 < end && (str[off + 1] == QChar('N') || str[off + 1] == QChar('n'))) {
+			text.append(QChar::LineFeed);
+			off += 2;
+			continue;
+		}
+		if(ch != QChar('{') || closePos == -1) {
+			text.append(ch);
+			off++;
+			continue;
+		}
+		if(closePos < off)
+			closePos = string.indexOf(QChar('}'), off);
+		if(closePos == -1 || closePos == off + 1) {
+			text.append(ch);
+			off++;
+			continue;
+		}
+
+		int newStyleFlags = currentStyle;
+		QRgb newColor = currentColor;
+
+		int cmdEnd = off;
+		for(int cmdStart = off + 1; cmdEnd != closePos; cmdStart = cmdEnd + 1) {
+			cmdEnd = cmdStart;
+			while(cmdEnd < closePos && str[cmdEnd] != QChar('\\'))
+				cmdEnd++;
+			const int len = cmdEnd - cmdStart;
+			if(len == 0)
+				continue;
+			const QChar c0 = str[cmdStart];
+			const QChar c1 = len == 2 ? str[cmdStart + 1] : QChar();
+			if(c0 == QChar('i') && c1 == QChar('0')) {
+				newStyleFlags &= ~RichString::Italic;
+			} else if(c0 == QChar('b') && c1 == QChar('0')) {
+				newStyleFlags &= ~RichString::Bold;
+			} else if(c0 == QChar('u') && c1 == QChar('0')) {
+				newStyleFlags &= ~RichString::Underline;
+			} else if(c0 == QChar('i') && c1 == QChar('1')) {
+				newStyleFlags |= RichString::Italic;
+			} else if(c0 == QChar('b')) {
+				// it's usually followed 1, but can be weight of the font: 400, 700, ...
+				newStyleFlags |= RichString::Bold;
+			} else if(c0 == QChar('u') && c1 == QChar('1')) {
+				newStyleFlags |= RichString::Underline;
+			} else if(c0 == QChar('c')) {
+				// "c&HBBGGRR&"
+				QString val = $("000000");
+				if(len > 4)
+					val.append(QStringView(string).mid(cmdStart + 3, len - 4));
+				val = val.right(6);
+				if(val == QLatin1String("000000")) {
+					newStyleFlags &= ~RichString::Color;
+					newColor = 0;
+				} else {
+					newStyleFlags |= RichString::Color;
+					newColor = QColor(QChar('#') % val.mid(4, 2) % val.mid(2, 2) % val.mid(0, 2)).rgb();
+				}
+			}
+		}
+
+		ret.append(RichString(text, currentStyle, currentColor));
+		text.clear();
+
+		currentStyle = newStyleFlags;
+		currentColor = newColor;
+		off = closePos + 1;
+	}
+	ret.append(RichString(text, currentStyle, currentColor));
+
+	return ret;
+}
+
+bool
+SubStationAlphaInputFormat::parseSubtitles(ParsedSubtitle &subtitle, const QString &data) const
+{
+	staticRE$(reScriptInfo, "^ *\\[Script Info\\] *[\r\n]+", REu);
+	if(!reScriptInfo.globalMatch(data).hasNext())
+		return false;
+
+	staticRE$(reStyles, "[\r\n]+ *\\[[vV]4\\+? Styles\\] *[\r\n]+", REu);
+	QRegularExpressionMatchIterator itStyles = reStyles.globalMatch(data);
+	if(!itStyles.hasNext())
+		return false;
+	const int stylesStart = itStyles.next().capturedStart();
+
+	FormatData formatData = createFormatData();
+
+	formatData.setValue($("ScriptInfo"), data.mid(0, stylesStart));
+
+	staticRE$(reEvents, "[\r\n]+ *\\[Events\\] *[\r\n]+", REu);
+	QRegularExpressionMatchIterator itEvents = reEvents.globalMatch(data, stylesStart);
+	if(!itEvents.hasNext())
+		return false;
+	int eventsStart = itEvents.next().capturedStart();
+
+	formatData.setValue($("Styles"), data.mid(stylesStart, eventsStart - stylesStart));
+
+	staticRE$(reFormat, " *Format: *(\\w+,? *)+[\r\n]+", REu);
+	QRegularExpressionMatchIterator itFormat = reFormat.globalMatch(data, eventsStart);
+	if(!itFormat.hasNext())
+		return false;
+
+	subtitle.formatData.reset(new FormatData(formatData));
+	formatData.clear();
+
+	const QChar *str = data.constData();
+	const int end = data.size();
+
+	do {
+		QRegularExpressionMatch mFormat = itFormat.next();
+		const EventFormat fmt = parseEventFormat(mFormat.capturedView(0));
+		const int textField = fmt.fields - 1;
+
+		QVarLengthArray<int, 16> fieldStart(fmt.fields);
+		QVarLengthArray<int, 16> fieldEnd(fmt.fields);
+
+		int off = mFormat.capturedEnd();
+		while(off < end) {
+			const int eol = lineEnd(str, end, off);
+			int pos = skipSpaces(str, end, off);
+			off = eol;
+			while(off < end && str[off] == QChar::LineFeed)
+				off++;
+
+			const int dialogueStart = pos;
+			if(!skipLiteral(str, eol, &pos, QLatin1String("Dialogue:")))
+				continue;
+			pos = skipSpaces(str, eol, pos);
+
+			// split comma separated fields, the last one (Text) can contain commas
+			bool valid = true;
+			for(int i = 0; i < fmt.fields; i++) {
+				if(i)
+					pos = skipSpaces(str, eol, pos);
+				fieldStart[i] = pos;
+				if(i == textField) {
+					fieldEnd[i] = eol;
+					break;
+				}
+				while(pos < eol && str[pos] != QChar(','))
+					pos++;
+				if(pos == eol) {
+					valid = false;
+					break;
+				}
+				fieldEnd[i] = pos++;
+			}
+			if(!valid)
+				continue;
+
+			Time showTime;
+			if(!parseTime(str, fieldEnd[fmt.start], fieldStart[fmt.start], &showTime)) {
+				qWarning() << "SubStationAlpha failed to match showTime";
+				break;
+			}
+			Time hideTime;
+			if(!parseTime(str, fieldEnd[fmt.end], fieldStart[fmt.end], &hideTime)) {
+				qWarning() << "SubStationAlpha failed to match hideTime";
+				break;
+			}
+
+			ParsedLine line;
+			line.showTime = showTime;
+			line.hideTime = hideTime;
+			line.text = toRichString(data.mid(fieldStart[textField], fieldEnd[textField] - fieldStart[textField]));
+
+			// line template for output format with Start, End and Text replaced by %1, %2 and %3
+			std::pair<int, QLatin1String> args[] = {
+				{ fmt.start, QLatin1String("%1") },
+				{ fmt.end, QLatin1String("%2") },
+				{ textField, QLatin1String("%3") },
+			};
+			std::sort(std::begin(args), std::end(args), [](const auto &a, const auto &b){ return a.first < b.first; });
+			QString dialogue;
+			dialogue.reserve(off - dialogueStart + 8);
+			int copied = dialogueStart;
+			for(const auto &arg : args) {
+				dialogue.append(QStringView(data).mid(copied, fieldStart[arg.first] - copied));
+				dialogue.append(arg.second);
+				copied = fieldEnd[arg.first];
+			}
+			dialogue.append(QStringView(data).mid(copied, eol - copied));
+			// preserve trailing line breaks the same way regex substitution did
+			dialogue.append(QChar::LineFeed);
+			dialogue.append(QStringView(data).mid(eol, off - eol));
+
+			formatData.setValue($("Dialogue"), dialogue);
+			line.formatData.reset(new FormatData(formatData));
+
+			subtitle.append(line);
+		}
+	} while(itFormat.hasNext());
+
+	subtitle.flush();
+
+	return true;
+}
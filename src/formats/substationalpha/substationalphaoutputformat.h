@@ -11,7 +11,6 @@
 #include "formats/outputformat.h"
 #include "core/formatdata.h"
 #include "core/richtext/richdocument.h"
-#include "core/subtitleiterator.h"
 
 namespace SubtitleComposer {
 class SubStationAlphaOutputFormat : public OutputFormat
@@ -90,38 +89,35 @@ protected:
 		return data.mid(begin, end - begin + 1) + QStringLiteral("\n\n");
 	}
 
-	QString dumpSubtitles(const Subtitle &subtitle, bool primary) const override
+	void dumpSubtitles(const SubtitleSnapshot &subtitle, bool primary, OutputSink &out) const override
 	{
-		FormatData *formatData = this->formatData(subtitle);
+		const FormatData *formatData = this->formatData(subtitle);
 
-		QString ret = normalizeBlock(formatData ? formatData->value(QStringLiteral("ScriptInfo")) : m_defaultScriptInfo)
+		out << normalizeBlock(formatData ? formatData->value(QStringLiteral("ScriptInfo")) : m_defaultScriptInfo)
 				+ normalizeBlock(formatData ? formatData->value(QStringLiteral("Styles")) : m_defaultStyles)
 				+ normalizeBlock(m_events);
 
-		for(SubtitleIterator it(subtitle); it.current(); ++it) {
-			const SubtitleLine *line = it.current();
-
-			const Time showTime = line->showTime();
+		for(int i = 0, n = subtitle.count(); i < n; i++) {
+			const Time showTime = subtitle.showTime(i);
 			const QString showTimeArg = QString::asprintf("%01d:%02d:%02d.%02d",
 												  showTime.hours(),
 												  showTime.minutes(),
 												  showTime.seconds(),
 												  (showTime.millis() + 5) / 10);
 
-			const Time hideTime = line->hideTime();
+			const Time hideTime = subtitle.hideTime(i);
 			const QString hideTimeArg = QString::asprintf("%01d:%02d:%02d.%02d",
 												  hideTime.hours(),
 												  hideTime.minutes(),
 												  hideTime.seconds(),
 												  (hideTime.millis() + 5) / 10);
 
-			formatData = this->formatData(line);
+			formatData = this->formatData(subtitle, i);
 
-			RichString stext = (primary ? line->primaryDoc() : line->secondaryDoc())->toRichText();
-			ret += QString(formatData ? formatData->value(QStringLiteral("Dialogue")) : m_dialogueBuilder)
+			RichString stext = (primary ? subtitle.primaryText(i) : subtitle.secondaryText(i));
+			out << QString(formatData ? formatData->value(QStringLiteral("Dialogue")) : m_dialogueBuilder)
 					.arg(showTimeArg, hideTimeArg, fromRichString(stext));
 		}
-		return ret;
 	}
 
 	SubStationAlphaOutputFormat(
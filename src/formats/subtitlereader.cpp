@@ -0,0 +1,190 @@
+/*
+    SPDX-FileCopyrightText: 2010-2022 Mladen Milinkovic <max@smoothware.net>
+
+    SPDX-License-Identifier: GPL-2.0-or-later
+*/
+
+#include "subtitlereader.h"
+
+#include "core/subtitle.h"
+#include "core/subtitleline.h"
+#include "formats/inputformat.h"
+
+#include <KLocalizedString>
+
+#include <QBoxLayout>
+#include <QIcon>
+#include <QLabel>
+#include <QMutexLocker>
+#include <QProgressBar>
+#include <QToolButton>
+
+using namespace SubtitleComposer;
+
+SubtitleReader::SubtitleReader(QWidget *parent)
+	: QThread(parent),
+	  m_progressWidget(new QWidget(parent))
+{
+	m_progressWidget->setSizePolicy(QSizePolicy::Fixed, QSizePolicy::Expanding);
+	m_progressWidget->hide();
+
+	QLabel *label = new QLabel(i18n("Opening Subtitle"), m_progressWidget);
+
+	// parsers don't report progress, show busy indicator
+	QProgressBar *progressBar = new QProgressBar(m_progressWidget);
+	progressBar->setRange(0, 0);
+	progressBar->setMinimumWidth(150);
+
+	QToolButton *cancelButton = new QToolButton(m_progressWidget);
+	cancelButton->setIcon(QIcon::fromTheme(QStringLiteral("dialog-cancel")));
+	cancelButton->setToolTip(i18n("Cancel"));
+	cancelButton->setAutoRaise(true);
+	connect(cancelButton, &QToolButton::clicked, this, &SubtitleReader::cancel);
+
+	QBoxLayout *layout = new QBoxLayout(QBoxLayout::LeftToRight, m_progressWidget);
+	layout->setContentsMargins(1, 0, 1, 0);
+	layout->setSpacing(1);
+	layout->addWidget(label);
+	layout->addWidget(progressBar);
+	layout->addWidget(cancelButton);
+
+	connect(this, &QThread::started, m_progressWidget, &QWidget::show);
+	connect(this, &QThread::finished, m_progressWidget, &QWidget::hide);
+
+	// batches are turned into lines on this (GUI) thread, whatever is left is drained before others see finished()
+	connect(this, &SubtitleReader::batchReady, this, &SubtitleReader::onBatchReady, Qt::QueuedConnection);
+	connect(this, &QThread::finished, this, &SubtitleReader::onBatchReady);
+}
+
+SubtitleReader::~SubtitleReader()
+{
+	cancel();
+	wait();
+}
+
+void
+SubtitleReader::read(const QUrl &url, QTextCodec *codec)
+{
+	cancel();
+	wait();
+
+	m_url = url;
+	m_codec = codec;
+	m_cancel.storeRelease(0);
+	m_reading = true;
+	m_status = FormatManager::ERROR;
+
+	m_formatName.clear();
+	m_batches.clear();
+	m_restarted = false;
+	m_header = ParsedSubtitle();
+
+	start(LowPriority);
+}
+
+void
+SubtitleReader::cancel()
+{
+	m_cancel.storeRelease(1);
+}
+
+void
+SubtitleReader::reset()
+{
+	m_reading = false;
+
+	QMutexLocker lock(&m_batchMutex);
+	m_batches.clear();
+	m_header = ParsedSubtitle();
+}
+
+QString
+SubtitleReader::formatName() const
+{
+	QMutexLocker lock(&m_batchMutex);
+	return m_formatName;
+}
+
+void
+SubtitleReader::setSubtitleData(Subtitle &subtitle) const
+{
+	QMutexLocker lock(&m_batchMutex);
+	if(const InputFormat *format = FormatManager::instance().input(m_formatName))
+		format->setSubtitleData(subtitle, m_header);
+}
+
+void
+SubtitleReader::run()
+{
+	// worker only produces plain data, it never touches any subtitle or creates QObjects
+	bool sunk = false;
+	const auto started = [this, &sunk](const QString &formatName){
+		QMutexLocker lock(&m_batchMutex);
+		m_formatName = formatName;
+		if(sunk) {
+			m_batches.clear();
+			m_restarted = true;
+			sunk = false;
+		}
+	};
+
+	ParsedSubtitle subtitle;
+	subtitle.sink = [this, &sunk](ParsedSubtitle &parsed){
+		if(m_cancel.loadAcquire()) {
+			parsed.lines.clear();
+			return;
+		}
+		{
+			QMutexLocker lock(&m_batchMutex);
+			m_batches.append(parsed.lines);
+			m_header.framesPerSecond = parsed.framesPerSecond;
+			m_header.meta = parsed.meta;
+			m_header.stylesheet = parsed.stylesheet;
+			m_header.formatData = parsed.formatData;
+		}
+		parsed.lines.clear();
+		sunk = true;
+		emit batchReady();
+	};
+
+	m_status = FormatManager::instance().parseText(m_url, m_codec, &subtitle, started, &m_cancel);
+	if(m_status != FormatManager::SUCCESS)
+		return;
+
+	// subtitle wide data that follows the last line
+	QMutexLocker lock(&m_batchMutex);
+	m_header.framesPerSecond = subtitle.framesPerSecond;
+	m_header.meta = subtitle.meta;
+	m_header.stylesheet = subtitle.stylesheet;
+	m_header.formatData = subtitle.formatData;
+}
+
+void
+SubtitleReader::onBatchReady()
+{
+	QVector<ParsedLines> batches;
+	bool restarted;
+	const InputFormat *format;
+	{
+		QMutexLocker lock(&m_batchMutex);
+		batches.swap(m_batches);
+		restarted = m_restarted;
+		m_restarted = false;
+		format = FormatManager::instance().input(m_formatName);
+	}
+
+	if(!m_reading || m_cancel.loadAcquire())
+		return;
+
+	if(restarted)
+		emit readRestarted();
+
+	for(const ParsedLines &lines : qAsConst(batches))
+		emit linesRead(format->createLines(lines));
+}
+
+QWidget *
+SubtitleReader::progressWidget()
+{
+	return m_progressWidget;
+}
@@ -0,0 +1,97 @@
+/*
+    SPDX-FileCopyrightText: 2010-2022 Mladen Milinkovic <max@smoothware.net>
+
+    SPDX-License-Identifier: GPL-2.0-or-later
+*/
+
+#ifndef SUBTITLEREADER_H
+#define SUBTITLEREADER_H
+
+#include "formats/formatmanager.h"
+#include "formats/parsedsubtitle.h"
+
+#include <QAtomicInt>
+#include <QList>
+#include <QMutex>
+#include <QThread>
+#include <QUrl>
+#include <QVector>
+
+QT_FORWARD_DECLARE_CLASS(QTextCodec)
+QT_FORWARD_DECLARE_CLASS(QWidget)
+
+namespace SubtitleComposer {
+class Subtitle;
+class SubtitleLine;
+
+/**
+ * @brief Decodes and parses text subtitle file on a worker thread
+ * Parsed lines are handed over as plain data in batches while parsing, SubtitleLines are created
+ * from them on the thread that called read() and emitted with linesRead(), finished() is emitted when done.
+ */
+class SubtitleReader : public QThread
+{
+	Q_OBJECT
+
+public:
+	explicit SubtitleReader(QWidget *parent = nullptr);
+	virtual ~SubtitleReader();
+
+	void read(const QUrl &url, QTextCodec *codec);
+	void cancel();
+
+	inline const QUrl & url() const { return m_url; }
+	inline QTextCodec * codec() const { return m_codec; }
+	inline FormatManager::Status status() const { return m_cancel.loadAcquire() ? FormatManager::CANCEL : m_status; }
+	QString formatName() const;
+	/**
+	 * @brief True from read() until reset(), including the time finished() is waiting in event queue
+	 */
+	inline bool isReading() const { return m_reading; }
+	void reset();
+
+	/**
+	 * @brief Set subtitle wide data (fps, stylesheet, metadata...) parsed so far on @p subtitle
+	 */
+	void setSubtitleData(Subtitle &subtitle) const;
+
+	QWidget * progressWidget();
+
+signals:
+	/**
+	 * @brief Next batch of parsed @p lines in file order
+	 */
+	void linesRead(const QList<SubtitleLine *> &lines);
+	/**
+	 * @brief Parsing failed with the first format and continues with another one, lines read so far are not valid
+	 */
+	void readRestarted();
+	/**
+	 * @brief Internal, worker has queued another batch
+	 */
+	void batchReady();
+
+private:
+	void run() override;
+	void onBatchReady();
+
+private:
+	QUrl m_url;
+	QTextCodec *m_codec = nullptr;
+	QAtomicInt m_cancel;
+	bool m_reading = false;
+
+	FormatManager::Status m_status = FormatManager::ERROR;
+
+	// shared with worker thread
+	mutable QMutex m_batchMutex;
+	QString m_formatName;
+	QVector<ParsedLines> m_batches;
+	bool m_restarted = false;
+	ParsedSubtitle m_header;
+
+	QWidget *m_progressWidget;
+};
+}
+
+#endif // SUBTITLEREADER_H
@@ -0,0 +1,149 @@
+/*
+    SPDX-FileCopyrightText: 2010-2022 Mladen Milinkovic <max@smoothware.net>
+
+    SPDX-License-Identifier: GPL-2.0-or-later
+*/
+
+#include "subtitlewriter.h"
+
+#include <KLocalizedString>
+
+#include <QBoxLayout>
+#include <QIcon>
+#include <QLabel>
+#include <QMutexLocker>
+#include <QProgressBar>
+#include <QToolButton>
+
+#include <algorithm>
+
+using namespace SubtitleComposer;
+
+SubtitleWriter::SubtitleWriter(QWidget *parent)
+	: QThread(parent),
+	  m_progressWidget(new QWidget(parent))
+{
+	m_progressWidget->setSizePolicy(QSizePolicy::Fixed, QSizePolicy::Expanding);
+	m_progressWidget->hide();
+
+	QLabel *label = new QLabel(i18n("Saving Subtitle"), m_progressWidget);
+
+	QProgressBar *progressBar = new QProgressBar(m_progressWidget);
+	progressBar->setRange(0, 0);
+	progressBar->setMinimumWidth(150);
+
+	QToolButton *cancelButton = new QToolButton(m_progressWidget);
+	cancelButton->setIcon(QIcon::fromTheme(QStringLiteral("dialog-cancel")));
+	cancelButton->setToolTip(i18n("Cancel"));
+	cancelButton->setAutoRaise(true);
+	connect(cancelButton, &QToolButton::clicked, this, &SubtitleWriter::cancel);
+
+	QBoxLayout *layout = new QBoxLayout(QBoxLayout::LeftToRight, m_progressWidget);
+	layout->setContentsMargins(1, 0, 1, 0);
+	layout->setSpacing(1);
+	layout->addWidget(label);
+	layout->addWidget(progressBar);
+	layout->addWidget(cancelButton);
+
+	connect(this, &QThread::started, m_progressWidget, &QWidget::show);
+	connect(this, &QThread::finished, m_progressWidget, &QWidget::hide);
+}
+
+SubtitleWriter::~SubtitleWriter()
+{
+	// never drop a save that is in progress
+	wait();
+}
+
+quint64
+SubtitleWriter::write(const SubtitleSnapshot &subtitle, bool primary, const QUrl &url, QTextCodec *codec, const QString &formatName, bool overwrite)
+{
+	QMutexLocker locker(&m_mutex);
+
+	// newer snapshot of the same file replaces older ones
+	for(auto it = m_queue.begin(); it != m_queue.end();) {
+		if(it->url == url) {
+			it->subtitle = SubtitleSnapshot();
+			it->status = FormatManager::CANCEL;
+			m_written.append(*it);
+			it = m_queue.erase(it);
+		} else {
+			++it;
+		}
+	}
+	if(m_runningUrl == url)
+		m_cancel.storeRelease(1);
+
+	const quint64 id = m_nextId++;
+	m_queue.append(Job{id, subtitle, primary, url, codec, formatName, overwrite, FormatManager::ERROR});
+
+	if(!m_running) {
+		m_running = true;
+		locker.unlock();
+		// worker that found the queue empty could still be returning from run()
+		wait();
+		start(LowPriority);
+	}
+	return id;
+}
+
+void
+SubtitleWriter::cancel()
+{
+	QMutexLocker locker(&m_mutex);
+	for(Job &job : m_queue) {
+		job.subtitle = SubtitleSnapshot();
+		job.status = FormatManager::CANCEL;
+		m_written.append(job);
+	}
+	m_queue.clear();
+	m_cancel.storeRelease(1);
+}
+
+void
+SubtitleWriter::finish()
+{
+	wait();
+}
+
+QVector<SubtitleWriter::Job>
+SubtitleWriter::takeWritten()
+{
+	QMutexLocker locker(&m_mutex);
+	QVector<Job> jobs;
+	jobs.swap(m_written);
+	std::sort(jobs.begin(), jobs.end(), [](const Job &a, const Job &b){ return a.id < b.id; });
+	return jobs;
+}
+
+void
+SubtitleWriter::run()
+{
+	QMutexLocker locker(&m_mutex);
+	while(!m_queue.isEmpty()) {
+		Job job = m_queue.takeFirst();
+		m_runningUrl = job.url;
+		m_cancel.storeRelease(0);
+		locker.unlock();
+
+		if(FormatManager::instance().writeSubtitle(job.subtitle, job.primary, job.url, job.codec, job.formatName, job.overwrite, &m_cancel))
+			job.status = FormatManager::SUCCESS;
+		else
+			job.status = m_cancel.loadAcquire() ? FormatManager::CANCEL : FormatManager::ERROR;
+		job.subtitle = SubtitleSnapshot();
+
+		locker.relock();
+		m_runningUrl.clear();
+		m_written.append(job);
+		locker.unlock();
+		emit written();
+		locker.relock();
+	}
+	m_running = false;
+}
+
+QWidget *
+SubtitleWriter::progressWidget()
+{
+	return m_progressWidget;
+}
@@ -0,0 +1,85 @@
+/*
+    SPDX-FileCopyrightText: 2010-2022 Mladen Milinkovic <max@smoothware.net>
+
+    SPDX-License-Identifier: GPL-2.0-or-later
+*/
+
+#ifndef SUBTITLEWRITER_H
+#define SUBTITLEWRITER_H
+
+#include "core/subtitlesnapshot.h"
+#include "formats/formatmanager.h"
+
+#include <QAtomicInt>
+#include <QMutex>
+#include <QThread>
+#include <QUrl>
+#include <QVector>
+
+QT_FORWARD_DECLARE_CLASS(QTextCodec)
+QT_FORWARD_DECLARE_CLASS(QWidget)
+
+namespace SubtitleComposer {
+/**
+ * @brief Writes subtitle snapshots to files on a worker thread
+ * Writes are queued and done one after another, subtitle can be edited meanwhile.
+ * written() is emitted after each one is done, results are collected with takeWritten().
+ */
+class SubtitleWriter : public QThread
+{
+	Q_OBJECT
+
+public:
+	struct Job {
+		quint64 id;
+		SubtitleSnapshot subtitle;
+		bool primary;
+		QUrl url;
+		QTextCodec *codec;
+		QString formatName;
+		bool overwrite;
+		FormatManager::Status status;
+	};
+
+	explicit SubtitleWriter(QWidget *parent = nullptr);
+	virtual ~SubtitleWriter();
+
+	/**
+	 * @brief Queue @p subtitle to be written to @p url
+	 * Queued write to the same file is dropped and a running one is cancelled, both end up as CANCEL.
+	 * @return id of the write, it's never 0
+	 */
+	quint64 write(const SubtitleSnapshot &subtitle, bool primary, const QUrl &url, QTextCodec *codec, const QString &formatName, bool overwrite = true);
+	void cancel();
+	/**
+	 * @brief Block until all queued writes are done - only for closing and quitting
+	 */
+	void finish();
+
+	/**
+	 * @brief Writes done since last call in the order they were queued, snapshots are already released
+	 */
+	QVector<Job> takeWritten();
+
+	QWidget * progressWidget();
+
+signals:
+	void written();
+
+private:
+	void run() override;
+
+private:
+	QMutex m_mutex;
+	QVector<Job> m_queue;
+	QVector<Job> m_written;
+	QUrl m_runningUrl;
+	bool m_running = false;
+	quint64 m_nextId = 1;
+	QAtomicInt m_cancel;
+
+	QWidget *m_progressWidget;
+};
+}
+
+#endif // SUBTITLEWRITER_H
@@ -24,7 +24,13 @@ protected:
 		: InputFormat($("SubViewer 1.0"), QStringList($("sub")))
 	{}
 
-	bool parseSubtitles(Subtitle &subtitle, const QString &data) const override
+	int probe(const QString &sample) const override
+	{
+		staticRE$(reCue, "(?:^|\n)\\[[0-2][0-9]:[0-5][0-9]:[0-5][0-9]\\]\\n", REu);
+		return probeCues(reCue, sample, 75);
+	}
+
+	bool parseSubtitles(ParsedSubtitle &subtitle, const QString &data) const override
 	{
 		staticRE$(reTime, "\\[([0-2][0-9]):([0-5][0-9]):([0-5][0-9])\\]\\n([^\n]*)\\n", REu);
 		QRegularExpressionMatchIterator itTime = reTime.globalMatch(data);
@@ -43,13 +49,16 @@ protected:
 
 			const Time hideTime(mTime.captured(1).toInt(), mTime.captured(2).toInt(), mTime.captured(3).toInt(), 0);
 
-			SubtitleLine *l = new SubtitleLine(showTime, hideTime);
-			l->primaryDoc()->setPlainText(text);
-			subtitle.insertLine(l);
-
+			ParsedLine line;
+			line.showTime = showTime;
+			line.hideTime = hideTime;
+			line.text = RichString(text);
+			subtitle.append(line);
 		}
 
-		return subtitle.count() > 0;
+		subtitle.flush();
+
+		return subtitle.lineCount > 0;
 	}
 };
 }
@@ -10,7 +10,6 @@
 
 #include "formats/outputformat.h"
 #include "core/richtext/richdocument.h"
-#include "core/subtitleiterator.h"
 
 namespace SubtitleComposer {
 class SubViewer1OutputFormat : public OutputFormat
@@ -18,25 +17,21 @@ class SubViewer1OutputFormat : public OutputFormat
 	friend class FormatManager;
 
 protected:
-	QString dumpSubtitles(const Subtitle &subtitle, bool primary) const override
+	void dumpSubtitles(const SubtitleSnapshot &subtitle, bool primary, OutputSink &out) const override
 	{
-		QString ret(QStringLiteral("[TITLE]\n\n[AUTHOR]\n\n[SOURCE]\n\n[PRG]\n\n[FILEPATH]\n\n[DELAY]\n0\n[CD TRACK]\n0\n[BEGIN]\n" "******** START SCRIPT ********\n"));
+		out << QStringLiteral("[TITLE]\n\n[AUTHOR]\n\n[SOURCE]\n\n[PRG]\n\n[FILEPATH]\n\n[DELAY]\n0\n[CD TRACK]\n0\n[BEGIN]\n" "******** START SCRIPT ********\n");
 
-		for(SubtitleIterator it(subtitle); it.current(); ++it) {
-			const SubtitleLine *line = it.current();
+		for(int i = 0, n = subtitle.count(); i < n; i++) {
+			Time showTime = subtitle.showTime(i);
+			out << QString::asprintf("[%02d:%02d:%02d]\n", showTime.hours(), showTime.minutes(), showTime.seconds());
 
-			Time showTime = line->showTime();
-			ret += QString::asprintf("[%02d:%02d:%02d]\n", showTime.hours(), showTime.minutes(), showTime.seconds());
+			QString text = subtitle.plainText(i, primary);
+			out << text.replace('\n', '|');
 
-			QString text = (primary ? line->primaryDoc() : line->secondaryDoc())->toPlainText();
-			ret += text.replace('\n', '|');
-
-			Time hideTime = line->hideTime();
-			ret += QString::asprintf("\n[%02d:%02d:%02d]\n\n", hideTime.hours(), hideTime.minutes(), hideTime.seconds());
+			Time hideTime = subtitle.hideTime(i);
+			out << QString::asprintf("\n[%02d:%02d:%02d]\n\n", hideTime.hours(), hideTime.minutes(), hideTime.seconds());
 		}
-		ret += "[END]\n" "******** END SCRIPT ********\n";
-
-		return ret;
+		out << "[END]\n" "******** END SCRIPT ********\n";
 	}
 
 	SubViewer1OutputFormat() :
@@ -24,7 +24,13 @@ protected:
 		: InputFormat($("SubViewer 2.0"), QStringList($("sub")))
 	{}
 
-	bool parseSubtitles(Subtitle &subtitle, const QString &data) const override
+	int probe(const QString &sample) const override
+	{
+		staticRE$(reCue, "(?:^|\n)[0-2][0-9]:[0-5][0-9]:[0-5][0-9]\\.[0-9][0-9],[0-2][0-9]:[0-5][0-9]:[0-5][0-9]\\.[0-9][0-9]\\n", REu);
+		return probeCues(reCue, sample, 85);
+	}
+
+	bool parseSubtitles(ParsedSubtitle &subtitle, const QString &data) const override
 	{
 		staticRE$(reLine,
 				"([0-2][0-9]):([0-5][0-9]):([0-5][0-9])\\.([0-9][0-9]),"
@@ -56,13 +62,16 @@ protected:
 					styleFlags |= RichString::Underline;
 			}
 
-			SubtitleLine *l = new SubtitleLine(showTime, hideTime);
-			l->primaryDoc()->setRichText(RichString(text, styleFlags), true);
-			subtitle.insertLine(l);
-
+			ParsedLine line;
+			line.showTime = showTime;
+			line.hideTime = hideTime;
+			line.text = RichString(text, styleFlags);
+			subtitle.append(line);
 		} while(itLine.hasNext());
 
-		return subtitle.count() > 0;
+		subtitle.flush();
+
+		return subtitle.lineCount > 0;
 	}
 };
 }
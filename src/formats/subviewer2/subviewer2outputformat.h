@@ -10,7 +10,6 @@
 
 #include "formats/outputformat.h"
 #include "core/richtext/richdocument.h"
-#include "core/subtitleiterator.h"
 
 namespace SubtitleComposer {
 class SubViewer2OutputFormat : public OutputFormat
@@ -18,24 +17,21 @@ class SubViewer2OutputFormat : public OutputFormat
 	friend class FormatManager;
 
 protected:
-	QString dumpSubtitles(const Subtitle &subtitle, bool primary) const override
+	void dumpSubtitles(const SubtitleSnapshot &subtitle, bool primary, OutputSink &out) const override
 	{
-		QString ret(QStringLiteral("[INFORMATION]\n[TITLE]\n[AUTHOR]\n[SOURCE]\n[PRG]\n[FILEPATH]\n[DELAY]0\n[CD TRACK]0\n" "[COMMENT]\n[END INFORMATION]\n[SUBTITLE]\n[COLF]&HFFFFFF,[STYLE]bd,[SIZE]24,[FONT]Tahoma\n"));
+		out << QStringLiteral("[INFORMATION]\n[TITLE]\n[AUTHOR]\n[SOURCE]\n[PRG]\n[FILEPATH]\n[DELAY]0\n[CD TRACK]0\n" "[COMMENT]\n[END INFORMATION]\n[SUBTITLE]\n[COLF]&HFFFFFF,[STYLE]bd,[SIZE]24,[FONT]Tahoma\n");
 
-		for(SubtitleIterator it(subtitle); it.current(); ++it) {
-			const SubtitleLine *line = it.current();
+		for(int i = 0, n = subtitle.count(); i < n; i++) {
+			Time showTime = subtitle.showTime(i);
+			Time hideTime = subtitle.hideTime(i);
+			out << QString::asprintf("%02d:%02d:%02d.%02d,%02d:%02d:%02d.%02d\n", showTime.hours(), showTime.minutes(), showTime.seconds(), (showTime.millis() + 5) / 10, hideTime.hours(), hideTime.minutes(), hideTime.seconds(), (hideTime.millis() + 5) / 10);
 
-			Time showTime = line->showTime();
-			Time hideTime = line->hideTime();
-			ret += QString::asprintf("%02d:%02d:%02d.%02d,%02d:%02d:%02d.%02d\n", showTime.hours(), showTime.minutes(), showTime.seconds(), (showTime.millis() + 5) / 10, hideTime.hours(), hideTime.minutes(), hideTime.seconds(), (hideTime.millis() + 5) / 10);
+			const RichString text = (primary ? subtitle.primaryText(i) : subtitle.secondaryText(i));
+			out << m_stylesMap[text.cummulativeStyleFlags()];
+			out << text.string().replace("\n", "[br]");
 
-			const RichString text = (primary ? line->primaryDoc() : line->secondaryDoc())->toRichText();
-			ret += m_stylesMap[text.cummulativeStyleFlags()];
-			ret += text.string().replace("\n", "[br]");
-
-			ret += QStringLiteral("\n\n");
+			out << QStringLiteral("\n\n");
 		}
-		return ret;
 	}
 
 	SubViewer2OutputFormat() :
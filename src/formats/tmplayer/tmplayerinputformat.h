@@ -32,7 +32,12 @@ protected:
 							  $("([0-2]?[0-9]):([0-5][0-9]):([0-5][0-9]):([^\n]*)\n?"))
 	{}
 
-	bool parseSubtitles(Subtitle &subtitle, const QString &data) const override
+	int probe(const QString &sample) const override
+	{
+		return probeCues(m_reTime, sample, 70);
+	}
+
+	bool parseSubtitles(ParsedSubtitle &subtitle, const QString &data) const override
 	{
 		QRegularExpressionMatchIterator itTime = m_reTime.globalMatch(data);
 		if(!itTime.hasNext())
@@ -57,12 +62,16 @@ protected:
 				hideTime = showTime + 2000;
 			}
 
-			SubtitleLine *l = new SubtitleLine(showTime, hideTime);
-			l->primaryDoc()->setPlainText(text);
-			subtitle.insertLine(l);
+			ParsedLine line;
+			line.showTime = showTime;
+			line.hideTime = hideTime;
+			line.text = RichString(text);
+			subtitle.append(line);
 		} while(itTime.hasNext());
 
-		return subtitle.count() > 0;
+		subtitle.flush();
+
+		return subtitle.lineCount > 0;
 	}
 
 	QRegularExpression m_reTime;
@@ -10,7 +10,6 @@
 
 #include "formats/outputformat.h"
 #include "core/richtext/richdocument.h"
-#include "core/subtitleiterator.h"
 
 namespace SubtitleComposer {
 class TMPlayerOutputFormat : public OutputFormat
@@ -18,28 +17,23 @@ class TMPlayerOutputFormat : public OutputFormat
 	friend class FormatManager;
 
 protected:
-	QString dumpSubtitles(const Subtitle &subtitle, bool primary) const override
+	void dumpSubtitles(const SubtitleSnapshot &subtitle, bool primary, OutputSink &out) const override
 	{
-		QString ret;
+		for(int i = 0, n = subtitle.count(); i < n; i++) {
+			Time showTime = subtitle.showTime(i);
+			out << QString::asprintf(m_timeFormat, showTime.hours(), showTime.minutes(), showTime.seconds());
 
-		for(SubtitleIterator it(subtitle); it.current(); ++it) {
-			const SubtitleLine *line = it.current();
-
-			Time showTime = line->showTime();
-			ret += QString::asprintf(m_timeFormat, showTime.hours(), showTime.minutes(), showTime.seconds());
-
-			QString text = (primary ? line->primaryDoc() : line->secondaryDoc())->toPlainText();
-			ret += text.replace('\n', '|');
-			ret += '\n';
+			QString text = subtitle.plainText(i, primary);
+			out << text.replace('\n', '|');
+			out << '\n';
 
 			// We behave like Subtitle Workshop here: to compensate for the lack of hide time
 			// indication provisions in the format we add an empty line with the hide time.
-			Time hideTime = line->hideTime();
-			ret += QString::asprintf(m_timeFormat, hideTime.hours(), hideTime.minutes(), hideTime.seconds());
+			Time hideTime = subtitle.hideTime(i);
+			out << QString::asprintf(m_timeFormat, hideTime.hours(), hideTime.minutes(), hideTime.seconds());
 
-			ret += '\n';
+			out << '\n';
 		}
-		return ret;
 	}
 
 	TMPlayerOutputFormat() :
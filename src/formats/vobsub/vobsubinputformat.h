@@ -26,6 +26,7 @@ class VobSubInputFormat : public InputFormat
 
 public:
 	bool isBinary() const override { return true; }
+	int probe(const QString &) const override { return 0; }
 
 	FormatManager::Status readBinary(Subtitle &subtitle, const QUrl &url) override
 	{
@@ -82,7 +83,7 @@ public:
 		quint32 ppFlags = dlgInit.postProcessingFlags();
 		for(int i = 0, n = subtitle.count(); i < n; i++) {
 			SubtitleLine *line = subtitle.at(i);
-			RichString text = line->primaryDoc()->toRichText();
+			RichString text = line->primaryText();
 			if(ppFlags & VobSubInputInitDialog::APOSTROPHE_TO_QUOTES)
 				text
 					.replace(QRegularExpression(QStringLiteral("(?:"
@@ -147,7 +148,7 @@ public:
 
 			// cleanup whitespace
 			text.replace(QRegularExpression(QStringLiteral("(?: *(?=\\n)|(?<=\\n) *|^ *| *$| *(?= )|(?<= ) *)")), QStringLiteral(""));
-			line->primaryDoc()->setRichText(text, true);
+			line->resetPrimaryText(text);
 		}
 
 		// restore original subtitle
@@ -157,7 +158,7 @@ public:
 	}
 
 protected:
-	bool parseSubtitles(Subtitle &, const QString &) const override
+	bool parseSubtitles(ParsedSubtitle &, const QString &) const override
 	{
 		return false;
 	}
@@ -69,8 +69,8 @@ skipChar(QStringView_ text, int off, const charCompare &cf)
 	return it - text.cbegin();
 }
 
-void
-parseCueSettings(SubtitleLine *line, QStringView_ css)
+SubtitleRect
+parseCueSettings(QStringView_ css)
 {
 	// https://developer.mozilla.org/en-US/docs/Web/API/WebVTT_API#cue_settings
 	QMap<QByteArray, QStringView_> settings;
@@ -209,25 +209,46 @@ parseCueSettings(SubtitleLine *line, QStringView_ css)
 		}
 	}
 
-	line->setPosition(p);
+	return p;
+}
+
+/**
+ * @return offset right after "WEBVTT" signature, skipping leading BOM and whitespace; -1 if there is none
+ */
+static int
+headerEnd(const QString &data)
+{
+	int off = 0;
+	while(off < data.length() && (data.at(off) == QChar::ByteOrderMark || data.at(off).isSpace()))
+		off++;
+	if(QStringView(data).mid(off, 6) != $("WEBVTT"))
+		return -1;
+	return off + 6;
+}
+
+int
+WebVTTInputFormat::probe(const QString &sample) const
+{
+	return headerEnd(sample) < 0 ? 0 : 100;
 }
 
 bool
-WebVTTInputFormat::parseSubtitles(Subtitle &subtitle, const QString &data) const
+WebVTTInputFormat::parseSubtitles(ParsedSubtitle &subtitle, const QString &data) const
 {
-	if(!data.startsWith($("WEBVTT")))
+	const int hdrEnd = headerEnd(data);
+	if(hdrEnd < 0)
 		return false;
 
-	int off = skipTextBlock(data, 6);
+	int off = skipTextBlock(data, hdrEnd);
 	int end;
-	const QStringView_ hdr = QStringView(data).mid(6, off - 6).trimmed();
+	const QStringView_ hdr = QStringView(data).mid(hdrEnd, off - hdrEnd).trimmed();
 	if(!hdr.isEmpty())
-		subtitle.meta("comment.intro.0", hdr.toString());
+		subtitle.meta.insert("comment.intro.0", hdr.toString());
 
 	QVector<QStringView_> notes;
 	staticRE$(reTime, "(?:([0-9]{2,}):)?([0-5][0-9]):([0-5][0-9])\\.([0-9]{3}) --> (?:([0-9]{2,}):)?([0-5][0-9]):([0-5][0-9])\\.([0-9]{3})\\b([^\\n]*)", REu);
 
-	subtitle.stylesheetClear();
+	subtitle.stylesheet.clear();
 
 	// https://w3c.github.io/webvtt/
 	while(off < data.length()) {
@@ -235,12 +256,12 @@ WebVTTInputFormat::parseSubtitles(Subtitle &subtitle, const QString &data) const
 			if(!notes.isEmpty()) { // store note before style
 				int noteId = 0;
 				for(const QStringView_ &note: notes)
-					subtitle.meta(QByteArray("comment.top.") + QByteArray::number(noteId++), note.toString());
+					subtitle.meta.insert(QByteArray("comment.top.") + QByteArray::number(noteId++), note.toString());
 				notes.clear();
 			}
 			// NOTE: styles can't appear after first cue/line, even if we're not forbidding it
 			end = skipTextBlock(data, off += 5);
-			subtitle.stylesheetAppend(QStringView(data).mid(off, end - off).trimmed().toString());
+			subtitle.stylesheet.append(QStringView(data).mid(off, end - off).trimmed().toString());
 			off = end;
 			continue;
 		}
@@ -276,14 +297,14 @@ WebVTTInputFormat::parseSubtitles(Subtitle &subtitle, const QString &data) const
 		const QStringView_ cueText = QStringView(data).mid(off, end - off).trimmed();
 		off = end;
 
-		SubtitleLine *line = new SubtitleLine(showTime, hideTime);
-		RichString stext;
+		ParsedLine line;
+		line.showTime = showTime;
+		line.hideTime = hideTime;
 		// TODO: handle voice/class tags
 		// https://developer.mozilla.org/en-US/docs/Web/API/WebVTT_API#cue_payload_text_tags
 		// TODO: handle pseudo classes
 		// https://developer.mozilla.org/en-US/docs/Web/API/WebVTT_API#css_pseudo-classes
-		stext.setRichString(cueText.toString());
-		line->primaryDoc()->setRichText(stext, true);
+		line.text.setRichString(cueText.toString());
 
 		if(!notes.isEmpty()) {
 			QString comment;
@@ -293,19 +314,21 @@ WebVTTInputFormat::parseSubtitles(Subtitle &subtitle, const QString &data) const
 				comment.append(note);
 			}
 			notes.clear();
-			line->meta("comment", comment);
+			line.meta.insert("comment", comment);
 		}
 		if(!cueSettings.isEmpty())
-			parseCueSettings(line, cueSettings);
+			line.position = parseCueSettings(cueSettings);
 		if(!cueId.isEmpty())
-			line->meta("id", cueId.toString());
-		subtitle.insertLine(line);
+			line.meta.insert("id", cueId.toString());
+		subtitle.append(line);
 	}
 
+	subtitle.flush();
+
 	if(!notes.isEmpty()) {
 		int noteId = 0;
 		for(const QStringView_ &note: notes)
-			subtitle.meta(QByteArray("comment.bottom.") + QByteArray::number(noteId++), note.toString());
+			subtitle.meta.insert(QByteArray("comment.bottom.") + QByteArray::number(noteId++), note.toString());
 		notes.clear();
 	}
 
@@ -15,7 +15,8 @@ class WebVTTInputFormat : public InputFormat
 	friend class FormatManager;
 
 protected:
-	bool parseSubtitles(Subtitle &subtitle, const QString &data) const override;
+	int probe(const QString &sample) const override;
+	bool parseSubtitles(ParsedSubtitle &subtitle, const QString &data) const override;
 
 	WebVTTInputFormat();
 };
@@ -24,7 +24,13 @@ protected:
 		: InputFormat($("YouTube Captions"), QStringList($("sbv")))
 	{}
 
-	bool parseSubtitles(Subtitle &subtitle, const QString &data) const override
+	int probe(const QString &sample) const override
+	{
+		staticRE$(reCue, "(?:^|\n)\\d+:[0-5][0-9]:[0-5][0-9][,\\.][0-9][0-9][0-9],\\d+:[0-5][0-9]:[0-5][0-9][,\\.][0-9][0-9][0-9]\\n", REu);
+		return probeCues(reCue, sample, 85);
+	}
+
+	bool parseSubtitles(ParsedSubtitle &subtitle, const QString &data) const override
 	{
 		staticRE$(reTime,
 			"([\\d]+\\n)?"
@@ -45,12 +51,16 @@ protected:
 			// TODO does the format actually support styled text?
 			// if so, does it use standard HTML style tags?
 
-			SubtitleLine *l = new SubtitleLine(showTime, hideTime);
-			l->primaryDoc()->setHtml(text, true);
-			subtitle.insertLine(l);
+			ParsedLine line;
+			line.showTime = showTime;
+			line.hideTime = hideTime;
+			line.text.setRichString(text);
+			subtitle.append(line);
 		} while(it.hasNext());
 
-		return subtitle.count() > 0;
+		subtitle.flush();
+
+		return subtitle.lineCount > 0;
 	}
 };
 }
@@ -9,7 +9,6 @@
 #define YOUTUBECAPTIONSOUTPUTFORMAT_H
 
 #include "core/richtext/richdocument.h"
-#include "core/subtitleiterator.h"
 #include "formats/outputformat.h"
 #include "helpers/common.h"
 
@@ -19,27 +18,23 @@ class YouTubeCaptionsOutputFormat : public OutputFormat
 	friend class FormatManager;
 
 protected:
-	QString dumpSubtitles(const Subtitle &subtitle, bool primary) const override
+	void dumpSubtitles(const SubtitleSnapshot &subtitle, bool primary, OutputSink &out) const override
 	{
-		QString ret;
-
-		for(SubtitleIterator it(subtitle); it.current(); ++it) {
-			const SubtitleLine *ln = it.current();
-			const Time ts = ln->showTime();
-			const Time th = ln->hideTime();
-			ret += QString::asprintf("%d:%02d:%02d.%03d,%d:%02d:%02d.%03d\n",
+		for(int i = 0, n = subtitle.count(); i < n; i++) {
+			const Time ts = subtitle.showTime(i);
+			const Time th = subtitle.hideTime(i);
+			out << QString::asprintf("%d:%02d:%02d.%03d,%d:%02d:%02d.%03d\n",
 				ts.hours(), ts.minutes(), ts.seconds(), ts.millis(),
 				th.hours(), th.minutes(), th.seconds(), th.millis());
 
-			const RichString text = (primary ? ln->primaryDoc() : ln->secondaryDoc())->toRichText();
+			const RichString text = (primary ? subtitle.primaryText(i) : subtitle.secondaryText(i));
 
 			// TODO does the format actually supports styled text?
 			// if so, does it use standard HTML style tags?
-			ret += text.richString();
+			out << text.richString();
 
-			ret += $("\n\n");
+			out << $("\n\n");
 		}
-		return ret;
 	}
 
 	YouTubeCaptionsOutputFormat()
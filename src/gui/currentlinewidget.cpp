@@ -380,14 +380,17 @@ CurrentLineWidget::saveConfig()
 void
 CurrentLineWidget::setSubtitle(Subtitle *subtitle)
 {
-	if(m_subtitle)
+	if(m_subtitle) {
 		disconnect(m_subtitle.constData(), &Subtitle::lineAnchorChanged, this, &CurrentLineWidget::onLineAnchorChanged);
+		disconnect(m_subtitle.constData(), &Subtitle::linesTimesChanged, this, &CurrentLineWidget::onLinesTimesChanged);
+	}
 
 	m_subtitle = subtitle;
 
-	if(subtitle)
+	if(subtitle) {
 		connect(m_subtitle.constData(), &Subtitle::lineAnchorChanged, this, &CurrentLineWidget::onLineAnchorChanged);
-	else
+		connect(m_subtitle.constData(), &Subtitle::linesTimesChanged, this, &CurrentLineWidget::onLinesTimesChanged);
+	} else
 		setCurrentLine(nullptr);
 }
 
@@ -419,6 +422,7 @@ CurrentLineWidget::setCurrentLine(SubtitleLine *line)
 		if(m_textEdits[0]->isReadOnly())
 			m_textEdits[0]->setReadOnly(false);
 		doc->setDefaultFont(QFont());
+		m_textDocs[0] = RichDocumentPtr(doc);
 		m_textEdits[0]->setDocument(doc);
 		connect(m_currentLine, &SubtitleLine::primaryTextChanged, this, &CurrentLineWidget::updateLabels);
 
@@ -426,6 +430,7 @@ CurrentLineWidget::setCurrentLine(SubtitleLine *line)
 		if(m_textEdits[1]->isReadOnly())
 			m_textEdits[1]->setReadOnly(false);
 		doc->setDefaultFont(QFont());
+		m_textDocs[1] = RichDocumentPtr(doc);
 		m_textEdits[1]->setDocument(doc);
 		connect(m_currentLine, &SubtitleLine::secondaryTextChanged, this, &CurrentLineWidget::updateLabels);
 
@@ -443,6 +448,7 @@ CurrentLineWidget::setCurrentLine(SubtitleLine *line)
 		m_textLabels[1]->setText(i18n("No current line"));
 		m_textEdits[1]->setDocument(&m_blankDoc);
 		m_textEdits[1]->setReadOnly(true);
+		m_textDocs[0] = m_textDocs[1] = RichDocumentPtr();
 		onLineTimesChanged(Time(), Time());
 
 		setEnabled(false);
@@ -557,6 +563,17 @@ CurrentLineWidget::onLineTimesChanged(const Time &showTime, const Time &hideTime
 	updateLabels();
 }
 
+void
+CurrentLineWidget::onLinesTimesChanged(int firstIndex, int lastIndex)
+{
+	if(!m_currentLine)
+		return;
+	const int index = m_currentLine->index();
+	if(index < firstIndex || index > lastIndex)
+		return;
+	onLineTimesChanged(m_currentLine->showTime(), m_currentLine->hideTime());
+}
+
 void
 CurrentLineWidget::onLineShowTimeChanged(const Time &showTime)
 {
@@ -10,6 +10,7 @@
 
 #include "core/subtitle.h"
 #include "core/subtitleline.h"
+#include "core/richtext/richdocumentptr.h"
 
 #include <QExplicitlySharedDataPointer>
 #include <QHBoxLayout>
@@ -57,6 +58,7 @@ private:
 	void onLineTimesChanged(const Time &showTime, const Time &hideTime);
 	void onLineShowTimeChanged(const Time &showTime);
 	void onLineHideTimeChanged(const Time &hideTime);
+	void onLinesTimesChanged(int firstIndex, int lastIndex);
 
 	void onConfigChanged();
 
@@ -83,6 +85,7 @@ private:
 	QWidget *m_boxPrimary = nullptr;
 	QWidget *m_boxTranslation = nullptr;
 	SimpleRichTextEdit *m_textEdits[2] = {};
+	RichDocumentPtr m_textDocs[2];
 	QLabel *m_textLabels[2] = {};
 };
 }
@@ -11,6 +11,7 @@
 #include "core/time.h"
 #include "core/subtitle.h"
 #include "core/subtitleline.h"
+#include "core/richtext/richdocumentptr.h"
 
 #include <QExplicitlySharedDataPointer>
 #include <QPoint>
@@ -105,8 +106,7 @@ private:
 	bool m_translationMode;
 	bool m_showTranslation;
 	QPointer<SubtitleLine> m_playingLine;
-	QPointer<SubtitleLine> m_prevLine;
-	QPointer<SubtitleLine> m_nextLine;
+	RichDocumentPtr m_playingDoc;
 
 	QPointer<const SubtitleLine> m_pauseAfterPlayingLine;
 
@@ -7,12 +7,14 @@
 
 #include "linesitemdelegate.h"
 #include "gui/treeview/lineswidget.h"
-#include "gui/treeview/richdocumentptr.h"
+#include "core/richtext/richdocumentptr.h"
 #include "gui/treeview/richlineedit.h"
 
+#include <QAbstractItemModel>
 #include <QApplication>
 #include <QKeyEvent>
 #include <QPainter>
+#include <QTextLayout>
 #include <QTextOption>
 #include <QTextBlock>
 
@@ -23,7 +25,8 @@
 using namespace SubtitleComposer;
 
 LinesItemDelegate::LinesItemDelegate(LinesWidget *parent)
-	: QStyledItemDelegate(parent)
+	: QStyledItemDelegate(parent),
+	  m_rowCache(500)
 {
 }
 
@@ -31,6 +34,45 @@ LinesItemDelegate::~LinesItemDelegate()
 {
 }
 
+LinesItemDelegate::RowLayout::~RowLayout()
+{
+	qDeleteAll(layouts);
+}
+
+void
+LinesItemDelegate::setModel(const QAbstractItemModel *model)
+{
+	m_rowCache.clear();
+
+	connect(model, &QAbstractItemModel::dataChanged, this, &LinesItemDelegate::invalidateRows);
+	connect(model, &QAbstractItemModel::rowsInserted, this, [this](){ m_rowCache.clear(); });
+	connect(model, &QAbstractItemModel::rowsRemoved, this, [this](){ m_rowCache.clear(); });
+	connect(model, &QAbstractItemModel::rowsMoved, this, [this](){ m_rowCache.clear(); });
+	connect(model, &QAbstractItemModel::modelReset, this, [this](){ m_rowCache.clear(); });
+	connect(model, &QAbstractItemModel::layoutChanged, this, [this](){ m_rowCache.clear(); });
+}
+
+inline static quint64 rowKey(int row, int column) { return quint64(quint32(row)) << 32 | quint32(column); }
+
+void
+LinesItemDelegate::invalidateRows(const QModelIndex &topLeft, const QModelIndex &bottomRight)
+{
+	const int firstColumn = qMax(topLeft.column(), int(LinesModel::Text));
+	const int lastColumn = bottomRight.column();
+	if(firstColumn > lastColumn)
+		return;
+
+	if(bottomRight.row() - topLeft.row() >= m_rowCache.maxCost()) {
+		m_rowCache.clear();
+		return;
+	}
+
+	for(int row = topLeft.row(); row <= bottomRight.row(); row++) {
+		for(int column = firstColumn; column <= lastColumn; column++)
+			m_rowCache.remove(rowKey(row, column));
+	}
+}
+
 bool
 LinesItemDelegate::eventFilter(QObject *object, QEvent *event)
 {
@@ -162,41 +204,38 @@ drawTextPrimitive(QPainter *painter, const QStyle *style, const QStyleOptionView
 	painter->drawText(textRect, alignment, text);
 }
 
-static void
-drawRichText(QPainter *painter, const QStyleOptionViewItem &option, const QRect &rect)
+const LinesItemDelegate::RowLayout *
+LinesItemDelegate::rowLayout(const QStyleOptionViewItem &option, const RichDocument *doc, const QRect &textRect) const
 {
-	painter->setRenderHints(QPainter::Antialiasing | QPainter::TextAntialiasing | QPainter::SmoothPixmapTransform);
+	const Qt::Alignment alignment = QStyle::visualAlignment(option.direction, option.displayAlignment);
+	const quint64 key = rowKey(option.index.row(), option.index.column());
 
-	const RichDocument *doc = option.index.data(Qt::DisplayRole).value<RichDocumentPtr>();
-	RichDocumentLayout *docLayout = doc->documentLayout();
+	// layout doesn't depend on available width, lines are positioned by their natural width
+	RowLayout *rl = m_rowCache.object(key);
+	if(rl && rl->serial == doc->serial() && rl->revision == doc->revision() && rl->font == option.font
+	&& rl->height == textRect.height() && rl->alignment == alignment && rl->direction == option.direction)
+		return rl;
 
-	QPalette::ColorGroup cg = option.state & QStyle::State_Enabled ? QPalette::Normal : QPalette::Disabled;
-	if(cg == QPalette::Normal && !(option.state & QStyle::State_Active))
-		cg = QPalette::Inactive;
-	painter->setPen(option.palette.color(cg, (option.state & QStyle::State_Selected) ? QPalette::HighlightedText : QPalette::Text));
+	rl = new RowLayout{doc->serial(), doc->revision(), option.font, textRect.height(), alignment, option.direction, {}};
 
-	const QStyle *style = option.widget ? option.widget->style() : QApplication::style();
-	int textMargin = style->pixelMetric(QStyle::PM_FocusFrameHMargin, nullptr, option.widget) + 1;
+	RichDocumentLayout *docLayout = doc->documentLayout();
 
 	QTextOption textOption;
-	textOption.setAlignment(QStyle::visualAlignment(option.direction, option.displayAlignment));
+	textOption.setAlignment(alignment);
 	textOption.setFlags(QTextOption::IncludeTrailingSpaces);
 	textOption.setWrapMode(QTextOption::NoWrap);
 	textOption.setTextDirection(option.direction);
 
-	const QRect textRect = rect.adjusted(textMargin, 0, -textMargin, 0);
-	qreal xOff = textRect.left();
-
-	// prepare line seprator
 	const qreal sepWidth = qreal(textRect.height()) / 2.;
-	docLayout->separatorResize(QSizeF(sepWidth, textRect.height()));
+	qreal xOff = 0.;
 
-	// layout and draw text
+	// layout text relative to textRect origin
 	for(QTextBlock bi = doc->begin(); bi != doc->end(); bi = bi.next()) {
-		QTextLayout bl;
-		bl.setCacheEnabled(true);
-		bl.setFont(option.font);
-		bl.setTextOption(textOption);
+		QTextLayout *bl = new QTextLayout();
+		rl->layouts.append(bl);
+		bl->setCacheEnabled(true);
+		bl->setFont(option.font);
+		bl->setTextOption(textOption);
 		QString text = bi.text() + QChar(QChar::LineSeparator);
 		// replace certain non-printable characters with spaces (to avoid drawing boxes
 		// when using fonts that don't have glyphs for such characters)
@@ -208,27 +247,61 @@ drawRichText(QPainter *painter, const QStyleOptionViewItem &option, const QRect
 			|| uc[i] == QChar::ObjectReplacementCharacter)
 				uc[i] = QChar(QChar::Space);
 		}
-		bl.setText(text);
-		bl.setFormats(docLayout->applyCSS(bi.textFormats()));
-		bl.beginLayout();
+		bl->setText(text);
+		bl->setFormats(docLayout->applyCSS(bi.textFormats()));
+		bl->beginLayout();
 		for(;;) {
-			QTextLine line = bl.createLine();
+			QTextLine line = bl->createLine();
 			if(!line.isValid())
 				break;
 			line.setLeadingIncluded(true);
 			line.setLineWidth(10000);
-			line.setPosition(QPointF(xOff, textRect.top() + (qreal(textRect.height()) - line.height()) / 2.));
+			line.setPosition(QPointF(xOff, (qreal(textRect.height()) - line.height()) / 2.));
 			const int w = line.naturalTextWidth();
 			xOff += w + sepWidth;
 			line.setLineWidth(w);
 		}
-		bl.endLayout();
+		bl->endLayout();
+	}
+
+	m_rowCache.insert(key, rl);
+	return rl;
+}
+
+void
+LinesItemDelegate::drawRichText(QPainter *painter, const QStyleOptionViewItem &option, const QRect &rect) const
+{
+	painter->setRenderHints(QPainter::Antialiasing | QPainter::TextAntialiasing | QPainter::SmoothPixmapTransform);
+
+	QPalette::ColorGroup cg = option.state & QStyle::State_Enabled ? QPalette::Normal : QPalette::Disabled;
+	if(cg == QPalette::Normal && !(option.state & QStyle::State_Active))
+		cg = QPalette::Inactive;
+	painter->setPen(option.palette.color(cg, (option.state & QStyle::State_Selected) ? QPalette::HighlightedText : QPalette::Text));
+
+	const QStyle *style = option.widget ? option.widget->style() : QApplication::style();
+	int textMargin = style->pixelMetric(QStyle::PM_FocusFrameHMargin, nullptr, option.widget) + 1;
+
+	const QRect textRect = rect.adjusted(textMargin, 0, -textMargin, 0);
+
+	// keeps the document pinned while it's drawn
+	const RichDocumentPtr doc = option.index.data(Qt::DisplayRole).value<RichDocumentPtr>();
+	if(!doc)
+		return;
+	const RowLayout *rl = rowLayout(option, doc, textRect);
+
+	// prepare line seprator
+	RichDocumentLayout *docLayout = doc->documentLayout();
+	const qreal sepWidth = qreal(textRect.height()) / 2.;
+	docLayout->separatorResize(QSizeF(sepWidth, textRect.height()));
 
-		const int n = bl.lineCount();
+	// draw text
+	const QPointF origin = textRect.topLeft();
+	for(const QTextLayout *bl : rl->layouts) {
+		const int n = bl->lineCount();
 		for(int i = 0; i < n; i++) {
-			const QTextLine &tl = bl.lineAt(i);
-			tl.draw(painter, QPointF());
-			docLayout->separatorDraw(painter, QPointF(tl.position().x() - sepWidth, tl.position().y() - tl.descent()));
+			const QTextLine &tl = bl->lineAt(i);
+			tl.draw(painter, origin);
+			docLayout->separatorDraw(painter, origin + QPointF(tl.position().x() - sepWidth, tl.position().y() - tl.descent()));
 		}
 	}
 }
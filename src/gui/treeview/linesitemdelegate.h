@@ -8,12 +8,18 @@
 #ifndef LINESITEMDELEGATE_H
 #define LINESITEMDELEGATE_H
 
+#include <QCache>
+#include <QFont>
 #include <QStyledItemDelegate>
+#include <QVector>
 
+QT_FORWARD_DECLARE_CLASS(QAbstractItemModel)
 QT_FORWARD_DECLARE_CLASS(QTextDocument)
+QT_FORWARD_DECLARE_CLASS(QTextLayout)
 
 namespace SubtitleComposer {
 class LinesWidget;
+class RichDocument;
 
 class LinesItemDelegate : public QStyledItemDelegate
 {
@@ -33,6 +39,8 @@ public:
 
 	inline LinesWidget * linesWidget() const { return qobject_cast<LinesWidget *>(parent()); }
 
+	void setModel(const QAbstractItemModel *model);
+
 	QString displayText(const QVariant &value, const QLocale &locale) const override;
 	QWidget * createEditor(QWidget *parent, const QStyleOptionViewItem &option, const QModelIndex &index) const override;
 	void setEditorData(QWidget *editor, const QModelIndex &index) const override;
@@ -41,6 +49,26 @@ protected:
 	bool eventFilter(QObject *object, QEvent *event) override;
 
 	void paint(QPainter *painter, const QStyleOptionViewItem &option, const QModelIndex &index) const override;
+
+private:
+	struct RowLayout {
+		~RowLayout();
+
+		quint64 serial;
+		int revision;
+		QFont font;
+		int height;
+		Qt::Alignment alignment;
+		Qt::LayoutDirection direction;
+		QVector<QTextLayout *> layouts;
+	};
+
+	void drawRichText(QPainter *painter, const QStyleOptionViewItem &option, const QRect &rect) const;
+	const RowLayout * rowLayout(const QStyleOptionViewItem &option, const RichDocument *doc, const QRect &textRect) const;
+	void invalidateRows(const QModelIndex &topLeft, const QModelIndex &bottomRight);
+
+	// laid out rich text rows, keyed by row and column
+	mutable QCache<quint64, RowLayout> m_rowCache;
 };
 }
 
@@ -10,7 +10,7 @@
 #include "core/subtitle.h"
 #include "gui/treeview/linesmodel.h"
 #include "gui/treeview/lineswidget.h"
-#include "gui/treeview/richdocumentptr.h"
+#include "core/richtext/richdocumentptr.h"
 #include "helpers/common.h"
 
 #include "scconfig.h"
@@ -22,20 +22,33 @@
 
 #include <KLocalizedString>
 
+#include <climits>
+
 #if QT_VERSION < QT_VERSION_CHECK(5, 11, 0)
 #define horizontalAdvance width
 #endif
 
 using namespace SubtitleComposer;
 
+#define FETCH_BATCH_SIZE 2000
+// formatted time cells kept, enough for several screens of rows
+#define TIME_CACHE_SIZE 2000
+
+inline static quint64 cellKey(int row, int column) { return quint64(quint32(row)) << 32 | quint32(column); }
+
 LinesModel::LinesModel(QObject *parent)
 	: QAbstractListModel(parent),
 	  m_subtitle(nullptr),
+	  m_readOnly(false),
 	  m_dataChangedTimer(new QTimer(this)),
 	  m_minChangedLineIndex(-1),
 	  m_maxChangedLineIndex(-1),
 	  m_resetModelTimer(new QTimer(this)),
-	  m_resetModelSelection(nullptr, nullptr)
+	  m_fetchTimer(new QTimer(this)),
+	  m_fetchedRows(INT_MAX),
+	  m_timeCache(TIME_CACHE_SIZE),
+	  m_resetModelSelection(nullptr, nullptr),
+	  m_reordering(false)
 {
 	m_dataChangedTimer->setInterval(0);
 	m_dataChangedTimer->setSingleShot(true);
@@ -44,6 +57,11 @@ LinesModel::LinesModel(QObject *parent)
 	m_resetModelTimer->setInterval(0);
 	m_resetModelTimer->setSingleShot(true);
 	connect(m_resetModelTimer, &QTimer::timeout, this, &LinesModel::onModelReset);
+
+	// keep fetching from event loop until all rows are shown
+	m_fetchTimer->setInterval(0);
+	m_fetchTimer->setSingleShot(true);
+	connect(m_fetchTimer, &QTimer::timeout, this, [this](){ fetchMore(QModelIndex()); });
 }
 
 void
@@ -56,13 +74,19 @@ LinesModel::setSubtitle(Subtitle *subtitle)
 			disconnect(m_subtitle.constData(), &Subtitle::linesInserted, this, &LinesModel::onLinesInserted);
 			disconnect(m_subtitle.constData(), &Subtitle::linesAboutToBeRemoved, this, &LinesModel::onLinesAboutToRemove);
 			disconnect(m_subtitle.constData(), &Subtitle::linesRemoved, this, &LinesModel::onLinesRemoved);
+			disconnect(m_subtitle.constData(), &Subtitle::linesAboutToBeReordered, this, &LinesModel::onLinesAboutToReorder);
+			disconnect(m_subtitle.constData(), &Subtitle::linesReordered, this, &LinesModel::onLinesReordered);
+			disconnect(m_subtitle.constData(), &Subtitle::linesErrorFlagsChanged, this, &LinesModel::onLineRangeChanged);
+			disconnect(m_subtitle.constData(), &Subtitle::linesTimesChanged, this, &LinesModel::onLinesTimesChanged);
+			disconnect(m_subtitle.constData(), &Subtitle::linesPrimaryTextChanged, this, &LinesModel::onLineRangeChanged);
+			disconnect(m_subtitle.constData(), &Subtitle::linesSecondaryTextChanged, this, &LinesModel::onLineRangeChanged);
 
 			disconnect(m_subtitle.constData(), &Subtitle::lineAnchorChanged, this, &LinesModel::onLineChanged);
 			disconnect(m_subtitle.constData(), &Subtitle::lineErrorFlagsChanged, this, &LinesModel::onLineChanged);
 			disconnect(m_subtitle.constData(), &Subtitle::linePrimaryTextChanged, this, &LinesModel::onLineChanged);
 			disconnect(m_subtitle.constData(), &Subtitle::lineSecondaryTextChanged, this, &LinesModel::onLineChanged);
-			disconnect(m_subtitle.constData(), &Subtitle::lineShowTimeChanged, this, &LinesModel::onLineChanged);
-			disconnect(m_subtitle.constData(), &Subtitle::lineHideTimeChanged, this, &LinesModel::onLineChanged);
+			disconnect(m_subtitle.constData(), &Subtitle::lineShowTimeChanged, this, &LinesModel::onLineTimeChanged);
+			disconnect(m_subtitle.constData(), &Subtitle::lineHideTimeChanged, this, &LinesModel::onLineTimeChanged);
 
 			disconnect(m_subtitle->stylesheet(), &RichCSS::changed, this, &LinesModel::onLinesChanged);
 
@@ -73,8 +97,14 @@ LinesModel::setSubtitle(Subtitle *subtitle)
 		}
 
 		m_subtitle = subtitle;
+		m_fetchTimer->stop();
+		m_fetchedRows = INT_MAX;
 
 		if(m_subtitle) {
+			if(m_subtitle->linesCount() > FETCH_BATCH_SIZE) {
+				m_fetchedRows = FETCH_BATCH_SIZE;
+				m_fetchTimer->start();
+			}
 			if(m_subtitle->linesCount()) {
 				onLinesInserted(0, m_subtitle->linesCount() - 1);
 			}
@@ -82,13 +112,19 @@ LinesModel::setSubtitle(Subtitle *subtitle)
 			connect(m_subtitle.constData(), &Subtitle::linesInserted, this, &LinesModel::onLinesInserted);
 			connect(m_subtitle.constData(), &Subtitle::linesAboutToBeRemoved, this, &LinesModel::onLinesAboutToRemove);
 			connect(m_subtitle.constData(), &Subtitle::linesRemoved, this, &LinesModel::onLinesRemoved);
+			connect(m_subtitle.constData(), &Subtitle::linesAboutToBeReordered, this, &LinesModel::onLinesAboutToReorder);
+			connect(m_subtitle.constData(), &Subtitle::linesReordered, this, &LinesModel::onLinesReordered);
+			connect(m_subtitle.constData(), &Subtitle::linesErrorFlagsChanged, this, &LinesModel::onLineRangeChanged);
+			connect(m_subtitle.constData(), &Subtitle::linesTimesChanged, this, &LinesModel::onLinesTimesChanged);
+			connect(m_subtitle.constData(), &Subtitle::linesPrimaryTextChanged, this, &LinesModel::onLineRangeChanged);
+			connect(m_subtitle.constData(), &Subtitle::linesSecondaryTextChanged, this, &LinesModel::onLineRangeChanged);
 
 			connect(m_subtitle.constData(), &Subtitle::lineAnchorChanged, this, &LinesModel::onLineChanged);
 			connect(m_subtitle.constData(), &Subtitle::lineErrorFlagsChanged, this, &LinesModel::onLineChanged);
 			connect(m_subtitle.constData(), &Subtitle::linePrimaryTextChanged, this, &LinesModel::onLineChanged);
 			connect(m_subtitle.constData(), &Subtitle::lineSecondaryTextChanged, this, &LinesModel::onLineChanged);
-			connect(m_subtitle.constData(), &Subtitle::lineShowTimeChanged, this, &LinesModel::onLineChanged);
-			connect(m_subtitle.constData(), &Subtitle::lineHideTimeChanged, this, &LinesModel::onLineChanged);
+			connect(m_subtitle.constData(), &Subtitle::lineShowTimeChanged, this, &LinesModel::onLineTimeChanged);
+			connect(m_subtitle.constData(), &Subtitle::lineHideTimeChanged, this, &LinesModel::onLineTimeChanged);
 
 			connect(m_subtitle->stylesheet(), &RichCSS::changed, this, &LinesModel::onLinesChanged);
 		}
@@ -118,7 +154,52 @@ int
 LinesModel::rowCount(const QModelIndex &parent) const
 {
 	Q_UNUSED(parent);
-	return m_subtitle ? m_subtitle->linesCount() : 0;
+	return m_subtitle ? qMin(m_subtitle->linesCount(), m_fetchedRows) : 0;
+}
+
+bool
+LinesModel::canFetchMore(const QModelIndex &parent) const
+{
+	return !parent.isValid() && m_subtitle && m_fetchedRows < m_subtitle->linesCount();
+}
+
+void
+LinesModel::fetchMore(const QModelIndex &parent)
+{
+	if(!canFetchMore(parent))
+		return;
+	if(m_resetModelTimer->isActive()) {
+		// rows are inserted only after pending reset is done
+		m_fetchTimer->start();
+		return;
+	}
+	fetchRows(FETCH_BATCH_SIZE);
+	if(m_fetchedRows != INT_MAX)
+		m_fetchTimer->start();
+}
+
+void
+LinesModel::fetchAll()
+{
+	if(!canFetchMore(QModelIndex()))
+		return;
+	m_fetchTimer->stop();
+	if(m_resetModelTimer->isActive()) {
+		// reset exposes all rows at once
+		m_fetchedRows = INT_MAX;
+		return;
+	}
+	fetchRows(m_subtitle->linesCount());
+}
+
+void
+LinesModel::fetchRows(int count)
+{
+	const int lineCount = m_subtitle->linesCount();
+	const int last = int(qMin<qint64>(lineCount, qint64(m_fetchedRows) + count)) - 1;
+	beginInsertRows(QModelIndex(), m_fetchedRows, last);
+	m_fetchedRows = last + 1 < lineCount ? last + 1 : INT_MAX;
+	endInsertRows();
 }
 
 int
@@ -131,7 +212,7 @@ LinesModel::columnCount(const QModelIndex &parent) const
 Qt::ItemFlags
 LinesModel::flags(const QModelIndex &index) const
 {
-	if(!index.isValid() || index.column() < Text)
+	if(!index.isValid() || index.column() < Text || m_readOnly)
 		return QAbstractItemModel::flags(index);
 
 	return QAbstractItemModel::flags(index) | Qt::ItemIsEditable;
@@ -214,28 +295,28 @@ LinesModel::data(const QModelIndex &index, int role) const
 
 	case PauseTime:
 		if(role == Qt::DisplayRole)
-			return line->pauseTime().toString(true, false);
+			return timeString(index, line);
 		if(role == Qt::TextAlignmentRole)
 			return Qt::AlignCenter;
 		break;
 
 	case ShowTime:
 		if(role == Qt::DisplayRole)
-			return line->showTime().toString();
+			return timeString(index, line);
 		if(role == Qt::TextAlignmentRole)
 			return Qt::AlignCenter;
 		break;
 
 	case HideTime:
 		if(role == Qt::DisplayRole)
-			return line->hideTime().toString();
+			return timeString(index, line);
 		if(role == Qt::TextAlignmentRole)
 			return Qt::AlignCenter;
 		break;
 
 	case Duration:
 		if(role == Qt::DisplayRole)
-			return line->durationTime().toString(true, false);
+			return timeString(index, line);
 		if(role == Qt::TextAlignmentRole)
 			return Qt::AlignCenter;
 		if(role == Qt::ForegroundRole) {
@@ -289,9 +370,41 @@ LinesModel::setData(const QModelIndex &index, const QVariant &value, int role)
 	return false;
 }
 
+QString
+LinesModel::timeString(const QModelIndex &index, const SubtitleLine *line) const
+{
+	const quint64 key = cellKey(index.row(), index.column());
+	if(const QString *str = m_timeCache.object(key))
+		return *str;
+
+	QString *str;
+	switch(index.column()) {
+	case PauseTime: str = new QString(line->pauseTime().toString(true, false)); break;
+	case ShowTime: str = new QString(line->showTime().toString()); break;
+	case HideTime: str = new QString(line->hideTime().toString()); break;
+	default: str = new QString(line->durationTime().toString(true, false)); break;
+	}
+	m_timeCache.insert(key, str);
+	return *str;
+}
+
+void
+LinesModel::invalidateTimes(int firstRow, int lastRow)
+{
+	if(lastRow - firstRow >= m_timeCache.maxCost()) {
+		m_timeCache.clear();
+		return;
+	}
+	for(int row = firstRow; row <= lastRow; row++) {
+		for(int column = PauseTime; column <= Duration; column++)
+			m_timeCache.remove(cellKey(row, column));
+	}
+}
+
 void
 LinesModel::onLinesInserted(int firstIndex, int lastIndex)
 {
+	m_timeCache.clear();
 	m_resetModelSelection.first = m_subtitle->at(firstIndex);
 	m_resetModelSelection.second = m_subtitle->at(lastIndex);
 	LinesWidget *lw = static_cast<LinesWidget *>(parent());
@@ -307,7 +420,7 @@ LinesModel::onLinesInserted(int firstIndex, int lastIndex)
 void
 LinesModel::onLinesAboutToRemove(int firstIndex, int lastIndex)
 {
-	const int index = lastIndex == rowCount() - 1 ? firstIndex - 1 : lastIndex + 1;
+	const int index = lastIndex == m_subtitle->lastIndex() ? firstIndex - 1 : lastIndex + 1;
 	m_resetModelSelection.first = m_resetModelSelection.second = m_subtitle->line(index);
 }
 
@@ -316,9 +429,56 @@ LinesModel::onLinesRemoved(int firstIndex, int lastIndex)
 {
 	Q_UNUSED(firstIndex);
 	Q_UNUSED(lastIndex);
+	m_timeCache.clear();
 	m_resetModelTimer->start();
 }
 
+void
+LinesModel::onLinesAboutToReorder(int firstIndex, int lastIndex)
+{
+	Q_UNUSED(lastIndex);
+
+	// pending reset will expose new order anyway
+	if(m_resetModelTimer->isActive() || firstIndex >= rowCount())
+		return;
+
+	emit layoutAboutToBeChanged(QList<QPersistentModelIndex>(), VerticalSortHint);
+
+	// remember lines of persistent indexes (selection, current index) to find their new rows later
+	m_reorderIndexes = persistentIndexList();
+	m_reorderLines.clear();
+	m_reorderLines.reserve(m_reorderIndexes.size());
+	for(const QModelIndex &idx : qAsConst(m_reorderIndexes))
+		m_reorderLines.append(m_subtitle->at(idx.row()));
+	m_reordering = true;
+}
+
+void
+LinesModel::onLinesReordered(int firstIndex, int lastIndex)
+{
+	Q_UNUSED(firstIndex);
+	Q_UNUSED(lastIndex);
+
+	m_timeCache.clear();
+
+	if(!m_reordering)
+		return;
+	m_reordering = false;
+
+	const int rows = rowCount();
+	QModelIndexList newIndexes;
+	newIndexes.reserve(m_reorderIndexes.size());
+	for(int i = 0, n = m_reorderIndexes.size(); i < n; i++) {
+		const int row = m_reorderLines.at(i)->index();
+		newIndexes.append(row < rows ? index(row, m_reorderIndexes.at(i).column()) : QModelIndex());
+	}
+	changePersistentIndexList(m_reorderIndexes, newIndexes);
+	m_reorderIndexes.clear();
+	m_reorderLines.clear();
+
+	emit layoutChanged(QList<QPersistentModelIndex>(), VerticalSortHint);
+}
+
 void
 LinesModel::onModelReset()
 {
@@ -336,8 +496,12 @@ LinesModel::onModelReset()
 			sm->setCurrentIndex(idx, QItemSelectionModel::Rows);
 		}
 	} else if(m_resetModelSelection.first) {
+		if(m_resetModelSelection.first->index() >= rowCount())
+			fetchAll();
 		const QModelIndex first = index(m_resetModelSelection.first->index(), 0, QModelIndex());
 		if(m_resetModelSelection.first != m_subtitle->firstLine() && m_resetModelSelection.second != m_subtitle->lastLine()) {
+			if(m_resetModelSelection.second->index() >= rowCount())
+				fetchAll();
 			const QModelIndex last = index(m_resetModelSelection.second->index(), columnCount() - 1, QModelIndex());
 			sm->select(QItemSelection(first, last), QItemSelectionModel::ClearAndSelect);
 		}
@@ -378,6 +542,37 @@ LinesModel::onLineChanged(const SubtitleLine *line)
 	}
 }
 
+void
+LinesModel::onLineTimeChanged(const SubtitleLine *line)
+{
+	// pause of the next line depends on hide time of this one
+	const int lineIndex = line->index();
+	const int lastIndex = qMin(lineIndex + 1, m_subtitle->lastIndex());
+	invalidateTimes(lineIndex, lastIndex);
+	onLineRangeChanged(lineIndex, lastIndex);
+}
+
+void
+LinesModel::onLinesTimesChanged(int firstIndex, int lastIndex)
+{
+	lastIndex = qMin(lastIndex + 1, m_subtitle->lastIndex());
+	invalidateTimes(firstIndex, lastIndex);
+	onLineRangeChanged(firstIndex, lastIndex);
+}
+
+void
+LinesModel::onLineRangeChanged(int firstIndex, int lastIndex)
+{
+	if(m_minChangedLineIndex < 0) {
+		m_minChangedLineIndex = firstIndex;
+		m_maxChangedLineIndex = lastIndex;
+		m_dataChangedTimer->start();
+	} else {
+		m_minChangedLineIndex = qMin(m_minChangedLineIndex, firstIndex);
+		m_maxChangedLineIndex = qMax(m_maxChangedLineIndex, lastIndex);
+	}
+}
+
 void
 LinesModel::onLinesChanged()
 {
@@ -395,7 +590,10 @@ LinesModel::emitDataChanged()
 	else if(m_maxChangedLineIndex < 0)
 		m_maxChangedLineIndex = m_minChangedLineIndex;
 
-	emit dataChanged(index(m_minChangedLineIndex, 0), index(m_maxChangedLineIndex, ColumnCount - 1));
+	// rows that are not fetched yet will be read when they are
+	const int lastRow = rowCount() - 1;
+	if(m_minChangedLineIndex <= lastRow)
+		emit dataChanged(index(m_minChangedLineIndex, 0), index(qMin(m_maxChangedLineIndex, lastRow), ColumnCount - 1));
 
 	m_minChangedLineIndex = -1;
 	m_maxChangedLineIndex = -1;
@@ -9,10 +9,12 @@
 #define LINESMODEL_H
 
 #include <QAbstractListModel>
+#include <QCache>
 #include <QExplicitlySharedDataPointer>
 #include <QList>
 #include <QTimer>
 #include <QPointer>
+#include <QVector>
 
 namespace SubtitleComposer {
 class Subtitle;
@@ -31,12 +33,25 @@ public:
 	inline Subtitle * subtitle() const { return m_subtitle.data(); }
 	void setSubtitle(Subtitle *subtitle);
 
+	/**
+	 * @brief Lines are shown but can't be edited, used while subtitle is still being read
+	 */
+	inline bool isReadOnly() const { return m_readOnly; }
+	inline void setReadOnly(bool readOnly) { m_readOnly = readOnly; }
+
 	inline SubtitleLine * playingLine() const { return m_playingLine; }
 	void setPlayingLine(SubtitleLine *line);
 
 	int rowCount(const QModelIndex &parent = QModelIndex()) const override;
 	int columnCount(const QModelIndex &parent = QModelIndex()) const override;
 
+	/**
+	 * @brief Rows of newly set subtitle are exposed in batches, so large files show up right away
+	 */
+	bool canFetchMore(const QModelIndex &parent) const override;
+	void fetchMore(const QModelIndex &parent) override;
+	void fetchAll();
+
 	Qt::ItemFlags flags(const QModelIndex &index) const override;
 
 	QVariant headerData(int section, Qt::Orientation orientation, int role = Qt::DisplayRole) const override;
@@ -45,6 +60,7 @@ public:
 	bool setData(const QModelIndex &index, const QVariant &value, int role = Qt::EditRole) override;
 
 	inline void processSelectionUpdate() {
+		fetchAll();
 		if(!m_resetModelTimer->isActive())
 			return;
 		m_resetModelTimer->stop();
@@ -55,24 +71,40 @@ private slots:
 	void onLinesInserted(int firstIndex, int lastIndex);
 	void onLinesAboutToRemove(int firstIndex, int lastIndex);
 	void onLinesRemoved(int firstIndex, int lastIndex);
+	void onLinesAboutToReorder(int firstIndex, int lastIndex);
+	void onLinesReordered(int firstIndex, int lastIndex);
 	void onModelReset();
 
 	void onLineChanged(const SubtitleLine *line);
+	void onLineTimeChanged(const SubtitleLine *line);
+	void onLinesTimesChanged(int firstIndex, int lastIndex);
+	void onLineRangeChanged(int firstIndex, int lastIndex);
 	void onLinesChanged();
 	void emitDataChanged();
 
 private:
 	static QString buildToolTip(SubtitleLine *line, bool primary);
+	void fetchRows(int count);
+	QString timeString(const QModelIndex &index, const SubtitleLine *line) const;
+	void invalidateTimes(int firstRow, int lastRow);
 
 private:
 	QExplicitlySharedDataPointer<Subtitle> m_subtitle;
+	bool m_readOnly;
 	QPointer<SubtitleLine> m_playingLine;
 	QTimer *m_dataChangedTimer;
 	int m_minChangedLineIndex;
 	int m_maxChangedLineIndex;
 	QTimer *m_resetModelTimer;
+	QTimer *m_fetchTimer;
+	int m_fetchedRows; // INT_MAX once all lines are exposed
+	// formatted time columns, keyed by row and column
+	mutable QCache<quint64, QString> m_timeCache;
 	std::pair<const SubtitleLine *, const SubtitleLine *> m_resetModelSelection;
 	bool m_resetModelResumeEditing;
+	bool m_reordering;
+	QModelIndexList m_reorderIndexes;
+	QVector<const SubtitleLine *> m_reorderLines;
 
 	friend class LinesWidget;
 };
@@ -38,6 +38,7 @@ LinesWidget::LinesWidget(QWidget *parent)
 	  m_inlineEditor(nullptr)
 {
 	setModel(new LinesModel(this));
+	m_itemsDelegate->setModel(model());
 	selectionModel()->deleteLater();
 	setSelectionModel(new LinesSelectionModel(model()));
 
@@ -292,7 +293,20 @@ LinesWidget::saveConfig()
 void
 LinesWidget::setSubtitle(Subtitle *subtitle)
 {
+	const bool wasReadOnly = model()->isReadOnly();
+	model()->setReadOnly(false);
 	model()->setSubtitle(subtitle);
+	// current line of previewed subtitle wasn't reported
+	if(wasReadOnly)
+		onCurrentRowChanged();
+}
+
+void
+LinesWidget::previewSubtitle(Subtitle *subtitle)
+{
+	model()->setReadOnly(true);
+	model()->setSubtitle(subtitle);
+	onCurrentRowChanged();
 }
 
 void
@@ -311,6 +325,8 @@ LinesWidget::setCurrentLine(SubtitleLine *line, bool clearSelection)
 	if(!line)
 		return;
 
+	if(line->index() >= model()->rowCount())
+		model()->fetchAll();
 	selectionModel()->setCurrentIndex(model()->index(line->index(), 0),
 									  QItemSelectionModel::Select | QItemSelectionModel::Rows
 									  | (clearSelection ? QItemSelectionModel::Clear : QItemSelectionModel::NoUpdate));
@@ -448,7 +464,8 @@ void
 LinesWidget::onCurrentRowChanged()
 {
 	auto sm = qobject_cast<LinesSelectionModel *>(selectionModel());
-	emit currentLineChanged(sm->currentLine());
+	// line editors must not get lines that can't be edited
+	emit currentLineChanged(model()->isReadOnly() ? nullptr : sm->currentLine());
 }
 
 void
@@ -48,6 +48,10 @@ public:
 
 public slots:
 	void setSubtitle(Subtitle *subtitle = 0);
+	/**
+	 * @brief Show lines of @p subtitle that is still being read, they can't be edited until setSubtitle()
+	 */
+	void previewSubtitle(Subtitle *subtitle);
 	void setTranslationMode(bool enabled);
 
 	void setCurrentLine(SubtitleLine *line, bool clearSelection = true);
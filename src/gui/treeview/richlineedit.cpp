@@ -157,7 +157,7 @@ RichLineEdit::setupActions()
 void
 RichLineEdit::setDocument(RichDocument *document)
 {
-	m_document = document;
+	m_document = RichDocumentPtr(document);
 	m_control->setDocument(m_document);
 	m_control->setFont(m_lineStyle.font);
 	m_control->setLayoutDirection(m_lineStyle.direction);
@@ -7,7 +7,7 @@
 #ifndef RICHLINEEDIT_H
 #define RICHLINEEDIT_H
 
-#include "gui/treeview/richdocumentptr.h"
+#include "core/richtext/richdocumentptr.h"
 
 #include <QBasicTimer>
 #include <QStyleOptionViewItem>
@@ -30,7 +30,7 @@ public:
 	virtual ~RichLineEdit();
 
 	void setDocument(RichDocument *document);
-	inline RichDocument *document() const { return RichDocumentPtr(m_document); }
+	inline RichDocument *document() const { return m_document.data(); }
 
 protected:
 	bool event(QEvent *e) override;
@@ -58,7 +58,7 @@ protected:
 
 protected:
 	QVector<QAction *> m_actions;
-	RichDocument *m_document = nullptr;
+	RichDocumentPtr m_document;
 	QStyleOptionViewItem m_lineStyle;
 	RichDocumentEditor *m_control = nullptr;
 	QPoint m_mousePressPos;
@@ -36,6 +36,8 @@
 
 #include <KLocalizedString>
 
+#include <algorithm>
+
 using namespace SubtitleComposer;
 
 #define ZOOM_MIN (1 << 3)
@@ -287,6 +289,7 @@ WaveformWidget::setSubtitle(Subtitle *subtitle)
 		disconnect(m_subtitle.constData(), &Subtitle::primaryChanged, this, &WaveformWidget::onSubtitleChanged);
 		disconnect(m_subtitle.constData(), &Subtitle::secondaryChanged, this, &WaveformWidget::onSubtitleChanged);
 		disconnect(m_subtitle.constData(), &Subtitle::lineAnchorChanged, this, &WaveformWidget::onSubtitleChanged);
+		disconnect(m_subtitle.constData(), &Subtitle::linesTimesChanged, this, &WaveformWidget::onSubtitleChanged);
 	}
 
 	m_subtitle = subtitle;
@@ -295,6 +298,7 @@ WaveformWidget::setSubtitle(Subtitle *subtitle)
 		connect(m_subtitle.constData(), &Subtitle::primaryChanged, this, &WaveformWidget::onSubtitleChanged);
 		connect(m_subtitle.constData(), &Subtitle::secondaryChanged, this, &WaveformWidget::onSubtitleChanged);
 		connect(m_subtitle.constData(), &Subtitle::lineAnchorChanged, this, &WaveformWidget::onSubtitleChanged);
+		connect(m_subtitle.constData(), &Subtitle::linesTimesChanged, this, &WaveformWidget::onSubtitleChanged);
 	}
 
 	m_visibleLines.clear();
@@ -381,12 +385,19 @@ WaveformWidget::updateVisibleLines()
 		}
 	}
 
+	QVector<SubtitleLine *> lines = m_subtitle->linesIntersecting(m_timeStart, m_timeEnd);
+	if(m_draggedLine && m_draggedLine->line()->subtitle() == m_subtitle.data()) {
+		// dragged line is always visible, keep it in subtitle order
+		SubtitleLine *dragged = m_draggedLine->line();
+		const int draggedIndex = dragged->index();
+		auto pos = std::lower_bound(lines.begin(), lines.end(), draggedIndex, [](const SubtitleLine *l, int index){ return l->index() < index; });
+		if(pos == lines.end() || *pos != dragged)
+			lines.insert(pos, dragged);
+	}
+
 	it = m_visibleLines.begin();
-	for(int i = 0, n = m_subtitle->count(); i < n; i++) {
-		SubtitleLine *sub = m_subtitle->at(i);
+	for(SubtitleLine *sub : qAsConst(lines)) {
 		const bool isDragged = m_draggedLine != nullptr && sub == m_draggedLine->line();
-		if(!sub->intersectsTimespan(m_timeStart, m_timeEnd) && !isDragged)
-			continue;
 		const Time showTime = isDragged ? m_draggedLine->showTime() : sub->showTime();
 		while(it != m_visibleLines.end() && (*it)->showTime() < showTime) {
 			if((*it)->line() == sub)
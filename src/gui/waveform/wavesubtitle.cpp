@@ -22,10 +22,10 @@ WaveSubtitle::WaveSubtitle(SubtitleLine *line, WaveRenderer *parent)
 	: QObject(parent),
 	  m_line(line),
 	  m_rend(parent),
+	  m_doc(m_rend->showTranslation() ? m_line->secondaryDoc() : m_line->primaryDoc()),
 	  m_image(1, 1, QImage::Format_ARGB32_Premultiplied)
 {
-	const RichDocument *doc = m_rend->showTranslation() ? m_line->secondaryDoc() : m_line->primaryDoc();
-	connect(doc, &RichDocument::contentsChanged, this, [&](){ m_imageDirty = true; });
+	connect(m_doc, &RichDocument::contentsChanged, this, [&](){ m_imageDirty = true; });
 }
 
 WaveSubtitle::~WaveSubtitle()
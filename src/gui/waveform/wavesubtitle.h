@@ -8,6 +8,7 @@
 #define WAVESUBTITLE_H
 
 #include <core/time.h>
+#include <core/richtext/richdocumentptr.h>
 
 #include <QImage>
 #include <QObject>
@@ -15,7 +16,6 @@
 QT_FORWARD_DECLARE_CLASS(QTextLayout)
 
 namespace SubtitleComposer {
-class RichDocument;
 class SubtitleLine;
 class WaveRenderer;
 
@@ -52,6 +52,8 @@ public:
 private:
 	SubtitleLine *m_line;
 	WaveRenderer *m_rend;
+	// keeps the document alive, so its changes keep being tracked
+	RichDocumentPtr m_doc;
 
 	mutable QImage m_image;
 	mutable bool m_imageDirty = true;
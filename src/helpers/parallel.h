@@ -0,0 +1,55 @@
+/*
+    SPDX-FileCopyrightText: 2010-2022 Mladen Milinkovic <max@smoothware.net>
+
+    SPDX-License-Identifier: GPL-2.0-or-later
+*/
+
+#ifndef PARALLEL_H
+#define PARALLEL_H
+
+#include <QRunnable>
+#include <QThread>
+#include <QThreadPool>
+
+#include <functional>
+
+namespace SubtitleComposer {
+class FunctionRunnable : public QRunnable
+{
+public:
+	typedef std::function<void()> Function;
+
+	FunctionRunnable(const Function &fn) : m_fn(fn) {}
+	void run() override { m_fn(); }
+
+private:
+	Function m_fn;
+};
+
+/**
+ * @brief Split [0, count) in chunks of at least @p minChunkSize items and call @p fn(begin, end)
+ * for each of them on a thread pool, returns when all chunks are done
+ */
+template<class F>
+void
+parallelFor(int count, int minChunkSize, F fn)
+{
+	const int chunkCount = qBound(1, count / qMax(1, minChunkSize), qMax(1, QThread::idealThreadCount()));
+	if(chunkCount == 1) {
+		if(count > 0)
+			fn(0, count);
+		return;
+	}
+
+	QThreadPool pool;
+	pool.setMaxThreadCount(chunkCount);
+	for(int i = 0; i < chunkCount; i++) {
+		const int begin = int(qint64(count) * i / chunkCount);
+		const int end = int(qint64(count) * (i + 1) / chunkCount);
+		pool.start(new FunctionRunnable([&fn, begin, end](){ fn(begin, end); }));
+	}
+	pool.waitForDone();
+}
+}
+
+#endif // PARALLEL_H
@@ -141,4 +141,37 @@ RichCssTest::testParseRules()
 	QCOMPARE(RichCSS::parseCssRules(&data).toString(), cssOut);
 }
 
+void
+RichCssTest::testMatch()
+{
+	css.clear();
+	css.parse($("b { color: red; } .yellow { color: yellow; font-style: italic; } v[voice=\"A\"] { font-weight: 700; }"));
+
+	const QSet<QString> sel{$("b"), $("i")};
+	QCOMPARE(css.match(sel).value("color"), $("red"));
+	QCOMPARE(css.match(sel).size(), 1);
+
+	const QSet<QString> selClass{$("b"), $("c"), $(".yellow")};
+	QTextCharFormat fmt = css.charFormat(selClass);
+	QCOMPARE(fmt.foreground().color(), QColor(Qt::yellow));
+	QVERIFY(fmt.fontItalic());
+	QVERIFY(!fmt.hasProperty(QTextFormat::FontWeight));
+
+	const QSet<QString> selVoice{$("v"), $("v[voice=\"A\"]")};
+	QCOMPARE(css.charFormat(selVoice).fontWeight(), int(QFont::Bold));
+
+	// results cached by revision must follow stylesheet changes
+	const quint64 revision = css.revision();
+	css.parse($("b { color: blue; }"));
+	QVERIFY(css.revision() != revision);
+	QCOMPARE(css.match(sel).value("color"), $("blue"));
+	QCOMPARE(css.charFormat(sel).foreground().color(), QColor(Qt::blue));
+	const quint64 parsedRevision = css.revision();
+	css.clear();
+	QVERIFY(css.revision() != parsedRevision);
+	QVERIFY(css.revision() != RichCSS().revision());
+	QVERIFY(css.match(sel).isEmpty());
+	QVERIFY(css.charFormat(selClass).properties().isEmpty());
+}
+
 QTEST_GUILESS_MAIN(RichCssTest)
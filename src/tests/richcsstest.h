@@ -23,6 +23,8 @@ private slots:
 
 	void testParseRules_data();
 	void testParseRules();
+
+	void testMatch();
 };
 
 #endif // RICHCSSTEST_H
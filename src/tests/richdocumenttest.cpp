@@ -6,6 +6,7 @@
 
 #include "richdocumenttest.h"
 
+#include "core/richtext/richdom.h"
 #include "helpers/common.h"
 
 #include <QDebug>
@@ -387,4 +388,58 @@ RichDocumentTest::testClass()
 	qDebug() << doc.toHtml();
 }
 
+void
+RichDocumentTest::testDom()
+{
+	doc.setHtml($("a<b>bc<i>de</i>fg</b>hi"), true);
+	RichDOM::Node *n = doc.nodeAt(4);
+	QVERIFY(n);
+	QCOMPARE(doc.crumbAt(n), $("body > b > i"));
+	QCOMPARE(n->nodeStart, 3u);
+	QCOMPARE(n->nodeEnd, 5u);
+	QVERIFY(!doc.nodeAt(0));
+	QVERIFY(!doc.nodeAt(8));
+
+	// incrementally updated tree must match a full rebuild
+	const auto verifyDom = [&](){
+		RichDOM full;
+		full.update(&doc);
+		for(int i = 0; i <= doc.length(); i++) {
+			RichDOM::Node *a = doc.nodeAt(i);
+			RichDOM::Node *b = full.nodeAt(i);
+			QCOMPARE(doc.crumbAt(a), doc.crumbAt(b));
+			if(a && b) {
+				QCOMPARE(a->nodeStart, b->nodeStart);
+				QCOMPARE(a->nodeEnd, b->nodeEnd);
+			}
+		}
+	};
+
+	QTextCursor *c = doc.undoableCursor();
+	c->setPosition(2);
+	c->insertText($("xx"));
+	QCOMPARE(doc.toPlainText(), $("abxxcdefghi"));
+	verifyDom();
+
+	c->setPosition(0);
+	c->setPosition(4, QTextCursor::KeepAnchor);
+	QTextCharFormat fmt;
+	fmt.setFontItalic(true);
+	c->mergeCharFormat(fmt);
+	verifyDom();
+	QCOMPARE(doc.crumbAt(doc.nodeAt(5)), $("body > b > i"));
+
+	c->setPosition(5);
+	c->setPosition(9, QTextCursor::KeepAnchor);
+	c->removeSelectedText();
+	QCOMPARE(doc.toPlainText(), $("abxxchi"));
+	verifyDom();
+
+	doc.undo();
+	verifyDom();
+	c->movePosition(QTextCursor::End);
+	c->insertText($("\nnew line"));
+	verifyDom();
+}
+
 QTEST_MAIN(RichDocumentTest)
@@ -39,6 +39,8 @@ private slots:
 	void testTitle();
 
 	void testClass();
+
+	void testDom();
 };
 
 #endif // RICHDOCUMENTTEST_H
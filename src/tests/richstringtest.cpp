@@ -344,4 +344,86 @@ RichStringTest::testStyleMerge()
 	QVERIFY(sstring.cummulativeVoices().size() == 1);
 }
 
+void
+RichStringTest::testStyleRuns()
+{
+	RichString sstring("0123456789");
+
+	// adjacent runs with same style are merged
+	sstring.setStyleFlags(2, 3, RichString::Bold);
+	sstring.setStyleFlags(5, 3, RichString::Bold);
+	QVERIFY(sstring.richString() == QLatin1String("01<b>234567</b>89"));
+	QVERIFY(sstring.styleFlagsAt(1) == 0);
+	QVERIFY(sstring.styleFlagsAt(2) == RichString::Bold);
+	QVERIFY(sstring.styleFlagsAt(7) == RichString::Bold);
+	QVERIFY(sstring.styleFlagsAt(8) == 0);
+	sstring.setStyleColor(4, 2, 0xff0000);
+	QVERIFY(sstring.richString() == QLatin1String("01<b>23<font color=#ff0000>45</font>67</b>89"));
+	QVERIFY(sstring.styleColorAt(5) == 0xff0000);
+	sstring.setStyleColor(0, -1, 0);
+	QVERIFY(sstring.richString() == QLatin1String("01<b>234567</b>89"));
+
+	// copies are independent
+	RichString copy(sstring);
+	copy.setStyleFlags(0, -1, RichString::Italic, true);
+	QVERIFY(copy.richString() == QLatin1String("<i>01<b>234567</b>89</i>"));
+	QVERIFY(sstring.richString() == QLatin1String("01<b>234567</b>89"));
+	QVERIFY(copy != sstring);
+
+	// long round trip
+	QStringList words;
+	for(int i = 0; i < 200; i++)
+		words.append(i % 3 ? $("word") : $("<i>word</i>"));
+	const QString text = words.join(QChar::Space);
+	sstring.setRichString(text);
+	QVERIFY(sstring.length() == 200 * 5 - 1);
+	QVERIFY(sstring.richString() == text);
+
+	// whitespace simplification keeps styles of remaining characters
+	sstring.setRichString("<b>a  \t b</b>  \n\n<i>c</i>");
+	sstring.simplifyWhiteSpace();
+	QVERIFY(sstring.richString() == QLatin1String("<b>a b</b>\n<i>c</i>"));
+
+	// serialization
+	sstring.setRichString("<v voiceA><c.classA>Hi <b>there</b></c> <font color=#00ff00>friend</font>");
+	QByteArray data;
+	{
+		QDataStream out(&data, QIODevice::WriteOnly);
+		out << sstring;
+	}
+	RichString restored;
+	QDataStream in(data);
+	in >> restored;
+	QVERIFY(in.status() == QDataStream::Ok);
+	QVERIFY(restored.richString() == sstring.richString());
+	QVERIFY(restored.cummulativeVoices() == sstring.cummulativeVoices());
+}
+
+void
+RichStringTest::testIntern()
+{
+	const RichString a = RichString::intern(RichString::fromRichString($("<i>[music]</i>")));
+	const RichString b = RichString::intern(RichString::fromRichString($("<i>[music]</i>")));
+	QVERIFY(a.isSharedWith(b));
+	QVERIFY(a == b);
+	QVERIFY(b.richString() == QLatin1String("<i>[music]</i>"));
+
+	// same text with different style or voice is a different entry
+	const RichString c = RichString::intern(RichString::fromRichString($("[music]")));
+	QVERIFY(!a.isSharedWith(c));
+	QVERIFY(c.richString() == QLatin1String("[music]"));
+	const RichString d = RichString::intern(RichString::fromRichString($("<v A><i>[music]</i>")));
+	const RichString e = RichString::intern(RichString::fromRichString($("<v B><i>[music]</i>")));
+	QVERIFY(!d.isSharedWith(a));
+	QVERIFY(!d.isSharedWith(e));
+
+	// modifying a copy doesn't change the interned string
+	RichString f(b);
+	f.setStyleFlags(0, -1, RichString::Bold, true);
+	f.replace(0, 1, $("("));
+	QVERIFY(f.richString() == QLatin1String("<i><b>(music]</b></i>"));
+	QVERIFY(a.richString() == QLatin1String("<i>[music]</i>"));
+	QVERIFY(RichString::intern(RichString::fromRichString($("<i>[music]</i>"))).isSharedWith(a));
+}
+
 QTEST_GUILESS_MAIN(RichStringTest);
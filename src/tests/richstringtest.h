@@ -20,6 +20,8 @@ private slots:
 	void testInsert();
 	void testReplace();
 	void testStyleMerge();
+	void testStyleRuns();
+	void testIntern();
 };
 
 #endif
@@ -0,0 +1,264 @@
+/*
+    SPDX-FileCopyrightText: 2010-2022 Mladen Milinkovic <max@smoothware.net>
+
+    SPDX-License-Identifier: GPL-2.0-or-later
+*/
+
+#include "substationalphatest.h"
+
+#include "core/subtitle.h"
+#include "core/subtitleline.h"
+#include "formats/substationalpha/substationalphainputformat.h"
+#include "helpers/common.h"
+
+#include <QColor>
+#include <QRegularExpression>
+#include <QStringBuilder>
+#include <QTest>
+
+using namespace SubtitleComposer;
+
+namespace SubtitleComposer {
+class TestSubStationAlphaInputFormat : public SubStationAlphaInputFormat
+{
+public:
+	using SubStationAlphaInputFormat::toRichString;
+	using SubStationAlphaInputFormat::parseSubtitles;
+	using SubStationAlphaInputFormat::formatData;
+};
+}
+
+/**
+ * @brief Regex based override tag conversion that was used before the lexer - reference for output
+ */
+static RichString
+regexToRichString(const QString &string)
+{
+	staticRE$(reCommands, "\\{([^\\}]+)\\}", REu);
+
+	RichString ret;
+	int currentStyle = 0;
+	QRgb currentColor = 0;
+
+	QRegularExpressionMatchIterator itCommands = reCommands.globalMatch(string);
+	int offset = 0;
+	while(itCommands.hasNext()) {
+		QRegularExpressionMatch mCommands = itCommands.next();
+		int newStyleFlags = currentStyle;
+		QRgb newColor = currentColor;
+
+		const QStringList commandsList(mCommands.captured(1).split('\\'));
+		for(const QString &cmd : commandsList) {
+			if(cmd.isEmpty()) {
+				continue;
+			} else if(cmd == QLatin1String("i0")) {
+				newStyleFlags &= ~RichString::Italic;
+			} else if(cmd == QLatin1String("b0")) {
+				newStyleFlags &= ~RichString::Bold;
+			} else if(cmd == QLatin1String("u0")) {
+				newStyleFlags &= ~RichString::Underline;
+			} else if(cmd == QLatin1String("i1")) {
+				newStyleFlags |= RichString::Italic;
+			} else if(cmd.at(0) == 'b') {
+				newStyleFlags |= RichString::Bold;
+			} else if(cmd == QLatin1String("u1")) {
+				newStyleFlags |= RichString::Underline;
+			} else if(cmd.at(0) == 'c') {
+				QString val = ($("000000") + cmd.mid(3).chopped(1)).right(6);
+				if(val == QLatin1String("000000")) {
+					newStyleFlags &= ~RichString::Color;
+					newColor = 0;
+				} else {
+					newStyleFlags |= RichString::Color;
+					newColor = QColor(QChar('#') % val.mid(4, 2) % val.mid(2, 2) % val.mid(0, 2)).rgb();
+				}
+			}
+		}
+
+		const QString text = string.mid(offset, mCommands.capturedStart() - offset)
+				.replace(QLatin1String("\\N"), QLatin1String("\n"), Qt::CaseInsensitive);
+		ret.append(RichString(text, currentStyle, currentColor));
+
+		currentStyle = newStyleFlags;
+		currentColor = newColor;
+		offset = mCommands.capturedEnd();
+	}
+	const QString text = string.mid(offset)
+			.replace(QLatin1String("\\N"), QLatin1String("\n"), Qt::CaseInsensitive);
+	ret.append(RichString(text, currentStyle, currentColor));
+
+	return ret;
+}
+
+/**
+ * @brief Regex based event scan that was used before the field scanner - benchmark baseline
+ */
+static int
+regexParseEvents(const QString &data)
+{
+	staticRE$(reDialogue, " *Dialogue: *[^,]+, *([^,]+), *([^,]+), *[^,]*, *[^,]*, *[^,]*, *[^,]*, *[^,]*, *[^,]*, *([^\r\n]*)[\r\n]+", REu);
+	staticRE$(reDialogueData, " *(Dialogue: *[^,]+, *)[^,]+(, *)[^,]+(, *[^,]+, *[^,]*, *[^,]*, *[^,]*, *[^,]*, *[^,]*, *).*", REu);
+	staticRE$(reTime, "(\\d+):(\\d+):(\\d+).(\\d+)", REu);
+
+	int count = 0;
+	QRegularExpressionMatchIterator itDialogue = reDialogue.globalMatch(data);
+	while(itDialogue.hasNext()) {
+		QRegularExpressionMatch mDialogue = itDialogue.next();
+		QRegularExpressionMatch mShow = reTime.match(mDialogue.captured(1));
+		QRegularExpressionMatch mHide = reTime.match(mDialogue.captured(2));
+		if(!mShow.hasMatch() || !mHide.hasMatch())
+			break;
+		const RichString text = regexToRichString(mDialogue.captured(3));
+		const QString dialogue = mDialogue.captured(0).replace(reDialogueData, $("\\1%1\\2%2\\3%3\n"));
+		count += !text.isEmpty() + !dialogue.isEmpty();
+	}
+	return count;
+}
+
+static QString
+assHeader(const QString &format)
+{
+	return $("[Script Info]\n"
+			"ScriptType: v4.00+\n"
+			"\n"
+			"[V4+ Styles]\n"
+			"Format: Name, Fontname, Fontsize\n"
+			"Style: Default, Sans, 16\n"
+			"\n"
+			"[Events]\n")
+		% format % QChar('\n');
+}
+
+static QString
+generateAss(int lines)
+{
+	QString data = assHeader($("Format: Layer, Start, End, Style, Actor, MarginL, MarginR, MarginV, Effect, Text"));
+	for(int i = 0; i < lines; i++) {
+		const int s = i * 2;
+		data += $("Dialogue: 0,0:%1:%2.10,0:%1:%3.90,Default,,0000,0000,0000,,{\\i1}Line %4{\\i0}, with comma\\N{\\c&H00FF00&}second row\n")
+				.arg(s / 60 % 60, 2, 10, QChar('0'))
+				.arg(s % 60, 2, 10, QChar('0'))
+				.arg(s % 60 + 1, 2, 10, QChar('0'))
+				.arg(i);
+	}
+	return data;
+}
+
+void
+SubStationAlphaTest::testToRichString_data()
+{
+	QTest::addColumn<QString>("text");
+
+	QTest::newRow("plain") << $("plain text, no tags");
+	QTest::newRow("newlines") << $("first\\Nsecond\\nthird");
+	QTest::newRow("styles") << $("{\\i1}italic{\\i0} {\\b1}bold{\\b0} {\\u1}under{\\u0}");
+	QTest::newRow("multiple") << $("{\\i1\\b700\\u1}all{\\i0\\b0\\u0} none");
+	QTest::newRow("unknown") << $("{\\pos(10,20)\\fad(100,200)}{\\blur3}text");
+	QTest::newRow("color") << $("{\\c&H0000FF&}red{\\c&H000000&}none{\\1c&HFF0000&}x{\\c}y");
+	QTest::newRow("empty braces") << $("a{}b{\\}c");
+	QTest::newRow("unclosed") << $("a{\\i1 b\\N c");
+	QTest::newRow("nested open") << $("a{x{\\i1}b}c");
+	QTest::newRow("tag only") << $("{\\i1}");
+}
+
+void
+SubStationAlphaTest::testToRichString()
+{
+	QFETCH(QString, text);
+
+	TestSubStationAlphaInputFormat format;
+	const RichString expected = regexToRichString(text);
+	const RichString actual = format.toRichString(text);
+	QCOMPARE(actual.richString(), expected.richString());
+	QVERIFY(actual == expected);
+}
+
+void
+SubStationAlphaTest::testParse()
+{
+	const QString data = generateAss(10);
+
+	TestSubStationAlphaInputFormat format;
+	Subtitle sub;
+	QVERIFY(format.readSubtitle(sub, true, data));
+	QCOMPARE(sub.count(), 10);
+
+	const SubtitleLine *line = sub.at(3);
+	QCOMPARE(line->showTime(), Time(0, 0, 6, 100));
+	QCOMPARE(line->hideTime(), Time(0, 0, 7, 900));
+	QVERIFY(line->primaryText() == regexToRichString($("{\\i1}Line 3{\\i0}, with comma\\N{\\c&H00FF00&}second row")));
+
+	FormatData *fd = format.formatData(line);
+	QVERIFY(fd);
+	QCOMPARE(fd->value($("Dialogue")), $("Dialogue: 0,%1,%2,Default,,0000,0000,0000,,%3\n\n"));
+}
+
+void
+SubStationAlphaTest::testFormatOrder()
+{
+	const QString data = assHeader($("Format: Layer, Style, End, Start, Actor, Text"))
+			% $("Dialogue: 0, Default, 0:00:02.50, 0:00:01.25,Actor,  Hello, world\n");
+
+	TestSubStationAlphaInputFormat format;
+	Subtitle sub;
+	QVERIFY(format.readSubtitle(sub, true, data));
+	QCOMPARE(sub.count(), 1);
+	QCOMPARE(sub.at(0)->showTime(), Time(0, 0, 1, 250));
+	QCOMPARE(sub.at(0)->hideTime(), Time(0, 0, 2, 500));
+	QCOMPARE(sub.at(0)->primaryText().string(), $("Hello, world"));
+	QCOMPARE(format.formatData(sub.at(0))->value($("Dialogue")), $("Dialogue: 0, Default, %2, %1,Actor,  %3\n\n"));
+}
+
+void
+SubStationAlphaTest::testParseBatches()
+{
+	const QString data = generateAss(2500);
+
+	TestSubStationAlphaInputFormat format;
+	ParsedSubtitle sub;
+	QVector<int> batches;
+	QStringList texts;
+	sub.sink = [&](ParsedSubtitle &parsed){
+		batches.append(parsed.lines.size());
+		for(const ParsedLine &line : qAsConst(parsed.lines))
+			texts.append(line.text.string());
+		parsed.lines.clear();
+	};
+	QVERIFY(format.parseSubtitles(sub, data));
+	QCOMPARE(batches, QVector<int>({ PARSED_BATCH_SIZE, PARSED_BATCH_SIZE, 500 }));
+	QCOMPARE(sub.lineCount, 2500);
+	QVERIFY(sub.lines.isEmpty());
+	QVERIFY(sub.formatData);
+	QVERIFY(texts.at(1234).startsWith($("Line 1234")));
+}
+
+void
+SubStationAlphaTest::benchmarkParse_data()
+{
+	QTest::addColumn<bool>("scanner");
+
+	QTest::newRow("scanner") << true;
+	QTest::newRow("regex") << false;
+}
+
+void
+SubStationAlphaTest::benchmarkParse()
+{
+	QFETCH(bool, scanner);
+
+	const QString data = generateAss(20000);
+	TestSubStationAlphaInputFormat format;
+
+	if(scanner) {
+		QBENCHMARK {
+			ParsedSubtitle sub;
+			format.parseSubtitles(sub, data);
+		}
+	} else {
+		QBENCHMARK {
+			regexParseEvents(data);
+		}
+	}
+}
+
+QTEST_GUILESS_MAIN(SubStationAlphaTest);
@@ -0,0 +1,26 @@
+/*
+    SPDX-FileCopyrightText: 2010-2022 Mladen Milinkovic <max@smoothware.net>
+
+    SPDX-License-Identifier: GPL-2.0-or-later
+*/
+
+#ifndef SUBSTATIONALPHATEST_H
+#define SUBSTATIONALPHATEST_H
+
+#include <QObject>
+
+class SubStationAlphaTest : public QObject
+{
+	Q_OBJECT
+
+private slots:
+	void testToRichString_data();
+	void testToRichString();
+	void testParse();
+	void testFormatOrder();
+	void testParseBatches();
+	void benchmarkParse_data();
+	void benchmarkParse();
+};
+
+#endif // SUBSTATIONALPHATEST_H
@@ -6,9 +6,21 @@
 
 #include "subtitletest.h"
 
+#include <QBuffer>
+#include <QFileInfo>
+#include <QSignalSpy>
+#include <QTemporaryDir>
 #include <QTest>
+#include <QTextCodec>
 
 #include "core/richtext/richdocument.h"
+#include "core/richtext/richdocumentptr.h"
+#include "core/subtitlejournal.h"
+#include "core/undo/subtitleactions.h"
+#include "core/undo/subtitlelineactions.h"
+#include "formats/formatmanager.h"
+#include "formats/outputformat.h"
+#include "helpers/common.h"
 
 #include <klocalizedstring.h>
 
@@ -26,6 +38,33 @@ SubtitleTest::~SubtitleTest()
 	sub.reset();
 }
 
+/**
+ * @brief Create @p count lines one second apart, primary text of each line is its index
+ */
+QList<SubtitleLine *>
+SubtitleTest::makeLines(int count, int duration)
+{
+	QList<SubtitleLine *> lines;
+	for(int n = 0; n < count; n++) {
+		SubtitleLine *line = new SubtitleLine(n * 1000, n * 1000 + duration);
+		line->resetPrimaryText(RichString(QString::number(n)));
+		lines.append(line);
+	}
+	return lines;
+}
+
+void
+SubtitleTest::fillLines(int count, int duration)
+{
+	sub->insertLines(makeLines(count, duration));
+}
+
+void
+SubtitleTest::init()
+{
+	sub->removeLines(RangeList(Range::full()), SubtitleTarget::Both);
+}
+
 void
 SubtitleTest::testSort_data()
 {
@@ -46,8 +85,6 @@ SubtitleTest::testSort()
 {
 	QFETCH(QVector<int>, lines);
 
-	sub->removeLines(RangeList(Range::full()), SubtitleTarget::Both);
-
 	for(int n: lines) {
 		SubtitleLine *l = new SubtitleLine(n * 1000, n * 1000 + 500);
 		l->primaryDoc()->setPlainText(QString::number(n));
@@ -59,4 +96,523 @@ SubtitleTest::testSort()
 		QVERIFY(qRound(sub->at(i)->showTime().toSeconds()) == i + 1);
 }
 
+void
+SubtitleTest::testInsertLines()
+{
+	QList<SubtitleLine *> lines;
+	for(int n: {5, 1, 3}) {
+		SubtitleLine *l = new SubtitleLine(n * 1000, n * 1000 + 500);
+		l->primaryDoc()->setPlainText(QString::number(n));
+		lines.append(l);
+	}
+	QSignalSpy insertSpy(sub.data(), &Subtitle::linesInserted);
+	QSignalSpy reorderSpy(sub.data(), &Subtitle::linesReordered);
+	sub->insertLines(lines);
+	QCOMPARE(sub->count(), 3);
+	QCOMPARE(insertSpy.count(), 1);
+	QCOMPARE(reorderSpy.count(), 0);
+
+	// interleaved lines are appended and moved into place at once
+	lines.clear();
+	for(int n: {6, 2, 4, 0, 2}) {
+		SubtitleLine *l = new SubtitleLine(n * 1000, n * 1000 + 500);
+		l->primaryDoc()->setPlainText(QString::number(n) + QChar('b'));
+		lines.append(l);
+	}
+	sub->insertLines(lines, false);
+	QCOMPARE(sub->count(), 8);
+	QCOMPARE(insertSpy.count(), 2);
+	QCOMPARE(insertSpy.at(1).at(0).toInt(), 3);
+	QCOMPARE(insertSpy.at(1).at(1).toInt(), 7);
+	QCOMPARE(reorderSpy.count(), 1);
+	QCOMPARE(reorderSpy.at(0).at(0).toInt(), 0);
+	QCOMPARE(reorderSpy.at(0).at(1).toInt(), 7);
+
+	const QStringList expected = {$("0b"), $("1"), $("2b"), $("2b"), $("3"), $("4b"), $("5"), $("6b")};
+	for(int i = 0; i < sub->count(); i++) {
+		QCOMPARE(sub->at(i)->primaryDoc()->toPlainText(), expected.at(i));
+		QCOMPARE(sub->at(i)->index(), i);
+	}
+}
+
+void
+SubtitleTest::testSortLines()
+{
+	fillLines(8, 500);
+
+	// shifting doesn't keep lines sorted, equal show times check that sort is stable
+	sub->shiftLines(RangeList(Range(0, 2)), 4000);
+
+	QSignalSpy aboutSpy(sub.data(), &Subtitle::linesAboutToBeReordered);
+	QSignalSpy reorderSpy(sub.data(), &Subtitle::linesReordered);
+	sub->sortLines(Range::full());
+	QCOMPARE(aboutSpy.count(), 1);
+	QCOMPARE(reorderSpy.count(), 1);
+	QCOMPARE(reorderSpy.at(0), aboutSpy.at(0));
+
+	const QStringList expected = {$("3"), $("0"), $("4"), $("1"), $("5"), $("2"), $("6"), $("7")};
+	for(int i = 0; i < sub->count(); i++) {
+		QCOMPARE(sub->at(i)->primaryDoc()->toPlainText(), expected.at(i));
+		QCOMPARE(sub->at(i)->index(), i);
+	}
+}
+
+void
+SubtitleTest::testLineTimes()
+{
+	const QList<SubtitleLine *> lines = makeLines(5, 500);
+	SubtitleLine *moved = lines.at(1);
+	QCOMPARE(moved->showTime(), Time(1000));
+	QCOMPARE(moved->hideTime(), Time(1500));
+	sub->insertLines(lines);
+
+	// line keeps its times while it's moved into sorted position
+	moved->setTimes(Time(3600), Time(3900));
+	QCOMPARE(moved->index(), 3);
+	QCOMPARE(moved->showTime(), Time(3600));
+	QCOMPARE(moved->hideTime(), Time(3900));
+
+	const int expected[] = { 0, 2000, 3000, 3600, 4000 };
+	for(int i = 0; i < sub->count(); i++) {
+		QCOMPARE(sub->at(i)->showTime(), Time(expected[i]));
+		QCOMPARE(sub->at(i)->durationTime(), Time(i == 3 ? 300 : 500));
+	}
+}
+
+void
+SubtitleTest::testBulkTimes()
+{
+	fillLines(1000, 1200);
+
+	QSignalSpy rangeSpy(sub.data(), &Subtitle::linesTimesChanged);
+	QSignalSpy lineSpy(sub.data(), &Subtitle::lineShowTimeChanged);
+
+	sub->shiftLines(RangeList(Range(10, 19)), 250);
+	QCOMPARE(rangeSpy.count(), 1);
+	QCOMPARE(rangeSpy.at(0).at(0).toInt(), 10);
+	QCOMPARE(rangeSpy.at(0).at(1).toInt(), 19);
+	QCOMPARE(sub->at(9)->showTime(), Time(9000));
+	QCOMPARE(sub->at(10)->showTime(), Time(10250));
+	QCOMPARE(sub->at(19)->hideTime(), Time(20450));
+
+	sub->adjustLines(Range(0, 999), 0, 1998000);
+	QCOMPARE(rangeSpy.count(), 2);
+	QCOMPARE(sub->at(500)->showTime(), Time(1000000));
+	QCOMPARE(sub->at(500)->hideTime(), Time(1002400));
+
+	sub->fixOverlappingLines(RangeList(Range::full()), 100);
+	QCOMPARE(rangeSpy.count(), 3);
+	QCOMPARE(sub->at(500)->hideTime(), Time(1001900));
+	QCOMPARE(lineSpy.count(), 0);
+
+	// undo swaps back the old times
+	const QVector<double> times(10, 5.);
+	UndoAction *action = new SetLinesTimesAction(sub.data(), 990, times, times, QString());
+	action->redo();
+	QCOMPARE(sub->at(995)->showTime(), Time(5));
+	action->undo();
+	QCOMPARE(sub->at(995)->showTime(), Time(1990000));
+	delete action;
+}
+
+void
+SubtitleTest::testUndoMemoryUsage()
+{
+	QList<SubtitleLine *> lines = makeLines(100);
+	for(SubtitleLine *line : lines)
+		line->resetPrimaryText(RichString(QString(100, QChar('x'))));
+	sub->insertLines(lines);
+
+	// removed lines are owned by the action until it is undone
+	UndoAction *action = new RemoveLinesAction(sub.data(), 0, 49);
+	const quint64 emptySize = action->memoryUsage();
+	action->redo();
+	QVERIFY(action->memoryUsage() >= emptySize + 50 * 100 * sizeof(QChar));
+	action->undo();
+	QCOMPARE(action->memoryUsage(), emptySize);
+	QCOMPARE(sub->count(), 100);
+	delete action;
+}
+
+void
+SubtitleTest::testTextUndoMemoryUsage()
+{
+	fillLines(1);
+	SubtitleLine *line = sub->at(0);
+	RichDocument *doc = line->primaryDoc();
+	doc->setPlainText(QString(1000, QChar('x')));
+	QVERIFY(doc->isUndoAvailable());
+
+	// edits are kept by the document, actions account for them
+	UndoAction *action = new SetLinePrimaryTextAction(line, doc);
+	QVERIFY(action->memoryUsage() >= 1000 * sizeof(QChar));
+
+	// document history is cleared once the last action stepping through it is dropped
+	UndoAction *newer = new SetLinePrimaryTextAction(line, doc);
+	action->discard();
+	delete action;
+	QVERIFY(doc->isUndoAvailable());
+	newer->discard();
+	delete newer;
+	QVERIFY(!doc->isUndoAvailable());
+	QCOMPARE(line->primaryText().string(), QString(1000, QChar('x')));
+}
+
+void
+SubtitleTest::testDirtyState()
+{
+	using U = UndoStack;
+	const QVector<U::DirtyMode> modes = { U::Primary, U::Secondary, U::None, U::Both };
+
+	QVERIFY(!U::isDirty(modes, 0, 0, U::Primary));
+	QVERIFY(U::isDirty(modes, 0, 1, U::Primary));
+	QVERIFY(!U::isDirty(modes, 1, 3, U::Primary));
+	QVERIFY(U::isDirty(modes, 1, 3, U::Secondary));
+	QVERIFY(U::isDirty(modes, 1, 4, U::Primary));
+	// clean state that was dropped from history can't be reached again
+	QVERIFY(U::isDirty(modes, -1, 0, U::Primary));
+	QVERIFY(U::isDirty(modes, -1, 4, U::Secondary));
+
+	// clean and save states follow history compaction
+	QCOMPARE(U::trimmedIndex(5, 3, 7), 2);
+	QCOMPARE(U::trimmedIndex(6, 3, 7), 3);
+	QCOMPARE(U::trimmedIndex(3, 3, 7), 0);
+	QCOMPARE(U::trimmedIndex(2, 3, 7), -1);
+	QCOMPARE(U::trimmedIndex(-1, 0, 7), -1);
+	// states past dropped redo commands are gone
+	QCOMPARE(U::trimmedIndex(4, 0, 4), 4);
+	QCOMPARE(U::trimmedIndex(5, 0, 4), -1);
+}
+
+void
+SubtitleTest::testChangeBatch()
+{
+	fillLines(20);
+
+	QSignalSpy rangeSpy(sub.data(), &Subtitle::linesTimesChanged);
+	QSignalSpy lineSpy(sub.data(), &Subtitle::lineShowTimeChanged);
+
+	{
+		SubtitleCompositeActionExecutor executor(sub.data(), QString());
+		sub->at(12)->setShowTime(12100);
+		sub->at(4)->setShowTime(4100);
+		sub->at(7)->setHideTime(7900);
+		QCOMPARE(rangeSpy.count(), 0);
+		// time index doesn't wait for the batch
+		QCOMPARE(sub->linesAt(Time(4050)).size(), 0);
+	}
+	QCOMPARE(lineSpy.count(), 0);
+	QCOMPARE(rangeSpy.count(), 1);
+	QCOMPARE(rangeSpy.at(0).at(0).toInt(), 4);
+	QCOMPARE(rangeSpy.at(0).at(1).toInt(), 12);
+
+	sub->at(2)->setShowTime(2100);
+	QCOMPARE(lineSpy.count(), 1);
+	QCOMPARE(rangeSpy.count(), 1);
+
+	// recorded ranges follow lines moved during the batch instead of growing to the end
+	rangeSpy.clear();
+	{
+		SubtitleCompositeActionExecutor executor(sub.data(), QString());
+		sub->at(12)->setShowTime(12200);
+		sub->at(14)->setHideTime(14900);
+		sub->removeLines(RangeList(Range(0, 1)), SubtitleTarget::Both);
+		sub->insertLine(new SubtitleLine(Time(19100), Time(19500)));
+	}
+	QCOMPARE(sub->count(), 19);
+	QCOMPARE(rangeSpy.count(), 1);
+	QCOMPARE(rangeSpy.at(0).at(0).toInt(), 10);
+	QCOMPARE(rangeSpy.at(0).at(1).toInt(), 12);
+}
+
+void
+SubtitleTest::testSnapshot()
+{
+	fillLines(600);
+
+	const SubtitleSnapshot before = sub->snapshot();
+	QCOMPARE(before.count(), 600);
+	QCOMPARE(before.primaryText(512).string(), QStringLiteral("512"));
+
+	// snapshot doesn't see later edits
+	sub->at(300)->resetPrimaryText(RichString(QStringLiteral("changed")));
+	sub->at(300)->setShowTime(300100);
+	sub->removeLines(RangeList(Range(0, 9)), SubtitleTarget::Both);
+	QCOMPARE(before.primaryText(300).string(), QStringLiteral("300"));
+	QCOMPARE(before.showTime(300), Time(300000));
+	QCOMPARE(before.count(), 600);
+
+	const SubtitleSnapshot after = sub->snapshot();
+	QCOMPARE(after.count(), 590);
+	QCOMPARE(after.primaryText(290).string(), QStringLiteral("changed"));
+	QCOMPARE(after.showTime(290), Time(300100));
+	QCOMPARE(after.primaryText(589).string(), QStringLiteral("599"));
+}
+
+void
+SubtitleTest::testSnapshotWrite()
+{
+	// surrogate pairs end up split between sink blocks
+	const QString smiley = QString::fromUtf8("\xf0\x9f\x98\x80");
+	QList<SubtitleLine *> lines = makeLines(3000);
+	for(SubtitleLine *line : lines)
+		line->resetPrimaryText(RichString(line->primaryText().string() + QChar::LineFeed + smiley));
+	sub->insertLines(lines);
+
+	const OutputFormat *format = FormatManager::instance().output($("SubRip"));
+	QVERIFY(format);
+
+	// sink output has to match encoding of the whole text at once
+	QString expected;
+	for(int n = 0; n < 3000; n++) {
+		const Time showTime(n * 1000), hideTime(n * 1000 + 800);
+		expected += QString::asprintf("%d\n%02d:%02d:%02d,%03d --> %02d:%02d:%02d,%03d\n", n + 1,
+				showTime.hours(), showTime.minutes(), showTime.seconds(), showTime.millis(),
+				hideTime.hours(), hideTime.minutes(), hideTime.seconds(), hideTime.millis());
+		expected += QString::number(n) + QChar::LineFeed + smiley + $("\n\n");
+	}
+	QTextCodec *codec = QTextCodec::codecForName("UTF-8");
+
+	QBuffer buffer;
+	buffer.open(QIODevice::WriteOnly);
+	{
+		OutputSink out(&buffer, codec, OutputSink::CRLF);
+		format->writeSubtitle(sub->snapshot(), true, out);
+		QVERIFY(out.flush());
+	}
+	QCOMPARE(buffer.data(), codec->fromUnicode(expected.replace(QChar::LineFeed, $("\r\n"))));
+
+	// canceled sink stops writing
+	QAtomicInt cancel(1);
+	buffer.buffer().clear();
+	buffer.seek(0);
+	OutputSink canceled(&buffer, codec, OutputSink::LF, &cancel);
+	format->writeSubtitle(sub->snapshot(), true, canceled);
+	QVERIFY(!canceled.flush());
+	QVERIFY(buffer.data().isEmpty());
+}
+
+void
+SubtitleTest::testJournal()
+{
+	QTemporaryDir dir;
+	const QUrl url = QUrl::fromLocalFile(dir.filePath($("journal.srt")));
+
+	fillLines(3);
+
+	SubtitleJournal journal;
+	journal.start(sub.data(), url);
+	sub->at(1)->setTimes(1100, 1900);
+	sub->at(2)->primaryDoc()->setPlainText($("edited"));
+	sub->removeLines(RangeList(Range(0)), SubtitleTarget::Both);
+	sub->insertLines(QList<SubtitleLine *>() << new SubtitleLine(5000, 6000));
+	QVERIFY(SubtitleJournal::exists(url));
+
+	// single line edits are written together a moment later
+	const QString path = SubtitleJournal::journalPath(url);
+	const qint64 size = QFileInfo(path).size();
+	sub->at(0)->setTimes(1200, 1800);
+	sub->at(0)->setShowTime(1150);
+	QCOMPARE(QFileInfo(path).size(), size);
+	QTRY_VERIFY(QFileInfo(path).size() > size);
+
+	// journal in use is left alone by others
+	{
+		SubtitleJournal other;
+		other.start(sub.data(), url);
+		other.stop();
+	}
+	QVERIFY(SubtitleJournal::exists(url));
+
+	// partial record left by a crash is ignored
+	{
+		QFile file(path);
+		QVERIFY(file.open(QIODevice::WriteOnly | QIODevice::Append));
+		file.write(QByteArray("\0\0\1", 3));
+	}
+
+	Subtitle recovered;
+	recovered.insertLines(makeLines(3));
+	QVERIFY(SubtitleJournal::recover(url, &recovered));
+	QCOMPARE(recovered.count(), 3);
+	QCOMPARE(recovered.at(0)->showTime(), Time(1150));
+	QCOMPARE(recovered.at(0)->hideTime(), Time(1800));
+	QCOMPARE(recovered.at(1)->primaryText().string(), $("edited"));
+	QCOMPARE(recovered.at(2)->showTime(), Time(5000));
+
+	journal.stop();
+	QVERIFY(!SubtitleJournal::exists(url));
+}
+
+void
+SubtitleTest::testLazyDocuments()
+{
+	const int lineCount = 5000;
+	QList<SubtitleLine *> lines = makeLines(lineCount);
+	for(SubtitleLine *line : lines)
+		line->resetPrimaryText(RichString(line->primaryText().string(), RichString::Italic));
+	sub->insertLines(lines);
+
+	// edited document has undo history and pinned one is used from outside, both must survive release
+	RichDocument *edited = sub->at(0)->primaryDoc();
+	edited->setPlainText($("edited"));
+	const RichDocumentPtr pinned(sub->at(1)->primaryDoc());
+	const QPointer<RichDocument> unused = sub->at(2)->primaryDoc();
+
+	// returned documents stay valid until control returns to the event loop
+	for(int i = 3; i < lineCount; i++)
+		QCOMPARE(sub->at(i)->primaryDoc()->toPlainText(), QString::number(i));
+	QVERIFY(unused);
+	QTRY_VERIFY(!unused);
+	QVERIFY(pinned);
+	QCOMPARE(pinned->toPlainText(), $("1"));
+
+	for(int i = 1; i < lineCount; i++) {
+		QCOMPARE(sub->at(i)->primaryText().string(), QString::number(i));
+		QVERIFY(sub->at(i)->primaryText().hasStyleFlags(RichString::Italic));
+		QCOMPARE(sub->at(i)->plainText(true), QString::number(i));
+	}
+
+	QCOMPARE(sub->at(0)->primaryDoc(), edited);
+	QCOMPARE(sub->at(0)->plainText(true), $("edited"));
+}
+
+void
+SubtitleTest::testTextStats()
+{
+	SubtitleLine line(0, 5000);
+	line.resetPrimaryText(RichString($(" one  two\nthree")));
+	QCOMPARE(line.primaryCharacters(), 13);
+	QCOMPARE(line.primaryWords(), 3);
+	QCOMPARE(line.primaryLines(), 2);
+	QVERIFY(line.checkMaxPrimaryCharsPerLine(6, false));
+	QVERIFY(!line.checkMaxPrimaryCharsPerLine(7, false));
+	QCOMPARE(line.autoDuration(10, 100, 1000, Primary).toMillis(), 13 * 10 + 3 * 100 + 2 * 1000.);
+	QVERIFY(line.checkEmptySecondaryText(false));
+
+	// edits through the document drop cached stats
+	line.primaryDoc()->setPlainText($("four"));
+	QCOMPARE(line.primaryCharacters(), 4);
+	QCOMPARE(line.primaryLines(), 1);
+	line.primaryDoc()->undo();
+	QCOMPARE(line.primaryCharacters(), 13);
+
+	line.resetSecondaryText(RichString($(" one  two\nthree")));
+	QVERIFY(!line.checkEmptySecondaryText(false));
+	QVERIFY(line.checkUntranslatedText(false));
+}
+
+void
+SubtitleTest::testCheckErrors()
+{
+	using L = SubtitleLine;
+	// primary text, secondary text and flags they produce, checks that depend on configured limits are left out
+	const struct { QString primary; QString secondary; int flags; } pattern[] = {
+		{ QString(), $("text"), L::EmptyPrimaryText },
+		{ $("... Capital"), QString(), L::PrimaryCapitalAfterEllipsis | L::EmptySecondaryText },
+		{ $("- dash"), $("- dash"), L::PrimaryUnneededDash | L::SecondaryUnneededDash | L::UntranslatedText },
+		{ $("spaces ,  here"), $("ok"), L::PrimaryUnneededSpaces | L::OverlapsWithNext },
+		{ $("fine"), $("bien"), 0 },
+	};
+	const int patternSize = sizeof(pattern) / sizeof(*pattern);
+	const int errorFlags = L::EmptyPrimaryText | L::EmptySecondaryText | L::OverlapsWithNext | L::UntranslatedText
+			| L::PrimaryUnneededSpaces | L::SecondaryUnneededSpaces | L::PrimaryUnneededDash | L::SecondaryUnneededDash
+			| L::PrimaryCapitalAfterEllipsis | L::SecondaryCapitalAfterEllipsis;
+
+	QList<SubtitleLine *> lines;
+	for(int n = 0; n < 2000; n++) {
+		const int p = n % patternSize;
+		SubtitleLine *l = new SubtitleLine(n * 1000, n * 1000 + (pattern[p].flags & L::OverlapsWithNext ? 1500 : 500));
+		l->resetPrimaryText(RichString(pattern[p].primary));
+		l->resetSecondaryText(RichString(pattern[p].secondary));
+		lines.append(l);
+	}
+	sub->insertLines(lines);
+
+	const RangeList full(Range::full());
+	QSignalSpy errorSpy(sub.data(), &Subtitle::linesErrorFlagsChanged);
+	sub->checkErrors(full, errorFlags);
+	for(int i = 0; i < sub->count(); i++)
+		QCOMPARE(sub->at(i)->errorFlags(), pattern[i % patternSize].flags);
+
+	// unchanged flags are not notified
+	errorSpy.clear();
+	sub->checkErrors(full, errorFlags);
+	QCOMPARE(errorSpy.count(), 0);
+
+	sub->clearErrors(full, L::OverlapsWithNext);
+	for(int i = 0; i < sub->count(); i++)
+		QCOMPARE(sub->at(i)->errorFlags(), pattern[i % patternSize].flags & ~int(L::OverlapsWithNext));
+
+	// recheck only looks at flags lines already have
+	errorSpy.clear();
+	sub->recheckErrors(full);
+	QCOMPARE(errorSpy.count(), 0);
+
+	// each overlapping line is notified alone
+	sub->checkErrors(full, L::OverlapsWithNext);
+	QCOMPARE(errorSpy.count(), sub->count() / patternSize);
+	for(const QList<QVariant> &args : qAsConst(errorSpy)) {
+		QCOMPARE(args.at(0).toInt() % patternSize, 3);
+		QCOMPARE(args.at(1).toInt(), args.at(0).toInt());
+	}
+	for(int i = 0; i < sub->count(); i++)
+		QCOMPARE(sub->at(i)->errorFlags(), pattern[i % patternSize].flags);
+}
+
+void
+SubtitleTest::testTimeIndex()
+{
+	QList<SubtitleLine *> lines = makeLines(1000);
+	// every fifth line overlaps the next four
+	for(int n = 0; n < lines.size(); n += 5)
+		lines.at(n)->setHideTime(n * 1000 + 4500);
+	sub->insertLines(lines);
+
+	const auto verify = [&](){
+		for(int t = -2000; t < 1002000; t += 12345) {
+			const Time start(t);
+			const Time end(t + (t % 3) * 1000);
+			QVector<SubtitleLine *> expected;
+			for(int i = 0; i < sub->count(); i++) {
+				if(sub->at(i)->intersectsTimespan(start, end))
+					expected.append(sub->at(i));
+			}
+			QCOMPARE(sub->linesIntersecting(start, end), expected);
+		}
+	};
+
+	verify();
+	QCOMPARE(sub->linesAt(Time(10500)).size(), 1);
+	QCOMPARE(sub->linesAt(Time(12500)).size(), 2);
+	QCOMPARE(sub->linesAt(Time(999900)).size(), 0);
+
+	// time changes update index in place
+	sub->at(3)->setHideTime(Time(900000));
+	sub->at(500)->setShowTime(Time(0));
+	verify();
+	QVERIFY(sub->at(3)->checkOverlapsWithNext(false));
+	QVERIFY(sub->at(499)->checkOverlapsWithNext(false));
+
+	sub->removeLines(RangeList(Range(100, 199)), SubtitleTarget::Both);
+	verify();
+
+	// inserted and reordered lines move the following ones, index grows past its capacity
+	sub->insertLine(new SubtitleLine(Time(50500), Time(50700)));
+	verify();
+	sub->insertLines(makeLines(200, 300));
+	QCOMPARE(sub->count(), 1101);
+	verify();
+	sub->sortLines(Range::full());
+	verify();
+
+	// index doesn't depend on signal delivery
+	{
+		const QSignalBlocker blocker(sub.data());
+		sub->removeLines(RangeList(Range(0, 9)), SubtitleTarget::Both);
+		sub->insertLines(makeLines(10, 2000));
+	}
+	verify();
+}
+
 QTEST_MAIN(SubtitleTest);
@@ -20,10 +20,30 @@ public:
 	virtual ~SubtitleTest();
 
 private slots:
+	void init();
+
 	void testSort_data();
 	void testSort();
+	void testInsertLines();
+	void testSortLines();
+	void testLineTimes();
+	void testBulkTimes();
+	void testUndoMemoryUsage();
+	void testTextUndoMemoryUsage();
+	void testDirtyState();
+	void testChangeBatch();
+	void testSnapshot();
+	void testSnapshotWrite();
+	void testJournal();
+	void testLazyDocuments();
+	void testTextStats();
+	void testCheckErrors();
+	void testTimeIndex();
 
 private:
+	static QList<SubtitleComposer::SubtitleLine *> makeLines(int count, int duration = 800);
+	void fillLines(int count, int duration = 800);
+
 	QExplicitlySharedDataPointer<SubtitleComposer::Subtitle> sub;
 };
 